@@ -0,0 +1,115 @@
+//throughput of the accessor kernels (accessors.h) against the scalar reference, on the layouts glTF
+//files actually use. every case also checks that both paths write the same vertices.
+//usage: chapter_5_accessor_bench [elements], defaults to 1M
+#include <accessors.h>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <algorithm>
+
+using namespace accessor;
+
+struct BenchCase{
+    ccharp name;
+    ComponentType type;
+    u32 components;
+    bool normalized;
+    //source element stride, interleaved attributes have more than the element size
+    size_t srcStride;
+    //destination stride, sizeof(Vertex) when written into vertices
+    size_t dstStride;
+};
+
+//best of a few runs, in milliseconds
+template<typename F>
+static float time_ms(u32 runs, F&& fn){
+    float best = 1e30f;
+    for(u32 r = 0; r < runs; ++r){
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e6f);
+    }
+    return best;
+}
+
+static void report(ccharp name, size_t count, size_t srcBytes, float scalarMs, float simdMs, bool match){
+    fmt::println("{:<36} scalar {:7.2f} ms {:7.0f} M/s | simd {:7.2f} ms {:7.0f} M/s {:6.2f} GB/s | x{:.2f}{}",
+        name, scalarMs, count / (scalarMs * 1e3f), simdMs, count / (simdMs * 1e3f), srcBytes / (simdMs * 1e6f),
+        scalarMs / simdMs, match ? "" : "  MISMATCH");
+}
+
+int main(int argc, char* argv[]){
+    size_t count = argc > 1 ? std::max(1, atoi(argv[1])) : 1024 * 1024;
+    constexpr u32 RUNS = 10;
+    constexpr size_t VERTEX_SIZE = 48;
+
+    std::mt19937 rng(7);
+    std::vector<u8> source(count * 64 + 64);
+    for(u8& b : source){
+        b = (u8)rng();
+    }
+    //random bits make nan and inf floats, keep float sources finite
+    std::vector<u8> floats(count * 64 + 64);
+    std::uniform_real_distribution<float> dist(-100.f, 100.f);
+    for(size_t i = 0; i + 4 <= floats.size(); i += 4){
+        float f = dist(rng);
+        memcpy(&floats[i], &f, 4);
+    }
+
+    std::vector<float> scalarOut(count * VERTEX_SIZE / sizeof(float));
+    std::vector<float> simdOut(scalarOut.size());
+
+    BenchCase cases[] = {
+        {"position float3 packed -> vertex", ComponentType::Float, 3, false, 12, VERTEX_SIZE},
+        {"position float3 interleaved 32", ComponentType::Float, 3, false, 32, VERTEX_SIZE},
+        {"position unorm16x3 -> vertex", ComponentType::UnsignedShort, 3, true, 8, VERTEX_SIZE},
+        {"normal snorm8x3 -> vertex", ComponentType::Byte, 3, true, 4, VERTEX_SIZE},
+        {"normal snorm16x3 -> vertex", ComponentType::Short, 3, true, 8, VERTEX_SIZE},
+        {"uv unorm16x2 -> float2", ComponentType::UnsignedShort, 2, true, 4, 8},
+        {"uv unorm8x2 -> float2", ComponentType::UnsignedByte, 2, true, 4, 8},
+        {"color rgba8 -> vertex", ComponentType::UnsignedByte, 4, true, 4, VERTEX_SIZE},
+        {"color rgba8 -> float4", ComponentType::UnsignedByte, 4, true, 4, 16},
+    };
+    fmt::println("{} elements, best of {} runs", count, RUNS);
+    for(const BenchCase& c : cases){
+        View view;
+        view.data = c.type == ComponentType::Float ? floats.data() : source.data();
+        view.stride = c.srcStride;
+        view.count = count;
+        view.componentType = c.type;
+        view.components = c.components;
+        view.normalized = c.normalized;
+
+        std::fill(scalarOut.begin(), scalarOut.end(), 0.f);
+        std::fill(simdOut.begin(), simdOut.end(), 0.f);
+        float scalarMs = time_ms(RUNS, [&](){ scalar::decode_floats(view, scalarOut.data(), c.dstStride); });
+        float simdMs = time_ms(RUNS, [&](){ decode_floats(view, simdOut.data(), c.dstStride); });
+        bool match = memcmp(scalarOut.data(), simdOut.data(), count * c.dstStride) == 0;
+        report(c.name, count, count * c.components * component_size(c.type), scalarMs, simdMs, match);
+    }
+
+    std::vector<u32> scalarIndices(count);
+    std::vector<u32> simdIndices(count);
+    struct IndexCase{
+        ccharp name;
+        ComponentType type;
+    };
+    IndexCase indexCases[] = {
+        {"indices u8 -> u32 + base", ComponentType::UnsignedByte},
+        {"indices u16 -> u32 + base", ComponentType::UnsignedShort},
+        {"indices u32 + base", ComponentType::UnsignedInt},
+    };
+    for(const IndexCase& c : indexCases){
+        View view;
+        view.data = source.data();
+        view.stride = component_size(c.type);
+        view.count = count;
+        view.componentType = c.type;
+        float scalarMs = time_ms(RUNS, [&](){ scalar::decode_indices(view, 1000, scalarIndices.data()); });
+        float simdMs = time_ms(RUNS, [&](){ decode_indices(view, 1000, simdIndices.data()); });
+        bool match = scalarIndices == simdIndices;
+        report(c.name, count, count * view.stride, scalarMs, simdMs, match);
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+//offline cooker: converts a glTF file into the cooked scene format of vk_cooked.h.
+//usage: chapter_5_cooker <scene.gltf|scene.glb> [output], the output defaults to the input path + .cooked
+//which is where loadGltf() looks for it
+#include "gltf_import.h"
+#include "vk_cooked.h"
+#include "ktx2.h"
+#include <tiny_gltf.h>
+#include <thread_pool.h>
+#include <filesystem>
+#include <chrono>
+#include <algorithm>
+
+//copy the converted scene into the writer's flat arrays
+static void cook_scene(cooked::Writer& writer, tinygltf::Model& gltf, EncodedImages& encoded, ThreadPool& pool,
+    const std::filesystem::path& sourceDir, const std::filesystem::path& outputDir){
+    std::vector<ImportedMesh> meshes = convert_meshes(gltf, pool);
+    for(auto& mesh : meshes){
+        cooked::Mesh cookedMesh;
+        cookedMesh.name = writer.add_string(mesh.name);
+        cookedMesh.firstSurface = (u32)writer.surfaces.size();
+        cookedMesh.surfaceCount = (u32)mesh.surfaces.size();
+        cookedMesh.firstVertex = (u32)writer.vertices.size();
+        cookedMesh.vertexCount = (u32)mesh.vertices.size();
+        cookedMesh.firstIndex = (u32)writer.indices.size();
+        cookedMesh.indexCount = (u32)mesh.indices.size();
+        writer.meshes.push_back(cookedMesh);
+
+        for(size_t s = 0; s < mesh.surfaces.size(); ++s){
+            cooked::Surface surface{};
+            surface.startIndex = mesh.surfaces[s].startIndex;
+            surface.count = mesh.surfaces[s].count;
+            surface.bounds = mesh.surfaces[s].bounds;
+            surface.material = mesh.surfaceMaterials[s];
+            surface.lodCount = mesh.surfaces[s].lodCount;
+            for(u32 l = 0; l < MAX_SURFACE_LODS; ++l){
+                surface.lods[l] = mesh.surfaces[s].lods[l];
+            }
+            writer.surfaces.push_back(surface);
+        }
+        writer.vertices.insert(writer.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+        writer.indices.insert(writer.indices.end(), mesh.indices.begin(), mesh.indices.end());
+    }
+
+    //the KHR_texture_basisu source when this build can transcode it, like the runtime picks. recorded so a
+    //runtime that picks the other one parses the source instead
+    if(std::find(gltf.extensionsUsed.begin(), gltf.extensionsUsed.end(), "KHR_texture_basisu") != gltf.extensionsUsed.end()){
+        writer.inputs |= cooked::HAS_BASISU | (ktx2::can_transcode() ? cooked::BASISU_SOURCES : 0);
+    }
+    for(auto& mat : convert_materials(gltf, ktx2::can_transcode())){
+        cooked::Material material;
+        material.name = writer.add_string(mat.name);
+        material.colorFactor = mat.colorFactor;
+        material.metalRoughnessFactor = mat.metalRoughnessFactor;
+        material.passType = (u32)mat.passType;
+        material.colorImage = mat.colorImage;
+        material.colorSampler = mat.colorSampler;
+        writer.materials.push_back(material);
+    }
+
+    for(auto& info : convert_samplers(gltf)){
+        writer.samplers.push_back({(u32)info.magFilter, (u32)info.minFilter, (u32)info.mipmapMode});
+    }
+
+    //image files stay where they are and are only referenced. embedded png/jpeg images are stored decoded,
+    //embedded KTX2 files as they are, the runtime transcodes them for its device
+    encoded.bytes.resize(gltf.images.size());
+    for(size_t i = 0; i < gltf.images.size(); ++i){
+        tinygltf::Image& image = gltf.images[i];
+        std::span<const u8> bytes = encoded.bytes[i];
+        cooked::Texture texture{};
+        texture.name = writer.add_string(image.name);
+        bool external = !image.uri.empty() && image.uri.rfind("data:", 0) != 0;
+        bool ktx = !external && ktx2::is_ktx2(bytes);
+        DecodedImage decoded;
+        if(!external && !ktx){
+            decoded = decode_image(image.name, bytes);
+        }
+        if(external){
+            std::filesystem::path file = sourceDir / image.uri;
+            texture.uri = writer.add_string(std::filesystem::relative(file, outputDir).generic_string());
+        }else if(ktx){
+            texture.uri = writer.add_string("");
+            texture.texelOffset = writer.texels.size();
+            texture.texelSize = bytes.size();
+            writer.texels.insert(writer.texels.end(), bytes.begin(), bytes.end());
+        }else if(!decoded.pixels.empty()){
+            texture.uri = writer.add_string("");
+            texture.width = decoded.width;
+            texture.height = decoded.height;
+            texture.texelOffset = writer.texels.size();
+            texture.texelSize = decoded.pixels.size();
+            writer.texels.insert(writer.texels.end(), decoded.pixels.begin(), decoded.pixels.end());
+        }else{
+            //no uri and no texels, the runtime shows the error texture
+            texture.uri = writer.add_string("");
+            fmt::println("Image {} could not be decoded", image.name);
+        }
+        writer.textures.push_back(texture);
+    }
+
+    for(auto& node : convert_nodes(gltf)){
+        cooked::Node cookedNode;
+        cookedNode.name = writer.add_string(node.name);
+        cookedNode.mesh = node.mesh;
+        cookedNode.firstChild = (u32)writer.children.size();
+        cookedNode.childCount = (u32)node.children.size();
+        cookedNode.localTransform = node.localTransform;
+        writer.children.insert(writer.children.end(), node.children.begin(), node.children.end());
+        writer.nodes.push_back(cookedNode);
+    }
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        fmt::println("usage: {} <scene.gltf|scene.glb> [output]", argv[0]);
+        return 1;
+    }
+    std::filesystem::path input = argv[1];
+    std::filesystem::path output = argc > 2 ? std::filesystem::path(argv[2]) : std::filesystem::path(input.string() + cooked::EXTENSION);
+
+    auto start = std::chrono::system_clock::now();
+    tinygltf::Model gltf;
+    //images are kept encoded, KTX2 ones are stored without decoding
+    EncodedImages encoded;
+    if(!parse_gltf(input.string(), gltf, &encoded)){
+        return 1;
+    }
+
+    ThreadPool pool;
+    pool.init();
+    cooked::Writer writer;
+    std::filesystem::path outputDir = std::filesystem::absolute(output).parent_path();
+    cook_scene(writer, gltf, encoded, pool, std::filesystem::absolute(input).parent_path(), outputDir);
+    if(!writer.write(output.string().c_str())){
+        fmt::println("Failed to write {}", output.string());
+        return 1;
+    }
+    auto end = std::chrono::system_clock::now();
+    fmt::println("{} cooked in {:.2f} ms: {} meshes, {} vertices, {} indices, {} materials, {} textures, {} nodes",
+        output.string(), std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.f,
+        writer.meshes.size(), writer.vertices.size(), writer.indices.size(), writer.materials.size(),
+        writer.textures.size(), writer.nodes.size());
+    return 0;
+}
@@ -0,0 +1,342 @@
+#include "fastgltf_import.h"
+#include <fastgltf/core.hpp>
+#include <fastgltf/types.hpp>
+#include <fastgltf/tools.hpp>
+#include <fastgltf/glm_element_traits.hpp>
+#include <thread_pool.h>
+#include <FileUtils.h>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/ext.hpp>
+#include <iostream>
+#include <cstring>
+
+static VkFilter extract_filter(fastgltf::Filter filter){
+    switch(filter){
+        //nearest samplers
+        case fastgltf::Filter::Nearest:
+        case fastgltf::Filter::NearestMipMapNearest:
+        case fastgltf::Filter::NearestMipMapLinear:
+            return VK_FILTER_NEAREST;
+        //linear samplers
+        case fastgltf::Filter::Linear:
+        case fastgltf::Filter::LinearMipMapNearest:
+        case fastgltf::Filter::LinearMipMapLinear:
+        default:
+            return VK_FILTER_LINEAR;
+    }
+}
+
+static VkSamplerMipmapMode extract_mipmap_mode(fastgltf::Filter filter){
+    switch(filter){
+        case fastgltf::Filter::NearestMipMapNearest:
+        case fastgltf::Filter::LinearMipMapNearest:
+            return VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        case fastgltf::Filter::NearestMipMapLinear:
+        case fastgltf::Filter::LinearMipMapLinear:
+        default:
+            return VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    }
+}
+
+bool parse_gltf(std::string_view filePath, fastgltf::Asset& gltf){
+    std::filesystem::path path = filePath;
+#if FASTGLTF_HAS_MEMORY_MAPPED_FILE
+    //mapped instead of read into a vector, the parser reads the json and the glb chunks straight out of it
+    auto data = fastgltf::MappedGltfFile::FromPath(path);
+#else
+    auto data = fastgltf::GltfDataBuffer::FromPath(path);
+#endif
+    if(data.error() != fastgltf::Error::None){
+        std::cerr << "Failed to open glTF: " << fastgltf::getErrorMessage(data.error()) << std::endl;
+        return false;
+    }
+
+    //quantized attributes go through the same accessor iteration as float ones. KHR_texture_basisu
+    //only fills in Texture::basisuImageIndex, the image is decoded like any other
+    fastgltf::Parser parser(fastgltf::Extensions::KHR_mesh_quantization | fastgltf::Extensions::KHR_texture_basisu);
+    constexpr auto gltfOptions = fastgltf::Options::DontRequireValidAssetMember | fastgltf::Options::LoadExternalBuffers;
+    auto load = parser.loadGltf(data.get(), path.parent_path(), gltfOptions);
+    if(load.error() != fastgltf::Error::None){
+        std::cerr << "Failed to load glTF: " << fastgltf::getErrorMessage(load.error()) << std::endl;
+        return false;
+    }
+    gltf = std::move(load.get());
+    return true;
+}
+
+static std::string to_string(std::string_view name){
+    return std::string(name);
+}
+
+//bytes held in memory by a buffer or image source, empty for uris and anything not loaded
+static std::span<const u8> source_bytes(const fastgltf::DataSource& source){
+    return std::visit([](const auto& s) -> std::span<const u8>{
+        using T = std::decay_t<decltype(s)>;
+        if constexpr(std::is_same_v<T, fastgltf::sources::Array> || std::is_same_v<T, fastgltf::sources::Vector> ||
+            std::is_same_v<T, fastgltf::sources::ByteView>){
+            return {(const u8*)s.bytes.data(), s.bytes.size()};
+        }else{
+            return {};
+        }
+    }, source);
+}
+
+//one primitive and the ranges of its mesh arrays it owns
+struct PrimitiveTask{
+    u32 mesh;
+    u32 primitive;
+    u32 firstVertex;
+    u32 vertexCount;
+    u32 firstIndex;
+};
+
+//fill the vertices, indices and bounds of one primitive, only touches the ranges of its task.
+//fastgltf handles strides, normalized integers and sparse accessors, and copies tightly packed data with memcpy
+static void convert_primitive(const fastgltf::Asset& gltf, ImportedMesh& newmesh, const PrimitiveTask& task){
+    const fastgltf::Primitive& p = gltf.meshes[task.mesh].primitives[task.primitive];
+    GeoSurface& newSurface = newmesh.surfaces[task.primitive];
+    u32 initial_vtx = task.firstVertex;
+    Vertex* vertices = newmesh.vertices.data() + task.firstVertex;
+    u32* indices = newmesh.indices.data() + task.firstIndex;
+
+    //load indexes
+    if(p.indicesAccessor.has_value()){
+        const fastgltf::Accessor& accessor = gltf.accessors[p.indicesAccessor.value()];
+        fastgltf::copyFromAccessor<u32>(gltf, accessor, indices);
+        for(size_t i = 0; i < accessor.count; ++i){
+            indices[i] += initial_vtx;
+        }
+    }else{
+        //not indexed, every vertex once
+        for(u32 i = 0; i < task.vertexCount; ++i){
+            indices[i] = initial_vtx + i;
+        }
+    }
+    //load vertex positions
+    {
+        const fastgltf::Accessor& accessor = gltf.accessors[p.findAttribute("POSITION")->accessorIndex];
+        fastgltf::iterateAccessorWithIndex<vec3>(gltf, accessor, [&](vec3 v, size_t i){
+            Vertex vtx{};
+            vtx.position = v;
+            vtx.normal = vec3(1.f, 0.f, 0.f);
+            vtx.color = vec4(1.f);
+            vertices[i] = vtx;
+        });
+    }
+    //the attributes below may be longer than POSITION, whatever is past the primitive's slice belongs
+    //to the next primitive and another task, so it is skipped like decode_attribute does
+    //load vtx normals
+    {
+        auto attr = p.findAttribute("NORMAL");
+        if(attr != p.attributes.end()){
+            fastgltf::iterateAccessorWithIndex<vec3>(gltf, gltf.accessors[attr->accessorIndex], [&](vec3 v, size_t i){
+                if(i >= task.vertexCount){
+                    return;
+                }
+                vertices[i].normal = v;
+            });
+        }
+    }
+    //load UVs
+    {
+        auto attr = p.findAttribute("TEXCOORD_0");
+        if(attr != p.attributes.end()){
+            fastgltf::iterateAccessorWithIndex<vec2>(gltf, gltf.accessors[attr->accessorIndex], [&](vec2 uv, size_t i){
+                if(i >= task.vertexCount){
+                    return;
+                }
+                vertices[i].uv_x = uv.x;
+                vertices[i].uv_y = uv.y;
+            });
+        }
+    }
+    //load vertex colors, vec3 colors get an opaque alpha
+    {
+        auto attr = p.findAttribute("COLOR_0");
+        if(attr != p.attributes.end()){
+            const fastgltf::Accessor& accessor = gltf.accessors[attr->accessorIndex];
+            if(accessor.type == fastgltf::AccessorType::Vec3){
+                fastgltf::iterateAccessorWithIndex<vec3>(gltf, accessor, [&](vec3 c, size_t i){
+                    if(i >= task.vertexCount){
+                        return;
+                    }
+                    vertices[i].color = vec4(c, 1.f);
+                });
+            }else{
+                fastgltf::iterateAccessorWithIndex<vec4>(gltf, accessor, [&](vec4 c, size_t i){
+                    if(i >= task.vertexCount){
+                        return;
+                    }
+                    vertices[i].color = c;
+                });
+            }
+        }
+    }
+
+    if(task.vertexCount == 0){
+        newSurface.bounds = {};
+        return;
+    }
+    //loop the vertices of this surface, find min/max bounds
+    vec3 minpos = vertices[0].position;
+    vec3 maxpos = vertices[0].position;
+    for(u32 i=0; i < task.vertexCount; ++i){
+        minpos = glm::min(minpos, vertices[i].position);
+        maxpos = glm::max(maxpos, vertices[i].position);
+    }
+    //calculate origin and extents from the min/max, use extent length for radius
+    newSurface.bounds.origin = (maxpos + minpos) * 0.5f;
+    newSurface.bounds.extents = (maxpos - minpos) * 0.5f;
+    newSurface.bounds.sphereRadius = glm::length(newSurface.bounds.extents);
+}
+
+std::vector<ImportedMesh> convert_meshes(const fastgltf::Asset& gltf, ThreadPool& pool, const MeshOptimizeOptions& options){
+    std::vector<ImportedMesh> imported(gltf.meshes.size());
+
+    //prefix sum over the accessor counts, every primitive gets its own slice of the mesh arrays
+    std::vector<PrimitiveTask> tasks;
+    for(u32 m = 0; m < (u32)gltf.meshes.size(); ++m){
+        const fastgltf::Mesh& mesh = gltf.meshes[m];
+        ImportedMesh& newmesh = imported[m];
+        newmesh.name = to_string(mesh.name);
+
+        u32 vertexCount = 0;
+        u32 indexCount = 0;
+        for(u32 i = 0; i < (u32)mesh.primitives.size(); ++i){
+            const fastgltf::Primitive& p = mesh.primitives[i];
+            PrimitiveTask task;
+            task.mesh = m;
+            task.primitive = i;
+            task.firstVertex = vertexCount;
+            task.vertexCount = (u32)gltf.accessors[p.findAttribute("POSITION")->accessorIndex].count;
+            task.firstIndex = indexCount;
+            tasks.push_back(task);
+
+            GeoSurface newSurface;
+            newSurface.startIndex = indexCount;
+            newSurface.count = p.indicesAccessor.has_value() ? (u32)gltf.accessors[p.indicesAccessor.value()].count : task.vertexCount;
+            newmesh.surfaces.push_back(newSurface);
+            newmesh.surfaceMaterials.push_back(p.materialIndex.has_value() ? (i32)p.materialIndex.value() : -1);
+
+            vertexCount += task.vertexCount;
+            indexCount += newSurface.count;
+        }
+        //every element gets written by exactly one task
+        newmesh.vertices.resize(vertexCount);
+        newmesh.indices.resize(indexCount);
+    }
+
+    pool.parallel_for((u32)tasks.size(), [&](u32 t){
+        const PrimitiveTask& task = tasks[t];
+        convert_primitive(gltf, imported[task.mesh], task);
+    });
+    optimize_meshes(imported, pool, options);
+    return imported;
+}
+
+std::vector<ImportedMaterial> convert_materials(const fastgltf::Asset& gltf, bool basisu){
+    std::vector<ImportedMaterial> imported;
+    imported.reserve(gltf.materials.size());
+    for(const fastgltf::Material& mat : gltf.materials){
+        ImportedMaterial& newMat = imported.emplace_back();
+        newMat.name = to_string(mat.name);
+        newMat.colorFactor = vec4(mat.pbrData.baseColorFactor[0], mat.pbrData.baseColorFactor[1],
+            mat.pbrData.baseColorFactor[2], mat.pbrData.baseColorFactor[3]);
+        newMat.metalRoughnessFactor = vec4(0.f);
+        newMat.metalRoughnessFactor.x = mat.pbrData.metallicFactor;
+        newMat.metalRoughnessFactor.y = mat.pbrData.roughnessFactor;
+
+        newMat.passType = MaterialPass::MainColor;
+        if(mat.alphaMode == fastgltf::AlphaMode::Blend){
+            newMat.passType = MaterialPass::Transparent;
+        }
+
+        //grab textures from gltf file
+        newMat.colorImage = -1;
+        newMat.colorSampler = -1;
+        if(mat.pbrData.baseColorTexture.has_value()){
+            const fastgltf::Texture& texture = gltf.textures[mat.pbrData.baseColorTexture.value().textureIndex];
+            if(basisu && texture.basisuImageIndex.has_value()){
+                newMat.colorImage = (i32)texture.basisuImageIndex.value();
+            }else{
+                newMat.colorImage = texture.imageIndex.has_value() ? (i32)texture.imageIndex.value() : -1;
+            }
+            newMat.colorSampler = texture.samplerIndex.has_value() ? (i32)texture.samplerIndex.value() : -1;
+        }
+    }
+    return imported;
+}
+
+std::vector<ImportedNode> convert_nodes(const fastgltf::Asset& gltf){
+    std::vector<ImportedNode> imported;
+    imported.reserve(gltf.nodes.size());
+    for(const fastgltf::Node& node : gltf.nodes){
+        ImportedNode& newNode = imported.emplace_back();
+        newNode.name = to_string(node.name);
+        newNode.mesh = node.meshIndex.has_value() ? (i32)node.meshIndex.value() : -1;
+        for(size_t c : node.children){
+            newNode.children.push_back((u32)c);
+        }
+
+        std::visit(fastgltf::visitor{
+            [&](const fastgltf::math::fmat4x4& matrix){
+                memcpy(&newNode.localTransform, matrix.data(), sizeof(matrix));
+            },
+            [&](const fastgltf::TRS& transform){
+                vec3 tl(transform.translation[0], transform.translation[1], transform.translation[2]);
+                quat rot(transform.rotation[3], transform.rotation[0], transform.rotation[1], transform.rotation[2]);
+                vec3 sc(transform.scale[0], transform.scale[1], transform.scale[2]);
+
+                mat4 tm = glm::translate(mat4(1.f), tl);
+                mat4 rm = mat4(rot);
+                mat4 sm = glm::scale(mat4(1.f), sc);
+                newNode.localTransform = tm * rm * sm;
+            }
+        }, node.transform);
+    }
+    return imported;
+}
+
+std::vector<VkSamplerCreateInfo> convert_samplers(const fastgltf::Asset& gltf){
+    std::vector<VkSamplerCreateInfo> imported;
+    imported.reserve(gltf.samplers.size());
+    for(const fastgltf::Sampler& sampler : gltf.samplers){
+        VkSamplerCreateInfo sampl{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+        sampl.maxLod = VK_LOD_CLAMP_NONE;
+        sampl.minLod = 0;
+        //missing filters are linear, like the tinygltf backend
+        sampl.magFilter = extract_filter(sampler.magFilter.value_or(fastgltf::Filter::Linear));
+        sampl.minFilter = extract_filter(sampler.minFilter.value_or(fastgltf::Filter::Linear));
+        sampl.mipmapMode = extract_mipmap_mode(sampler.minFilter.value_or(fastgltf::Filter::Linear));
+        imported.push_back(sampl);
+    }
+    return imported;
+}
+
+std::vector<DecodedImage> decode_images(const fastgltf::Asset& gltf, const std::filesystem::path& directory, ThreadPool& pool, VkFormat basisTarget){
+    std::vector<DecodedImage> decoded(gltf.images.size());
+    pool.parallel_for((u32)gltf.images.size(), [&](u32 i){
+        const fastgltf::Image& image = gltf.images[i];
+
+        //encoded bytes, straight out of the buffer for glb and embedded images
+        std::span<const u8> bytes;
+        MappedFile file;
+        if(auto view = std::get_if<fastgltf::sources::BufferView>(&image.data)){
+            const fastgltf::BufferView& bufferView = gltf.bufferViews[view->bufferViewIndex];
+            std::span<const u8> buffer = source_bytes(gltf.buffers[bufferView.bufferIndex].data);
+            if(bufferView.byteOffset + bufferView.byteLength <= buffer.size()){
+                bytes = buffer.subspan(bufferView.byteOffset, bufferView.byteLength);
+            }
+        }else if(auto uri = std::get_if<fastgltf::sources::URI>(&image.data)){
+            std::string path = (directory / uri->uri.fspath()).string();
+            if(uri->uri.isLocalPath() && file.open(path.c_str()) && file.size() > uri->fileByteOffset){
+                bytes = std::span<const u8>(file.data(), file.size()).subspan(uri->fileByteOffset);
+            }
+        }else{
+            //data uris are already decoded into the image by the parser
+            bytes = source_bytes(image.data);
+        }
+        decoded[i] = decode_image(to_string(image.name), bytes, basisTarget);
+    });
+    return decoded;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <vk_types.h>
+#include "gltf_import.h"
+#include <filesystem>
+
+//fastgltf backend of the cpu only glTF conversion, produces the same arrays as the tinygltf one in
+//gltf_import.h. the file is memory mapped and images are left encoded until decode_images
+
+namespace fastgltf{
+class Asset;
+}
+
+//parse the file, external buffers are loaded but images are not decoded
+bool parse_gltf(std::string_view filePath, fastgltf::Asset& gltf);
+
+std::vector<ImportedMesh> convert_meshes(const fastgltf::Asset& gltf, ThreadPool& pool, const MeshOptimizeOptions& options = {});
+std::vector<ImportedMaterial> convert_materials(const fastgltf::Asset& gltf, bool basisu = false);
+std::vector<ImportedNode> convert_nodes(const fastgltf::Asset& gltf);
+std::vector<VkSamplerCreateInfo> convert_samplers(const fastgltf::Asset& gltf);
+//decode every image with decode_image, one image per task. directory resolves relative uris
+std::vector<DecodedImage> decode_images(const fastgltf::Asset& gltf, const std::filesystem::path& directory, ThreadPool& pool,
+    VkFormat basisTarget = VK_FORMAT_R8G8B8A8_UNORM);
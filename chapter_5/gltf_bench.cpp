@@ -0,0 +1,154 @@
+//compares parse-and-convert time of the glTF backends on the same files, cpu only. tinygltf runs twice,
+//decoding images while parsing and decoding them on the pool during the conversion
+//usage: chapter_5_gltf_bench [--runs N] [--optimize] [files...], the files default to ../assets/*.glb.
+//mesh optimization and lods are shared by both backends and left out unless --optimize is given
+#include "gltf_import.h"
+#include "fastgltf_import.h"
+#include <tiny_gltf.h>
+#include <fastgltf/core.hpp>
+#include <thread_pool.h>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+
+//milliseconds of each phase of one run
+struct BenchRun{
+    float parse{0.f};
+    float images{0.f};
+    float convert{0.f};
+    float total() const { return parse + images + convert; }
+};
+
+static float elapsed_ms(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end){
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.f;
+}
+
+//tinygltf decoding every image while parsing, that time ends up in parse
+static bool run_tinygltf(const std::filesystem::path& file, ThreadPool& pool, const MeshOptimizeOptions& options, BenchRun& run){
+    auto start = std::chrono::steady_clock::now();
+    tinygltf::Model gltf;
+    if(!parse_gltf(file.string(), gltf)){
+        return false;
+    }
+    auto parsed = std::chrono::steady_clock::now();
+    std::vector<ImportedMesh> meshes = convert_meshes(gltf, pool, options);
+    std::vector<ImportedMaterial> materials = convert_materials(gltf);
+    std::vector<ImportedNode> nodes = convert_nodes(gltf);
+    std::vector<VkSamplerCreateInfo> samplers = convert_samplers(gltf);
+    auto converted = std::chrono::steady_clock::now();
+    run.parse = elapsed_ms(start, parsed);
+    run.convert = elapsed_ms(parsed, converted);
+    return true;
+}
+
+//tinygltf with the images left encoded and decoded on the pool alongside the conversion. images is
+//the wait for the decodes still running once everything else is converted
+static bool run_tinygltf_pool(const std::filesystem::path& file, ThreadPool& pool, const MeshOptimizeOptions& options, BenchRun& run){
+    auto start = std::chrono::steady_clock::now();
+    tinygltf::Model gltf;
+    EncodedImages encoded;
+    if(!parse_gltf(file.string(), gltf, &encoded)){
+        return false;
+    }
+    auto parsed = std::chrono::steady_clock::now();
+    std::vector<DecodedImage> images(gltf.images.size());
+    AsyncImageDecode decode;
+    decode.start(pool, gltf, std::move(encoded), [&images](u32 i, DecodedImage&& image){ images[i] = std::move(image); });
+    std::vector<ImportedMesh> meshes = convert_meshes(gltf, pool, options);
+    std::vector<ImportedMaterial> materials = convert_materials(gltf);
+    std::vector<ImportedNode> nodes = convert_nodes(gltf);
+    std::vector<VkSamplerCreateInfo> samplers = convert_samplers(gltf);
+    auto converted = std::chrono::steady_clock::now();
+    decode.finish();
+    auto decoded = std::chrono::steady_clock::now();
+    run.parse = elapsed_ms(start, parsed);
+    run.convert = elapsed_ms(parsed, converted);
+    run.images = elapsed_ms(converted, decoded);
+    return true;
+}
+
+static bool run_fastgltf(const std::filesystem::path& file, ThreadPool& pool, const MeshOptimizeOptions& options, BenchRun& run){
+    auto start = std::chrono::steady_clock::now();
+    fastgltf::Asset gltf;
+    if(!parse_gltf(file.string(), gltf)){
+        return false;
+    }
+    auto parsed = std::chrono::steady_clock::now();
+    std::vector<DecodedImage> images = decode_images(gltf, file.parent_path(), pool);
+    auto decoded = std::chrono::steady_clock::now();
+    std::vector<ImportedMesh> meshes = convert_meshes(gltf, pool, options);
+    std::vector<ImportedMaterial> materials = convert_materials(gltf);
+    std::vector<ImportedNode> nodes = convert_nodes(gltf);
+    std::vector<VkSamplerCreateInfo> samplers = convert_samplers(gltf);
+    auto converted = std::chrono::steady_clock::now();
+    run.parse = elapsed_ms(start, parsed);
+    run.images = elapsed_ms(parsed, decoded);
+    run.convert = elapsed_ms(decoded, converted);
+    return true;
+}
+
+//median by total of the runs, the first one warms the file cache and is dropped
+static void report(ccharp backend, std::vector<BenchRun>& runs){
+    if(runs.size() > 1){
+        runs.erase(runs.begin());
+    }
+    std::sort(runs.begin(), runs.end(), [](const BenchRun& a, const BenchRun& b){ return a.total() < b.total(); });
+    const BenchRun& median = runs[runs.size() / 2];
+    fmt::println("  {:<9} total {:8.2f} ms (min {:8.2f})  parse {:8.2f}  images {:8.2f}  convert {:8.2f}",
+        backend, median.total(), runs.front().total(), median.parse, median.images, median.convert);
+}
+
+int main(int argc, char* argv[]){
+    u32 runCount = 5;
+    MeshOptimizeOptions options;
+    options.enabled = false;
+    options.lodCount = 0;
+    std::vector<std::filesystem::path> files;
+    for(int i = 1; i < argc; ++i){
+        std::string_view arg = argv[i];
+        if(arg == "--runs" && i + 1 < argc){
+            runCount = std::max(1, atoi(argv[++i]));
+        }else if(arg == "--optimize"){
+            options = {};
+        }else{
+            files.push_back(arg);
+        }
+    }
+    if(files.empty()){
+        std::error_code ec;
+        for(auto& entry : std::filesystem::directory_iterator("../assets", ec)){
+            if(entry.path().extension() == ".glb"){
+                files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+    }
+    if(files.empty()){
+        fmt::println("usage: {} [--runs N] [--optimize] [files...], no .glb files in ../assets", argv[0]);
+        return 1;
+    }
+
+    ThreadPool pool;
+    pool.init();
+    fmt::println("{} runs per backend, median of the runs after the first, {} threads", runCount + 1, pool.size() + 1);
+    for(auto& file : files){
+        fmt::println("{} ({:.2f} MB)", file.string(), std::filesystem::file_size(file) / (1024.f * 1024.f));
+        std::vector<BenchRun> tinyRuns(runCount + 1);
+        std::vector<BenchRun> tinyPoolRuns(runCount + 1);
+        std::vector<BenchRun> fastRuns(runCount + 1);
+        bool ok = true;
+        //interleaved so both backends see the same cache and clock state
+        for(u32 r = 0; r <= runCount && ok; ++r){
+            ok = run_tinygltf(file, pool, options, tinyRuns[r]) && run_tinygltf_pool(file, pool, options, tinyPoolRuns[r]) &&
+                run_fastgltf(file, pool, options, fastRuns[r]);
+        }
+        if(!ok){
+            fmt::println("  failed to load");
+            continue;
+        }
+        report("tinygltf", tinyRuns);
+        report("tiny+pool", tinyPoolRuns);
+        report("fastgltf", fastRuns);
+    }
+    return 0;
+}
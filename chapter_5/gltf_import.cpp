@@ -0,0 +1,571 @@
+#include "gltf_import.h"
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/ext.hpp>
+#include <tiny_gltf.h>
+#include <stb_image.h>
+#include <thread_pool.h>
+#include <meshes.h>
+#include <accessors.h>
+#include "ktx2.h"
+
+VkFilter extract_filter(int filter){
+    switch(filter){
+        case TINYGLTF_TEXTURE_FILTER_NEAREST:
+        case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_LINEAR:
+        case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_NEAREST:
+            return VK_FILTER_NEAREST;
+        case TINYGLTF_TEXTURE_FILTER_LINEAR:
+        case TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_LINEAR:
+        case TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_NEAREST:
+        default:
+            return VK_FILTER_LINEAR;
+
+    }
+    return VK_FILTER_MAX_ENUM;
+}
+VkSamplerMipmapMode extract_mipmap_mode(int filter){
+    switch(filter){
+        case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_LINEAR:
+        case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_NEAREST:
+            return VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        case TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_LINEAR:
+        case TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_NEAREST:
+        default:
+            return VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    }
+    return VK_SAMPLER_MIPMAP_MODE_MAX_ENUM;
+}
+
+//tinygltf image loader that keeps the encoded bytes for AsyncImageDecode instead of decoding them
+static bool keep_encoded_image(tinygltf::Image* image, const int index, std::string* err, std::string* warn,
+    int reqWidth, int reqHeight, const unsigned char* bytes, int size, void* user){
+    EncodedImages& encoded = *(EncodedImages*)user;
+    if((size_t)index >= encoded.bytes.size()){
+        encoded.bytes.resize(index + 1);
+    }
+    //uri images are read into a temporary buffer, so the bytes have to be copied
+    encoded.bytes[index].assign(bytes, bytes + size);
+    return true;
+}
+
+//tinygltf image loader for everything stb can read. KTX2 images are left empty instead of failing the
+//whole file, the png/jpeg fallback of KHR_texture_basisu still loads
+static bool load_image_skip_ktx2(tinygltf::Image* image, const int index, std::string* err, std::string* warn,
+    int reqWidth, int reqHeight, const unsigned char* bytes, int size, void* user){
+    if(ktx2::is_ktx2(std::span<const u8>(bytes, size))){
+        return true;
+    }
+    return tinygltf::LoadImageData(image, index, err, warn, reqWidth, reqHeight, bytes, size, user);
+}
+
+bool parse_gltf(std::string_view filePath, tinygltf::Model& gltf, EncodedImages* encoded){
+    tinygltf::TinyGLTF loader;
+    std::string err;
+    std::string warn;
+    if(encoded){
+        loader.SetImageLoader(keep_encoded_image, encoded);
+    }else{
+        loader.SetImageLoader(load_image_skip_ktx2, nullptr);
+    }
+
+    std::filesystem::path path = filePath;
+
+    bool res=false;
+
+    auto ext = path.extension();
+    
+    std::string pathstr = path.string();
+    ccharp pathtoload = pathstr.c_str();
+    if(ext == ".glb")
+        res = loader.LoadBinaryFromFile(&gltf, &err, &warn, pathtoload);
+    else
+        res = loader.LoadASCIIFromFile(&gltf, &err, &warn, pathtoload);
+    if(!res){
+        std::cerr << "Failed to load glTF: " << warn << ", " << err << std::endl;
+    }
+    if(encoded){
+        encoded->bytes.resize(gltf.images.size());
+    }
+    return res;
+}
+
+//png/jpeg texels are sampled as unorm, srgb KTX2 files are uploaded the same way so both look alike
+static VkFormat unorm_format(VkFormat format){
+    switch(format){
+        case VK_FORMAT_R8G8B8A8_SRGB: return VK_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_B8G8R8A8_SRGB: return VK_FORMAT_B8G8R8A8_UNORM;
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case VK_FORMAT_BC3_SRGB_BLOCK: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case VK_FORMAT_BC7_SRGB_BLOCK: return VK_FORMAT_BC7_UNORM_BLOCK;
+        default: return format;
+    }
+}
+
+//every level of a KTX2 file, transcoded when it is basis universal. leaves decoded empty on failure
+static void decode_ktx2(std::span<const u8> bytes, VkFormat basisTarget, DecodedImage& decoded){
+    ktx2::Texture texture;
+    std::string error;
+    std::vector<std::vector<u8>> levels;
+    bool ok = ktx2::parse(bytes, texture, error);
+    if(ok && texture.basis){
+        ok = ktx2::transcode(bytes, basisTarget, decoded.width, decoded.height, levels, error);
+        decoded.format = basisTarget;
+    }else if(ok){
+        decoded.width = texture.width;
+        decoded.height = texture.height;
+        decoded.format = unorm_format(texture.format);
+        for(std::span<const u8> level : texture.levels){
+            levels.emplace_back(level.begin(), level.end());
+        }
+    }
+    if(!ok){
+        fmt::println("KTX2 image {}: {}", decoded.name, error);
+        decoded.width = decoded.height = 0;
+        return;
+    }
+    decoded.pixels = std::move(levels[0]);
+    decoded.mips.assign(std::make_move_iterator(levels.begin() + 1), std::make_move_iterator(levels.end()));
+}
+
+DecodedImage decode_image(std::string name, std::span<const u8> bytes, VkFormat basisTarget){
+    DecodedImage decoded;
+    decoded.name = std::move(name);
+    if(bytes.empty()){
+        return decoded;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if(ktx2::is_ktx2(bytes)){
+        decode_ktx2(bytes, basisTarget, decoded);
+        decoded.decodeMs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.f;
+        return decoded;
+    }
+    int width, height, channels;
+    stbi_uc* data = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &width, &height, &channels, 4);
+    if(data != nullptr){
+        decoded.pixels.assign(data, data + (size_t)width * height * 4);
+        decoded.width = (u32)width;
+        decoded.height = (u32)height;
+        stbi_image_free(data);
+    }
+    decoded.decodeMs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.f;
+    return decoded;
+}
+
+struct AsyncImageDecode::State{
+    std::vector<std::string> names;
+    std::vector<std::vector<u8>> bytes;
+    std::function<void(u32, DecodedImage&&)> done;
+    VkFormat basisTarget;
+    std::unique_ptr<std::atomic<bool>[]> claimed;
+    std::atomic<u32> finished{0};
+    std::atomic<u64> decodeUs{0};
+    std::mutex mutex;
+    std::condition_variable allDone;
+
+    //decode image i unless another thread already claimed it
+    void run(u32 i){
+        if(claimed[i].exchange(true)){
+            return;
+        }
+        DecodedImage image = decode_image(std::move(names[i]), bytes[i], basisTarget);
+        bytes[i] = {};
+        decodeUs += (u64)(image.decodeMs * 1000.f);
+        done(i, std::move(image));
+        if(finished.fetch_add(1) + 1 == names.size()){
+            std::lock_guard<std::mutex> lock(mutex);
+            allDone.notify_all();
+        }
+    }
+};
+
+void AsyncImageDecode::start(ThreadPool& pool, const tinygltf::Model& gltf, EncodedImages&& encoded, std::function<void(u32, DecodedImage&&)> done,
+    VkFormat basisTarget){
+    _state = std::make_shared<State>();
+    for(const tinygltf::Image& image : gltf.images){
+        _state->names.push_back(image.name);
+    }
+    _state->bytes = std::move(encoded.bytes);
+    _state->bytes.resize(_state->names.size());
+    _state->done = std::move(done);
+    _state->basisTarget = basisTarget;
+    _state->claimed = std::make_unique<std::atomic<bool>[]>(_state->names.size());
+    //queued before anything else the caller puts on the pool, so the workers start on them first
+    for(u32 i = 0; i < _state->names.size(); ++i){
+        pool.push([state = _state, i](){ state->run(i); });
+    }
+}
+
+float AsyncImageDecode::finish(){
+    if(!_state){
+        return 0.f;
+    }
+    for(u32 i = 0; i < _state->names.size(); ++i){
+        _state->run(i);
+    }
+    {
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        _state->allDone.wait(lock, [&](){ return _state->finished.load() == _state->names.size(); });
+    }
+    float decodeMs = _state->decodeUs.load() / 1000.f;
+    _state.reset();
+    return decodeMs;
+}
+
+//one primitive and the ranges of its mesh arrays it owns
+struct PrimitiveTask{
+    u32 mesh;
+    u32 primitive;
+    u32 firstVertex;
+    u32 vertexCount;
+    u32 firstIndex;
+};
+
+//where the elements of an accessor live, null data for accessors without a buffer view
+static accessor::View accessor_view(const tinygltf::Model& gltf, const tinygltf::Accessor& acc){
+    accessor::View view;
+    view.count = acc.count;
+    view.componentType = (accessor::ComponentType)acc.componentType;
+    view.components = (u32)tinygltf::GetNumComponentsInType(acc.type);
+    view.normalized = acc.normalized;
+    view.stride = view.components * accessor::component_size(view.componentType);
+    if(acc.bufferView >= 0){
+        const tinygltf::BufferView& bufferView = gltf.bufferViews[acc.bufferView];
+        view.data = gltf.buffers[bufferView.buffer].data.data() + (acc.byteOffset + bufferView.byteOffset);
+        view.stride = acc.ByteStride(bufferView);
+    }
+    return view;
+}
+
+//decode components [first, first + count) of the first vertexCount elements to dst, dst + dstStride bytes, ...
+//sparse accessors get their substituted elements written on top of the dense values
+static void decode_attribute(const tinygltf::Model& gltf, const tinygltf::Accessor& acc, u32 vertexCount, u32 first, u32 count, float* dst, size_t dstStride){
+    accessor::View view = accessor_view(gltf, acc);
+    view.count = std::min(view.count, (size_t)vertexCount);
+    accessor::decode_floats(view.subrange(first, count), dst, dstStride);
+    if(!acc.sparse.isSparse || acc.sparse.count <= 0){
+        return;
+    }
+    const tinygltf::BufferView& indexView = gltf.bufferViews[acc.sparse.indices.bufferView];
+    accessor::View sparseIndices;
+    sparseIndices.data = gltf.buffers[indexView.buffer].data.data() + (indexView.byteOffset + acc.sparse.indices.byteOffset);
+    sparseIndices.count = acc.sparse.count;
+    sparseIndices.componentType = (accessor::ComponentType)acc.sparse.indices.componentType;
+    sparseIndices.stride = accessor::component_size(sparseIndices.componentType);
+
+    const tinygltf::BufferView& valueView = gltf.bufferViews[acc.sparse.values.bufferView];
+    accessor::View sparseValues = view;
+    sparseValues.data = gltf.buffers[valueView.buffer].data.data() + (valueView.byteOffset + acc.sparse.values.byteOffset);
+    sparseValues.count = acc.sparse.count;
+    sparseValues.stride = view.components * accessor::component_size(view.componentType);
+
+    std::vector<u32> indices(sparseValues.count);
+    std::vector<float> values(sparseValues.count * count);
+    accessor::decode_indices(sparseIndices, 0, indices.data());
+    accessor::decode_floats(sparseValues.subrange(first, count), values.data(), count * sizeof(float));
+    for(size_t i = 0; i < indices.size(); ++i){
+        if(indices[i] < view.count){
+            memcpy((u8*)dst + indices[i] * dstStride, &values[i * count], count * sizeof(float));
+        }
+    }
+}
+
+//fill the vertices, indices and bounds of one primitive, only touches the ranges of its task
+static void convert_primitive(const tinygltf::Model& gltf, ImportedMesh& newmesh, const PrimitiveTask& task){
+    const tinygltf::Primitive& p = gltf.meshes[task.mesh].primitives[task.primitive];
+    GeoSurface& newSurface = newmesh.surfaces[task.primitive];
+    u32 initial_vtx = task.firstVertex;
+    Vertex* vertices = newmesh.vertices.data() + task.firstVertex;
+    u32* indices = newmesh.indices.data() + task.firstIndex;
+
+    //load indexes
+    if(p.indices >= 0){
+        accessor::decode_indices(accessor_view(gltf, gltf.accessors[p.indices]), initial_vtx, indices);
+    }else{
+        //not indexed, every vertex once
+        for(u32 i = 0; i < task.vertexCount; ++i){
+            indices[i] = initial_vtx + i;
+        }
+    }
+    //defaults for the attributes the primitive doesn't have
+    for(u32 i=0; i < task.vertexCount; i++){
+        Vertex vtx{};
+        vtx.normal = vec3(1.f, 0.f, 0.f);
+        vtx.color = vec4(1.f);
+        vertices[i] = vtx;
+    }
+    //every attribute is decoded straight into the interleaved vertices
+    //load vertex positions
+    decode_attribute(gltf, gltf.accessors[p.attributes.at("POSITION")], task.vertexCount, 0, 3, &vertices[0].position.x, sizeof(Vertex));
+    //load vtx normals
+    {
+        auto attr = p.attributes.find("NORMAL");
+        if(attr != p.attributes.end()){
+            decode_attribute(gltf, gltf.accessors[attr->second], task.vertexCount, 0, 3, &vertices[0].normal.x, sizeof(Vertex));
+        }
+    }
+    //load UVs, u and v are not next to each other in Vertex
+    {
+        auto attr = p.attributes.find("TEXCOORD_0");
+        if(attr != p.attributes.end()){
+            decode_attribute(gltf, gltf.accessors[attr->second], task.vertexCount, 0, 1, &vertices[0].uv_x, sizeof(Vertex));
+            decode_attribute(gltf, gltf.accessors[attr->second], task.vertexCount, 1, 1, &vertices[0].uv_y, sizeof(Vertex));
+        }
+    }
+    //load vertex colors, vec3 colors keep the opaque alpha
+    {
+        auto attr = p.attributes.find("COLOR_0");
+        if(attr != p.attributes.end()){
+            const tinygltf::Accessor& acc = gltf.accessors[attr->second];
+            decode_attribute(gltf, acc, task.vertexCount, 0, (u32)tinygltf::GetNumComponentsInType(acc.type), &vertices[0].color.x, sizeof(Vertex));
+        }
+    }
+
+    if(task.vertexCount == 0){
+        newSurface.bounds = {};
+        return;
+    }
+    //loop the vertices of this surface, find min/max bounds
+    vec3 minpos = vertices[0].position;
+    vec3 maxpos = vertices[0].position;
+    for(u32 i=0; i < task.vertexCount; ++i){
+        minpos = glm::min(minpos, vertices[i].position);
+        maxpos = glm::max(maxpos, vertices[i].position);
+    }
+    //calculate origin and extents from the min/max, use extent length for radius
+    newSurface.bounds.origin = (maxpos + minpos) * 0.5f;
+    newSurface.bounds.extents = (maxpos - minpos) * 0.5f;
+    newSurface.bounds.sphereRadius = glm::length(newSurface.bounds.extents);
+}
+
+//remove duplicate vertices, reorder every surface for the cache and overdraw, then the vertices for fetch.
+//surfaces keep their index ranges, the indices of a surface are only shuffled among themselves
+static void optimize_mesh(ImportedMesh& mesh, const MeshOptimizeOptions& options, VertexCacheStats& before, VertexCacheStats& after){
+    std::span<u32> indices = mesh.indices;
+    for(const GeoSurface& surface : mesh.surfaces){
+        before += analyze_vertex_cache(indices.subspan(surface.startIndex, surface.count), options.cacheSize);
+    }
+    deduplicate_vertices(mesh.vertices, indices);
+    for(const GeoSurface& surface : mesh.surfaces){
+        std::span<u32> surfaceIndices = indices.subspan(surface.startIndex, surface.count);
+        optimize_vertex_cache(surfaceIndices, options.cacheSize);
+        if(options.overdraw){
+            optimize_overdraw(surfaceIndices, mesh.vertices, surface.bounds.origin, options.cacheSize, options.overdrawThreshold);
+        }
+    }
+    optimize_vertex_fetch(mesh.vertices, indices);
+    for(const GeoSurface& surface : mesh.surfaces){
+        after += analyze_vertex_cache(indices.subspan(surface.startIndex, surface.count), options.cacheSize);
+    }
+}
+
+//simplify every surface level by level and append the levels behind the existing indices, returns the
+//number of indices added
+static size_t build_lods(ImportedMesh& mesh, const MeshOptimizeOptions& options){
+    std::vector<u32> lodIndices;
+    u32 firstIndex = (u32)mesh.indices.size();
+    for(GeoSurface& surface : mesh.surfaces){
+        surface.lodCount = 0;
+        float maxError = options.lodMaxError * surface.bounds.sphereRadius;
+        std::vector<u32> previous(mesh.indices.begin() + surface.startIndex, mesh.indices.begin() + surface.startIndex + surface.count);
+        float error = 0.f;
+        for(u32 l = 0; l < std::min(options.lodCount, MAX_SURFACE_LODS) && error < maxError; ++l){
+            size_t target = previous.size() / 6 * 3;
+            float levelError = 0.f;
+            std::vector<u32> simplified = simplify(previous, mesh.vertices, target, maxError - error, {}, &levelError);
+            //stuck on locked vertices or the error budget, the next level would look the same
+            if(simplified.empty() || simplified.size() > previous.size() * 9 / 10){
+                break;
+            }
+            optimize_vertex_cache(simplified, options.cacheSize);
+            //each level starts from the previous one, so the errors add up
+            error += levelError;
+            SurfaceLod& lod = surface.lods[surface.lodCount++];
+            lod.startIndex = firstIndex + (u32)lodIndices.size();
+            lod.count = (u32)simplified.size();
+            lod.error = error;
+            lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.end());
+            previous = std::move(simplified);
+        }
+    }
+    mesh.indices.insert(mesh.indices.end(), lodIndices.begin(), lodIndices.end());
+    return lodIndices.size();
+}
+
+std::vector<ImportedMesh> convert_meshes(const tinygltf::Model& gltf, ThreadPool& pool, const MeshOptimizeOptions& options){
+    std::vector<ImportedMesh> imported(gltf.meshes.size());
+
+    //prefix sum over the accessor counts, every primitive gets its own slice of the mesh arrays
+    std::vector<PrimitiveTask> tasks;
+    for(u32 m = 0; m < (u32)gltf.meshes.size(); ++m){
+        const tinygltf::Mesh& mesh = gltf.meshes[m];
+        ImportedMesh& newmesh = imported[m];
+        newmesh.name = mesh.name;
+
+        u32 vertexCount = 0;
+        u32 indexCount = 0;
+        for(u32 i = 0; i < (u32)mesh.primitives.size(); ++i){
+            const tinygltf::Primitive& p = mesh.primitives[i];
+            PrimitiveTask task;
+            task.mesh = m;
+            task.primitive = i;
+            task.firstVertex = vertexCount;
+            task.vertexCount = (u32)gltf.accessors[p.attributes.at("POSITION")].count;
+            task.firstIndex = indexCount;
+            tasks.push_back(task);
+
+            GeoSurface newSurface;
+            newSurface.startIndex = indexCount;
+            newSurface.count = p.indices >= 0 ? (u32)gltf.accessors[p.indices].count : task.vertexCount;
+            newmesh.surfaces.push_back(newSurface);
+            newmesh.surfaceMaterials.push_back(p.material);
+
+            vertexCount += task.vertexCount;
+            indexCount += newSurface.count;
+        }
+        //every element gets written by exactly one task
+        newmesh.vertices.resize(vertexCount);
+        newmesh.indices.resize(indexCount);
+    }
+
+    pool.parallel_for((u32)tasks.size(), [&](u32 t){
+        const PrimitiveTask& task = tasks[t];
+        convert_primitive(gltf, imported[task.mesh], task);
+    });
+    optimize_meshes(imported, pool, options);
+    return imported;
+}
+
+void optimize_meshes(std::vector<ImportedMesh>& imported, ThreadPool& pool, const MeshOptimizeOptions& options){
+    if(!options.enabled && options.lodCount == 0){
+        return;
+    }
+
+    std::vector<VertexCacheStats> before(imported.size());
+    std::vector<VertexCacheStats> after(imported.size());
+    std::vector<size_t> vertexCounts(imported.size());
+    std::vector<size_t> indexCounts(imported.size());
+    std::vector<size_t> lodIndexCounts(imported.size());
+    pool.parallel_for((u32)imported.size(), [&](u32 m){
+        vertexCounts[m] = imported[m].vertices.size();
+        indexCounts[m] = imported[m].indices.size();
+        if(options.enabled){
+            optimize_mesh(imported[m], options, before[m], after[m]);
+        }
+        //after the fetch reordering, the levels only reference vertices that survived it
+        lodIndexCounts[m] = options.lodCount > 0 ? build_lods(imported[m], options) : 0;
+    });
+    VertexCacheStats totalBefore;
+    VertexCacheStats totalAfter;
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    size_t indices = 0;
+    size_t lodIndices = 0;
+    for(size_t m = 0; m < imported.size(); ++m){
+        totalBefore += before[m];
+        totalAfter += after[m];
+        verticesBefore += vertexCounts[m];
+        verticesAfter += imported[m].vertices.size();
+        indices += indexCounts[m];
+        lodIndices += lodIndexCounts[m];
+    }
+    if(options.enabled){
+        fmt::println("mesh optimization: {} -> {} vertices, acmr {:.3f} -> {:.3f}, atvr {:.3f} -> {:.3f}",
+            verticesBefore, verticesAfter, totalBefore.acmr(), totalAfter.acmr(), totalBefore.atvr(), totalAfter.atvr());
+    }
+    if(options.lodCount > 0){
+        fmt::println("mesh lods: {} indices added to {}", lodIndices, indices);
+    }
+}
+
+//image of a texture, the KHR_texture_basisu one when asked for and present
+static i32 texture_source(const tinygltf::Texture& texture, bool basisu){
+    if(basisu){
+        auto ext = texture.extensions.find("KHR_texture_basisu");
+        if(ext != texture.extensions.end() && ext->second.Has("source")){
+            return ext->second.Get("source").GetNumberAsInt();
+        }
+    }
+    return texture.source;
+}
+
+std::vector<ImportedMaterial> convert_materials(const tinygltf::Model& gltf, bool basisu){
+    std::vector<ImportedMaterial> imported;
+    imported.reserve(gltf.materials.size());
+    for(auto& mat : gltf.materials){
+        ImportedMaterial& newMat = imported.emplace_back();
+        newMat.name = mat.name;
+        newMat.colorFactor = vec4(mat.pbrMetallicRoughness.baseColorFactor[0],mat.pbrMetallicRoughness.baseColorFactor[1],
+            mat.pbrMetallicRoughness.baseColorFactor[2], mat.pbrMetallicRoughness.baseColorFactor[3]);
+        newMat.metalRoughnessFactor = vec4(0.f);
+        newMat.metalRoughnessFactor.x = (float)mat.pbrMetallicRoughness.metallicFactor;
+        newMat.metalRoughnessFactor.y = (float)mat.pbrMetallicRoughness.roughnessFactor;
+
+        newMat.passType = MaterialPass::MainColor;
+        if(mat.alphaMode == "BLEND"){
+            newMat.passType = MaterialPass::Transparent;
+        }
+
+        //grab textures from gltf file
+        newMat.colorImage = -1;
+        newMat.colorSampler = -1;
+        if(mat.pbrMetallicRoughness.baseColorTexture.index>=0){
+            newMat.colorImage = texture_source(gltf.textures[mat.pbrMetallicRoughness.baseColorTexture.index], basisu);
+            newMat.colorSampler = gltf.textures[mat.pbrMetallicRoughness.baseColorTexture.index].sampler;
+        }
+    }
+    return imported;
+}
+
+std::vector<ImportedNode> convert_nodes(const tinygltf::Model& gltf){
+    std::vector<ImportedNode> imported;
+    imported.reserve(gltf.nodes.size());
+    for(auto& node : gltf.nodes){
+        ImportedNode& newNode = imported.emplace_back();
+        newNode.name = node.name;
+        newNode.mesh = node.mesh;
+        for(int c : node.children){
+            newNode.children.push_back((u32)c);
+        }
+
+        vec3 tl = vec3(0.f);
+        vec3 sc = vec3(1.f);
+        quat rot = quat();
+        if(node.rotation.size()==4)
+            rot = glm::make_quat(node.rotation.data());
+        if(node.translation.size() == 3)
+            tl = glm::make_vec3(node.translation.data());
+        if(node.scale.size() == 3)
+            sc = glm::make_vec3(node.scale.data());
+        if(node.matrix.size() == 16)
+            newNode.localTransform = glm::make_mat4x4(node.matrix.data());
+        else{
+            mat4 tm = glm::translate(mat4(1.f),tl);
+            mat4 rm = mat4(rot);
+            mat4 sm = glm::scale(mat4(1.f),sc);
+            newNode.localTransform = tm * rm * sm;
+        }
+    }
+    return imported;
+}
+
+std::vector<VkSamplerCreateInfo> convert_samplers(const tinygltf::Model& gltf){
+    std::vector<VkSamplerCreateInfo> imported;
+    imported.reserve(gltf.samplers.size());
+    for(auto & sampler : gltf.samplers){
+        VkSamplerCreateInfo sampl{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+        sampl.maxLod = VK_LOD_CLAMP_NONE;
+        sampl.minLod = 0;
+        sampl.magFilter = extract_filter(sampler.magFilter);
+        sampl.minFilter = extract_filter(sampler.minFilter);
+        sampl.mipmapMode = extract_mipmap_mode(sampler.minFilter);
+        imported.push_back(sampl);
+    }
+    return imported;
+}
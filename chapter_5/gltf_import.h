@@ -0,0 +1,125 @@
+#pragma once
+#include <vk_types.h>
+#include "vk_loader.h"
+#include <meshes.h>
+#include <functional>
+
+//cpu only conversion of a tinygltf model into engine ready arrays. touches no vulkan state, so it
+//runs on worker threads and in the offline cooker alike
+
+namespace tinygltf{
+class Model;
+}
+class ThreadPool;
+
+//cpu side of a glTF mesh, converted on a worker thread and uploaded later from the main thread
+struct ImportedMesh{
+    std::string name;
+    std::vector<GeoSurface> surfaces;
+    //glTF material index of each surface, materials only exist once the main thread built them
+    std::vector<i32> surfaceMaterials;
+    std::vector<u32> indices;
+    std::vector<Vertex> vertices;
+    //used instead of the arrays above when the data is read straight out of a cooked file
+    std::span<const u32> mappedIndices;
+    std::span<const Vertex> mappedVertices;
+    //quantized copy of the vertices, uploaded instead of them when not empty
+    std::vector<PackedVertex> packedVertices;
+    //bounding box the packed positions are relative to
+    vec3 positionOffset{0.f};
+    vec3 positionScale{1.f};
+    //clusters of every surface, GeoSurface::firstMeshlet points in here
+    std::vector<Meshlet> meshlets;
+    //content hash of everything uploaded, the asset cache key. 0 until hashed
+    u64 hash{0};
+};
+
+struct ImportedMaterial{
+    std::string name;
+    vec4 colorFactor;
+    vec4 metalRoughnessFactor;
+    MaterialPass passType;
+    //image and sampler index of the base color texture, -1 when there is none
+    i32 colorImage;
+    i32 colorSampler;
+    //scale (xy) and offset (zw) into the atlas the loader packed the color texture into
+    vec4 uvTransform{1.f, 1.f, 0.f, 0.f};
+};
+
+struct ImportedNode{
+    std::string name;
+    //-1 for nodes without a mesh
+    i32 mesh;
+    mat4 localTransform;
+    std::vector<u32> children;
+};
+
+//import time mesh optimization, see meshes.h
+struct MeshOptimizeOptions{
+    bool enabled{true};
+    //sort triangle clusters for less overdraw after the cache pass, costs a little cache efficiency
+    bool overdraw{true};
+    u32 cacheSize{16};
+    float overdrawThreshold{1.05f};
+    //simplified levels per surface, each about half the triangles of the one before
+    u32 lodCount{4};
+    //a level may move the surface by at most this fraction of its bounding radius
+    float lodMaxError{0.05f};
+};
+
+//texels of a glTF image, empty when it could not be read or decoded. png/jpeg decode to rgba8,
+//KTX2 images keep the mip chain and block compressed format of the file
+struct DecodedImage{
+    std::string name;
+    //level 0
+    std::vector<u8> pixels;
+    //levels 1 and up when the file had them
+    std::vector<std::vector<u8>> mips;
+    u32 width{0};
+    u32 height{0};
+    VkFormat format{VK_FORMAT_R8G8B8A8_UNORM};
+    //time spent in the decoder
+    float decodeMs{0.f};
+};
+
+//encoded bytes of every image, indexed like the model images
+struct EncodedImages{
+    std::vector<std::vector<u8>> bytes;
+};
+
+//parse the file and decode its images. with encoded the images are only copied out while parsing,
+//for AsyncImageDecode to decode on the pool
+bool parse_gltf(std::string_view filePath, tinygltf::Model& gltf, EncodedImages* encoded = nullptr);
+
+//decode png/jpeg bytes to rgba8. KTX2 levels are copied as they are, basis universal ones are
+//transcoded to basisTarget, see ktx2::transcode
+DecodedImage decode_image(std::string name, std::span<const u8> bytes, VkFormat basisTarget = VK_FORMAT_R8G8B8A8_UNORM);
+
+//one decode job per image, running on the pool while the caller converts the rest of the file.
+//every image is claimed exactly once, by a worker or by finish(), so finish() can be called from a
+//pool job without waiting on decodes still sitting in the queue
+class AsyncImageDecode{
+    struct State;
+    std::shared_ptr<State> _state;
+public:
+    //done(i, image) runs on the thread that decoded image i
+    void start(ThreadPool& pool, const tinygltf::Model& gltf, EncodedImages&& encoded, std::function<void(u32, DecodedImage&&)> done,
+        VkFormat basisTarget = VK_FORMAT_R8G8B8A8_UNORM);
+    //decode the images no worker got to yet on this thread, then wait for the ones still running.
+    //returns the time spent decoding summed over every image
+    float finish();
+};
+
+//build the vertex/index arrays and bounds of every mesh, one primitive per pool task,
+//then optimize every mesh for the vertex cache, overdraw and fetch order and append the lod chains
+std::vector<ImportedMesh> convert_meshes(const tinygltf::Model& gltf, ThreadPool& pool, const MeshOptimizeOptions& options = {});
+//the optimization and lod part of convert_meshes, one mesh per pool task. shared by the glTF backends
+void optimize_meshes(std::vector<ImportedMesh>& meshes, ThreadPool& pool, const MeshOptimizeOptions& options);
+//with basisu textures use their KHR_texture_basisu image over the png/jpeg fallback
+std::vector<ImportedMaterial> convert_materials(const tinygltf::Model& gltf, bool basisu = false);
+std::vector<ImportedNode> convert_nodes(const tinygltf::Model& gltf);
+//filter settings only, everything else is left at its default
+std::vector<VkSamplerCreateInfo> convert_samplers(const tinygltf::Model& gltf);
+
+VkFilter extract_filter(int filter);
+VkSamplerMipmapMode extract_mipmap_mode(int filter);
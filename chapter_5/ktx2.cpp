@@ -0,0 +1,170 @@
+#include "ktx2.h"
+#include <vk_images.h>
+#include <cstring>
+#include <mutex>
+#if defined(VKGUIDE_BASISU)
+#include <basisu_transcoder.h>
+#endif
+
+namespace ktx2{
+
+static constexpr u8 IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+//start of the file up to the level index, little endian like everything else in it
+struct Header{
+    u8 identifier[12];
+    u32 vkFormat;
+    u32 typeSize;
+    u32 pixelWidth;
+    u32 pixelHeight;
+    u32 pixelDepth;
+    u32 layerCount;
+    u32 faceCount;
+    u32 levelCount;
+    u32 supercompressionScheme;
+    u32 dfdByteOffset;
+    u32 dfdByteLength;
+    u32 kvdByteOffset;
+    u32 kvdByteLength;
+    u64 sgdByteOffset;
+    u64 sgdByteLength;
+};
+static_assert(sizeof(Header) == 80);
+
+struct LevelIndex{
+    u64 byteOffset;
+    u64 byteLength;
+    u64 uncompressedByteLength;
+};
+
+enum Supercompression : u32{
+    None = 0,
+    BasisLZ = 1,
+    Zstandard = 2,
+    Zlib = 3
+};
+
+//color model of the data format descriptor for UASTC payloads
+constexpr u8 KHR_DF_MODEL_UASTC = 166;
+
+bool is_ktx2(std::span<const u8> bytes){
+    return bytes.size() >= sizeof(IDENTIFIER) && memcmp(bytes.data(), IDENTIFIER, sizeof(IDENTIFIER)) == 0;
+}
+
+bool parse(std::span<const u8> bytes, Texture& texture, std::string& error){
+    if(!is_ktx2(bytes) || bytes.size() < sizeof(Header)){
+        error = "not a KTX2 file";
+        return false;
+    }
+    Header header;
+    memcpy(&header, bytes.data(), sizeof(header));
+    if(header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1){
+        error = "only 2D textures are supported";
+        return false;
+    }
+    //0 asks the loader to generate the mips, the chain is just level 0 then
+    u32 levelCount = std::max(1u, header.levelCount);
+    if(sizeof(Header) + (size_t)levelCount * sizeof(LevelIndex) > bytes.size()){
+        error = "truncated level index";
+        return false;
+    }
+
+    //basis universal leaves the format undefined, ETC1S is always BasisLZ, UASTC is marked in the descriptor
+    u8 colorModel = 0;
+    if(header.dfdByteLength >= 16 && (size_t)header.dfdByteOffset + header.dfdByteLength <= bytes.size()){
+        colorModel = bytes[header.dfdByteOffset + 12];
+    }
+    texture.basis = header.vkFormat == VK_FORMAT_UNDEFINED &&
+        (header.supercompressionScheme == BasisLZ || colorModel == KHR_DF_MODEL_UASTC);
+    if(texture.basis){
+        if(header.supercompressionScheme == Zlib){
+            error = "zlib supercompression is not supported";
+            return false;
+        }
+    }else{
+        if(vkutil::format_block((VkFormat)header.vkFormat).bytes == 0){
+            error = fmt::format("format {} is not supported", string_VkFormat((VkFormat)header.vkFormat));
+            return false;
+        }
+        if(header.supercompressionScheme != None){
+            error = "supercompressed levels are only supported for basis universal";
+            return false;
+        }
+    }
+
+    texture.format = (VkFormat)header.vkFormat;
+    texture.width = header.pixelWidth;
+    texture.height = header.pixelHeight;
+    texture.levels.resize(levelCount);
+    for(u32 level = 0; level < levelCount; ++level){
+        LevelIndex index;
+        memcpy(&index, bytes.data() + sizeof(Header) + level * sizeof(LevelIndex), sizeof(index));
+        if(index.byteOffset > bytes.size() || index.byteLength > bytes.size() - index.byteOffset){
+            error = fmt::format("level {} is out of the file", level);
+            return false;
+        }
+        if(!texture.basis && index.byteLength != vkutil::image_level_size(texture.format, texture.width, texture.height, level)){
+            error = fmt::format("level {} has the wrong size", level);
+            return false;
+        }
+        texture.levels[level] = bytes.subspan(index.byteOffset, index.byteLength);
+    }
+    return true;
+}
+
+bool can_transcode(){
+#if defined(VKGUIDE_BASISU)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool transcode(std::span<const u8> bytes, VkFormat target, u32& width, u32& height, std::vector<std::vector<u8>>& levels, std::string& error){
+#if defined(VKGUIDE_BASISU)
+    static std::once_flag initialized;
+    std::call_once(initialized, [](){ basist::basisu_transcoder_init(); });
+
+    basist::transcoder_texture_format format;
+    switch(target){
+        case VK_FORMAT_BC7_UNORM_BLOCK: format = basist::transcoder_texture_format::cTFBC7_RGBA; break;
+        case VK_FORMAT_BC3_UNORM_BLOCK: format = basist::transcoder_texture_format::cTFBC3_RGBA; break;
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK: format = basist::transcoder_texture_format::cTFBC1_RGB; break;
+        case VK_FORMAT_R8G8B8A8_UNORM: format = basist::transcoder_texture_format::cTFRGBA32; break;
+        default:
+            error = fmt::format("can't transcode to {}", string_VkFormat(target));
+            return false;
+    }
+
+    //one transcoder per call, they keep per file state
+    basist::ktx2_transcoder transcoder;
+    if(!transcoder.init(bytes.data(), (u32)bytes.size()) || !transcoder.start_transcoding()){
+        error = "invalid basis universal payload";
+        return false;
+    }
+    width = transcoder.get_width();
+    height = transcoder.get_height();
+    levels.resize(std::max(1u, transcoder.get_levels()));
+    u32 unitBytes = basist::basis_get_bytes_per_block_or_pixel(format);
+    for(u32 level = 0; level < levels.size(); ++level){
+        basist::ktx2_image_level_info info;
+        if(!transcoder.get_image_level_info(info, level, 0, 0)){
+            error = fmt::format("level {} is missing", level);
+            return false;
+        }
+        //blocks for the compressed targets, pixels for rgba
+        u32 units = format == basist::transcoder_texture_format::cTFRGBA32 ? info.m_orig_width * info.m_orig_height : info.m_total_blocks;
+        levels[level].resize((size_t)units * unitBytes);
+        if(!transcoder.transcode_image_level(level, 0, 0, levels[level].data(), units, format)){
+            error = fmt::format("level {} failed to transcode", level);
+            return false;
+        }
+    }
+    return true;
+#else
+    error = "basis universal textures need a build with VKGUIDE_BASISU";
+    return false;
+#endif
+}
+
+}
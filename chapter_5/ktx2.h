@@ -0,0 +1,30 @@
+#pragma once
+#include <vk_types.h>
+
+//cpu only reader of KTX2 containers. 2D textures with a mip chain in a block compressed format the
+//engine can upload as is, or a basis universal payload (KHR_texture_basisu) that is transcoded to
+//one. basis universal needs the transcoder compiled in, see VKGUIDE_BASISU in CMakeLists.txt
+
+namespace ktx2{
+    //levels of a parsed file, pointing into the bytes it was parsed from. level 0 is the full resolution
+    struct Texture{
+        VkFormat format{VK_FORMAT_UNDEFINED};
+        u32 width{0};
+        u32 height{0};
+        //ETC1S or UASTC, format is undefined and the levels need transcoding
+        bool basis{false};
+        std::vector<std::span<const u8>> levels;
+    };
+
+    bool is_ktx2(std::span<const u8> bytes);
+
+    //checks the header and level index against the file size. arrays, cubemaps and 3D textures are
+    //rejected. other formats have to be uncompressed, basis payloads may be BasisLZ or zstd but not zlib
+    bool parse(std::span<const u8> bytes, Texture& texture, std::string& error);
+
+    //whether transcode can do anything in this build
+    bool can_transcode();
+    //transcode every level of a basis universal file to target, BC1/BC3/BC7 or R8G8B8A8_UNORM.
+    //safe to call from several threads at once
+    bool transcode(std::span<const u8> bytes, VkFormat target, u32& width, u32& height, std::vector<std::vector<u8>>& levels, std::string& error);
+}
@@ -1,8 +1,33 @@
 #include "vk_engine.h"
+#include <cstdlib>
 
 int main(int argc, char* argv[]){
     VulkanEngine engine;
 
+    //--tinygltf loads glTF files with the old parser, --serial-images has it decode images while
+    //parsing as it used to, for comparison. --texture-budget <MB> streams textures and keeps them
+    //within that much gpu memory. --material-sets gives every material its own descriptor set again.
+    //--anisotropy <n> starts with anisotropic filtering, it can be changed in the stats window.
+    //--no-atlas loads every texture into its own image. --scene <path> loads another glTF or OBJ file
+    for(int i = 1; i < argc; ++i){
+        if(std::string_view(argv[i]) == "--tinygltf"){
+            engine.gltfBackend = GltfBackend::TinyGltf;
+        }else if(std::string_view(argv[i]) == "--serial-images"){
+            engine.parallelImageDecode = false;
+        }else if(std::string_view(argv[i]) == "--texture-budget" && i + 1 < argc){
+            engine.streamTextures = true;
+            engine._textureStreamer.memoryBudget = (size_t)std::atoi(argv[++i]) * 1024 * 1024;
+        }else if(std::string_view(argv[i]) == "--material-sets"){
+            engine.bindlessMaterials = false;
+        }else if(std::string_view(argv[i]) == "--anisotropy" && i + 1 < argc){
+            engine._samplers.set_filtering((float)std::atof(argv[++i]), 0.f);
+        }else if(std::string_view(argv[i]) == "--no-atlas"){
+            engine.packAtlases = false;
+        }else if(std::string_view(argv[i]) == "--scene" && i + 1 < argc){
+            engine.scenePath = argv[++i];
+        }
+    }
+
     engine.init();
 
     engine.run();
@@ -0,0 +1,61 @@
+//throughput of the OBJ importer per phase, cpu only.
+//usage: chapter_5_obj_bench [--runs N] [files...], the files default to ../assets/*.obj
+#include "obj_import.h"
+#include <thread_pool.h>
+#include <filesystem>
+#include <algorithm>
+
+int main(int argc, char* argv[]){
+    u32 runCount = 5;
+    std::vector<std::filesystem::path> files;
+    for(int i = 1; i < argc; ++i){
+        std::string_view arg = argv[i];
+        if(arg == "--runs" && i + 1 < argc){
+            runCount = std::max(1, atoi(argv[++i]));
+        }else{
+            files.push_back(arg);
+        }
+    }
+    if(files.empty()){
+        std::error_code ec;
+        for(auto& entry : std::filesystem::directory_iterator("../assets", ec)){
+            if(entry.path().extension() == ".obj"){
+                files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+    }
+    if(files.empty()){
+        fmt::println("usage: {} [--runs N] [files...], no .obj files in ../assets", argv[0]);
+        return 1;
+    }
+
+    ThreadPool pool;
+    pool.init();
+    fmt::println("{} runs per file, fastest after the first, {} threads", runCount + 1, pool.size() + 1);
+    for(auto& file : files){
+        ObjImportStats best;
+        float bestMs = 1e30f;
+        //the first run reads the file into the page cache
+        for(u32 r = 0; r <= runCount; ++r){
+            ObjScene scene;
+            ObjImportStats stats;
+            if(!import_obj(file.string(), pool, scene, &stats)){
+                break;
+            }
+            float ms = stats.parseMs + stats.mergeMs + stats.dedupMs;
+            if(r > 0 && ms < bestMs){
+                bestMs = ms;
+                best = stats;
+            }
+        }
+        if(bestMs == 1e30f){
+            fmt::println("{}: failed to load", file.string());
+            continue;
+        }
+        fmt::println("{} ({:.2f} MB): {} triangles, {} vertices", file.string(), best.bytes / (1024.f * 1024.f), best.triangles, best.vertices);
+        fmt::println("  total {:8.2f} ms {:7.0f} MB/s | parse {:8.2f} ms {:7.0f} MB/s | merge {:8.2f} ms | dedup {:8.2f} ms",
+            bestMs, best.bytes / (bestMs * 1e3f), best.parseMs, best.bytes / (best.parseMs * 1e3f), best.mergeMs, best.dedupMs);
+    }
+    return 0;
+}
@@ -0,0 +1,675 @@
+#include "obj_import.h"
+#include <FileUtils.h>
+#include <thread_pool.h>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+
+namespace{
+
+//bytes per parse chunk, smaller files are parsed by one task
+constexpr size_t CHUNK_SIZE = 1 << 20;
+//meshes with more corners are deduplicated on the pool, smaller ones run one per task
+constexpr size_t PARALLEL_DEDUP_CORNERS = 1 << 16;
+//hash partitions of a parallel dedup, a power of two
+constexpr u32 DEDUP_PARTITIONS = 256;
+//marks a corner without uv or normal
+constexpr i32 NONE = INT32_MIN;
+
+//a face corner, 0 based position, uv and normal index. a set bit in relative means the index is
+//relative to the start of the chunk it was read in, the chunk offsets are only known after parsing
+struct Corner{
+    i32 index[3];
+    u32 relative;
+
+    bool operator==(const Corner& other) const{
+        return index[0] == other.index[0] && index[1] == other.index[1] && index[2] == other.index[2];
+    }
+};
+
+//o/g and usemtl lines, in file order
+struct ObjEvent{
+    enum Kind : u8{
+        Object,
+        Material
+    } kind;
+    //first corner after the line
+    u32 corner;
+    std::string name;
+};
+
+//everything one chunk of the file declares
+struct ObjChunk{
+    std::vector<vec3> positions;
+    //empty until the chunk sees a position with a color, then one per position
+    std::vector<vec3> colors;
+    std::vector<vec3> normals;
+    std::vector<vec2> uvs;
+    std::vector<Corner> corners;
+    std::vector<ObjEvent> events;
+    std::vector<std::string> libraries;
+    u32 badLines{0};
+};
+
+//the merged file, indices all absolute
+struct ObjData{
+    std::vector<vec3> positions;
+    std::vector<vec3> colors;
+    std::vector<vec3> normals;
+    std::vector<vec2> uvs;
+    std::vector<Corner> corners;
+};
+
+//corners of one material inside an object, in file order
+struct ObjSurface{
+    i32 material;
+    std::vector<std::pair<u32, u32>> ranges;
+};
+
+struct ObjObject{
+    std::string name;
+    std::vector<ObjSurface> surfaces;
+    size_t cornerCount{0};
+};
+
+float elapsed_ms(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.f;
+}
+
+const char* skip_space(const char* p, const char* end){
+    while(p < end && (*p == ' ' || *p == '\t')){
+        ++p;
+    }
+    return p;
+}
+
+//rest of the line without surrounding whitespace
+std::string_view rest_of_line(const char* p, const char* end){
+    p = skip_space(p, end);
+    while(end > p && (end[-1] == ' ' || end[-1] == '\t')){
+        --end;
+    }
+    return std::string_view(p, end - p);
+}
+
+//from_chars is the locale independent shortest path float parser, it only lacks the leading +
+const char* parse_float(const char* p, const char* end, float& value){
+    p = skip_space(p, end);
+    if(p < end && *p == '+'){
+        ++p;
+    }
+    auto [ptr, ec] = std::from_chars(p, end, value);
+    return ec == std::errc() ? ptr : nullptr;
+}
+
+//one index of a corner: 1 based, or negative counting back from the last element declared so far.
+//empty indices give NONE
+const char* parse_index(const char* p, const char* end, size_t declared, i32& index, u32& relative, u32 bit){
+    bool negative = p < end && *p == '-';
+    if(p < end && (*p == '-' || *p == '+')){
+        ++p;
+    }
+    const char* digits = p;
+    i64 value = 0;
+    while(p < end && (u8)(*p - '0') < 10){
+        value = std::min<i64>(value * 10 + (*p - '0'), INT_MAX);
+        ++p;
+    }
+    if(p == digits || value == 0){
+        index = NONE;
+    }else if(negative){
+        index = (i32)((i64)declared - value);
+        relative |= bit;
+    }else{
+        index = (i32)(value - 1);
+    }
+    return p;
+}
+
+//a face line after the f, fanned into triangles
+bool parse_face(const char* p, const char* end, ObjChunk& chunk, std::vector<Corner>& polygon){
+    polygon.clear();
+    while(true){
+        p = skip_space(p, end);
+        if(p == end){
+            break;
+        }
+        Corner corner{{NONE, NONE, NONE}, 0};
+        p = parse_index(p, end, chunk.positions.size(), corner.index[0], corner.relative, 1);
+        if(p < end && *p == '/'){
+            p = parse_index(p + 1, end, chunk.uvs.size(), corner.index[1], corner.relative, 2);
+            if(p < end && *p == '/'){
+                p = parse_index(p + 1, end, chunk.normals.size(), corner.index[2], corner.relative, 4);
+            }
+        }
+        if(corner.index[0] == NONE || (p < end && *p != ' ' && *p != '\t')){
+            return false;
+        }
+        polygon.push_back(corner);
+    }
+    if(polygon.size() < 3){
+        return false;
+    }
+    for(size_t i = 2; i < polygon.size(); ++i){
+        chunk.corners.push_back(polygon[0]);
+        chunk.corners.push_back(polygon[i - 1]);
+        chunk.corners.push_back(polygon[i]);
+    }
+    return true;
+}
+
+bool parse_position(const char* p, const char* end, ObjChunk& chunk){
+    vec3 position;
+    for(u32 i = 0; i < 3; ++i){
+        if(!(p = parse_float(p, end, position[i]))){
+            return false;
+        }
+    }
+    //x y z [w] or the x y z r g b vertex color extension
+    float extra[3];
+    u32 extraCount = 0;
+    while(extraCount < 3 && p && skip_space(p, end) < end){
+        p = parse_float(p, end, extra[extraCount]);
+        extraCount += p ? 1 : 0;
+    }
+    if(extraCount == 3 && chunk.colors.empty()){
+        chunk.colors.resize(chunk.positions.size(), vec3(1.f));
+    }
+    if(!chunk.colors.empty()){
+        chunk.colors.push_back(extraCount == 3 ? vec3(extra[0], extra[1], extra[2]) : vec3(1.f));
+    }
+    chunk.positions.push_back(position);
+    return true;
+}
+
+bool starts_with_word(const char* p, const char* end, std::string_view word){
+    return (size_t)(end - p) > word.size() && memcmp(p, word.data(), word.size()) == 0 && (p[word.size()] == ' ' || p[word.size()] == '\t');
+}
+
+//parse the lines starting in [begin, end), the last one may run past end only up to its newline
+void parse_chunk(const char* begin, const char* end, ObjChunk& chunk){
+    std::vector<Corner> polygon;
+    //about 30 bytes per line, most of them positions or faces
+    chunk.positions.reserve((end - begin) / 64);
+    chunk.corners.reserve((end - begin) / 16);
+    for(const char* line = begin; line < end;){
+        const char* eol = (const char*)memchr(line, '\n', end - line);
+        eol = eol ? eol : end;
+        const char* next = eol + 1;
+        if(eol > line && eol[-1] == '\r'){
+            --eol;
+        }
+        const char* p = skip_space(line, eol);
+        bool ok = true;
+        if(eol - p >= 2){
+            if(p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')){
+                ok = parse_position(p + 1, eol, chunk);
+            }else if(starts_with_word(p, eol, "vn")){
+                vec3 n;
+                ok = (p = parse_float(p + 2, eol, n.x)) && (p = parse_float(p, eol, n.y)) && (p = parse_float(p, eol, n.z));
+                chunk.normals.push_back(ok ? n : vec3(1.f, 0.f, 0.f));
+            }else if(starts_with_word(p, eol, "vt")){
+                vec2 uv(0.f);
+                ok = (p = parse_float(p + 2, eol, uv.x)) != nullptr;
+                if(ok && skip_space(p, eol) < eol){
+                    ok = parse_float(p, eol, uv.y) != nullptr;
+                }
+                chunk.uvs.push_back(uv);
+            }else if(p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')){
+                ok = parse_face(p + 1, eol, chunk, polygon);
+            }else if((p[0] == 'o' || p[0] == 'g') && (p[1] == ' ' || p[1] == '\t')){
+                chunk.events.push_back({ObjEvent::Object, (u32)chunk.corners.size(), std::string(rest_of_line(p + 1, eol))});
+            }else if(starts_with_word(p, eol, "usemtl")){
+                chunk.events.push_back({ObjEvent::Material, (u32)chunk.corners.size(), std::string(rest_of_line(p + 6, eol))});
+            }else if(starts_with_word(p, eol, "mtllib")){
+                chunk.libraries.emplace_back(rest_of_line(p + 6, eol));
+            }
+        }
+        chunk.badLines += ok ? 0 : 1;
+        line = next;
+    }
+}
+
+//Kd, d/Tr and map_Kd of every newmtl, the rest of the lighting model is ignored
+void parse_mtl(const std::filesystem::path& path, std::vector<ObjMaterial>& materials){
+    MappedFile file;
+    if(!file.open(path.string().c_str())){
+        return;
+    }
+    const char* p = (const char*)file.data();
+    const char* end = p + file.size();
+    while(p < end){
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        eol = eol ? eol : end;
+        const char* next = eol + 1;
+        if(eol > p && eol[-1] == '\r'){
+            --eol;
+        }
+        const char* line = skip_space(p, eol);
+        if(starts_with_word(line, eol, "newmtl")){
+            materials.push_back({std::string(rest_of_line(line + 6, eol))});
+        }else if(!materials.empty()){
+            ObjMaterial& material = materials.back();
+            if(starts_with_word(line, eol, "Kd")){
+                vec3 kd;
+                const char* q = line + 2;
+                if((q = parse_float(q, eol, kd.x)) && (q = parse_float(q, eol, kd.y)) && parse_float(q, eol, kd.z)){
+                    material.diffuse = vec4(kd, material.diffuse.w);
+                }
+            }else if(starts_with_word(line, eol, "d")){
+                parse_float(line + 1, eol, material.diffuse.w);
+            }else if(starts_with_word(line, eol, "Tr")){
+                float tr;
+                if(parse_float(line + 2, eol, tr)){
+                    material.diffuse.w = 1.f - tr;
+                }
+            }else if(starts_with_word(line, eol, "map_Kd")){
+                //options like -bm 1 come first, the file name is the last word
+                std::string_view rest = rest_of_line(line + 6, eol);
+                size_t space = rest.find_last_of(" \t");
+                std::string_view name = space == std::string_view::npos ? rest : rest.substr(space + 1);
+                material.diffuseTexture = (path.parent_path() / name).string();
+            }
+        }
+        p = next;
+    }
+}
+
+u64 corner_hash(const Corner& corner){
+    u64 h = (u32)corner.index[0] * 0x9E3779B97F4A7C15ull;
+    h ^= (u32)corner.index[1] * 0xC2B2AE3D27D4EB4Full;
+    h ^= (u32)corner.index[2] * 0x165667B19E3779F9ull;
+    h ^= h >> 32;
+    h *= 0xD6E8FEB86659FD93ull;
+    return h ^ (h >> 29);
+}
+
+//vertex of every corner, numbered by first use, and the first corner of every vertex.
+//corners are split by hash into partitions that are deduplicated independently, a prefix sum over the
+//first corners then numbers the vertices, so the result is the same whatever the partition count
+std::vector<u32> dedupe_corners(std::span<const Corner> corners, std::span<u32> vertexOfCorner, ThreadPool* pool){
+    size_t count = corners.size();
+    u32 partitions = pool ? DEDUP_PARTITIONS : 1;
+    u32 blocks = pool ? std::max<u32>(1, std::min<u32>((pool->size() + 1) * 4, (u32)(count / 4096))) : 1;
+    auto run = [&](u32 n, const std::function<void(u32)>& fn){
+        if(pool && n > 1){
+            pool->parallel_for(n, fn);
+        }else{
+            for(u32 i = 0; i < n; ++i){
+                fn(i);
+            }
+        }
+    };
+    auto block_begin = [&](u32 b){ return count * b / blocks; };
+    auto partition_of = [&](const Corner& c){ return partitions > 1 ? (u32)(corner_hash(c) >> 56) & (partitions - 1) : 0; };
+
+    //counting sort of the corners by partition, stable so every partition is in corner order. the
+    //corners are copied with their number in relative, the partitions are then read front to back
+    //scratch arrays are written before they are read, no need to clear them
+    auto order = std::make_unique_for_overwrite<Corner[]>(count);
+    std::vector<size_t> offsets((size_t)blocks * partitions, 0);
+    std::vector<size_t> partitionStart(partitions + 1, 0);
+    run(blocks, [&](u32 b){
+        size_t* hist = &offsets[(size_t)b * partitions];
+        for(size_t i = block_begin(b); i < block_begin(b + 1); ++i){
+            hist[partition_of(corners[i])]++;
+        }
+    });
+    size_t total = 0;
+    for(u32 p = 0; p < partitions; ++p){
+        partitionStart[p] = total;
+        for(u32 b = 0; b < blocks; ++b){
+            size_t n = offsets[(size_t)b * partitions + p];
+            offsets[(size_t)b * partitions + p] = total;
+            total += n;
+        }
+    }
+    partitionStart[partitions] = total;
+    run(blocks, [&](u32 b){
+        size_t* offset = &offsets[(size_t)b * partitions];
+        for(size_t i = block_begin(b); i < block_begin(b + 1); ++i){
+            Corner& sorted = order[offset[partition_of(corners[i])]++];
+            sorted = corners[i];
+            sorted.relative = (u32)i;
+        }
+    });
+
+    //first corner with the same triple, open addressing on the low hash bits. slots hold the triple
+    //and its first corner in relative like the sorted corners
+    auto firstCorner = std::make_unique_for_overwrite<u32[]>(count);
+    run(partitions, [&](u32 p){
+        std::span<const Corner> members = std::span<const Corner>(order.get(), count).subspan(partitionStart[p], partitionStart[p + 1] - partitionStart[p]);
+        constexpr Corner EMPTY{{NONE, NONE, NONE}, UINT32_MAX};
+        //sized for a few corners per vertex, grown when half full
+        size_t capacity = 16;
+        while(capacity < members.size() / 2){
+            capacity *= 2;
+        }
+        std::vector<Corner> table(capacity, EMPTY);
+        size_t used = 0;
+        auto find_slot = [&](const Corner& corner){
+            size_t slot = corner_hash(corner) & (capacity - 1);
+            while(table[slot].relative != UINT32_MAX && !(table[slot] == corner)){
+                slot = (slot + 1) & (capacity - 1);
+            }
+            return slot;
+        };
+        for(const Corner& corner : members){
+            if((used + 1) * 2 > capacity){
+                std::vector<Corner> old(capacity * 2, EMPTY);
+                std::swap(old, table);
+                capacity *= 2;
+                for(const Corner& entry : old){
+                    if(entry.relative != UINT32_MAX){
+                        table[find_slot(entry)] = entry;
+                    }
+                }
+            }
+            size_t slot = find_slot(corner);
+            if(table[slot].relative == UINT32_MAX){
+                table[slot] = corner;
+                used++;
+            }
+            firstCorner[corner.relative] = table[slot].relative;
+        }
+    });
+
+    //number the first corners in corner order
+    std::vector<u32> blockVertices(blocks + 1, 0);
+    run(blocks, [&](u32 b){
+        u32 n = 0;
+        for(size_t i = block_begin(b); i < block_begin(b + 1); ++i){
+            n += firstCorner[i] == i ? 1 : 0;
+        }
+        blockVertices[b + 1] = n;
+    });
+    for(u32 b = 0; b < blocks; ++b){
+        blockVertices[b + 1] += blockVertices[b];
+    }
+    std::vector<u32> vertexCorners(blockVertices[blocks]);
+    run(blocks, [&](u32 b){
+        u32 vertex = blockVertices[b];
+        for(size_t i = block_begin(b); i < block_begin(b + 1); ++i){
+            if(firstCorner[i] == i){
+                vertexOfCorner[i] = vertex;
+                vertexCorners[vertex++] = (u32)i;
+            }
+        }
+    });
+    //a first corner always comes before the other corners of its vertex, but maybe in another block
+    run(blocks, [&](u32 b){
+        for(size_t i = block_begin(b); i < block_begin(b + 1); ++i){
+            if(firstCorner[i] != i){
+                vertexOfCorner[i] = vertexOfCorner[firstCorner[i]];
+            }
+        }
+    });
+    return vertexCorners;
+}
+
+//indices, deduplicated vertices and surface bounds of one object. pool is null for the small
+//objects that already run one per task
+void build_mesh(const ObjObject& object, const ObjData& data, ThreadPool* pool, ImportedMesh& mesh){
+    mesh.name = object.name;
+    //the corners of the object surface after surface, copied only when the file interleaves them
+    std::vector<Corner> gathered;
+    std::span<const Corner> corners;
+    if(object.surfaces.size() == 1 && object.surfaces[0].ranges.size() == 1){
+        auto [first, count] = object.surfaces[0].ranges[0];
+        corners = std::span<const Corner>(data.corners).subspan(first, count);
+    }else{
+        gathered.reserve(object.cornerCount);
+        for(const ObjSurface& surface : object.surfaces){
+            for(auto [first, count] : surface.ranges){
+                gathered.insert(gathered.end(), data.corners.begin() + first, data.corners.begin() + first + count);
+            }
+        }
+        corners = gathered;
+    }
+    u32 cursor = 0;
+    for(const ObjSurface& surface : object.surfaces){
+        GeoSurface newSurface{};
+        newSurface.startIndex = cursor;
+        for(const auto& range : surface.ranges){
+            cursor += range.second;
+        }
+        newSurface.count = cursor - newSurface.startIndex;
+        mesh.surfaces.push_back(newSurface);
+        mesh.surfaceMaterials.push_back(surface.material);
+    }
+
+    mesh.indices.resize(corners.size());
+    std::vector<u32> vertexCorners = dedupe_corners(corners, mesh.indices, pool);
+    mesh.vertices.resize(vertexCorners.size());
+    bool missingNormals = false;
+    //obj uvs start at the bottom of the image
+    for(size_t v = 0; v < vertexCorners.size(); ++v){
+        const Corner& corner = corners[vertexCorners[v]];
+        Vertex& vtx = mesh.vertices[v];
+        vtx.position = data.positions[corner.index[0]];
+        vtx.normal = corner.index[2] != NONE ? data.normals[corner.index[2]] : vec3(0.f);
+        vec2 uv = corner.index[1] != NONE ? data.uvs[corner.index[1]] : vec2(0.f);
+        vtx.uv_x = uv.x;
+        vtx.uv_y = 1.f - uv.y;
+        vtx.color = data.colors.empty() ? vec4(1.f) : vec4(data.colors[corner.index[0]], 1.f);
+        missingNormals |= corner.index[2] == NONE;
+    }
+    //area weighted face normals for the vertices the file gave none
+    if(missingNormals){
+        std::vector<vec3> faceNormals(mesh.vertices.size(), vec3(0.f));
+        for(size_t i = 0; i + 2 < mesh.indices.size(); i += 3){
+            const u32* tri = &mesh.indices[i];
+            vec3 n = glm::cross(mesh.vertices[tri[1]].position - mesh.vertices[tri[0]].position,
+                mesh.vertices[tri[2]].position - mesh.vertices[tri[0]].position);
+            for(u32 k = 0; k < 3; ++k){
+                faceNormals[tri[k]] += n;
+            }
+        }
+        for(size_t v = 0; v < vertexCorners.size(); ++v){
+            if(corners[vertexCorners[v]].index[2] == NONE){
+                float length = glm::length(faceNormals[v]);
+                mesh.vertices[v].normal = length > 0.f ? faceNormals[v] / length : vec3(1.f, 0.f, 0.f);
+            }
+        }
+    }
+
+    for(GeoSurface& surface : mesh.surfaces){
+        if(surface.count == 0){
+            continue;
+        }
+        vec3 minpos = mesh.vertices[mesh.indices[surface.startIndex]].position;
+        vec3 maxpos = minpos;
+        for(u32 i = surface.startIndex; i < surface.startIndex + surface.count; ++i){
+            minpos = glm::min(minpos, mesh.vertices[mesh.indices[i]].position);
+            maxpos = glm::max(maxpos, mesh.vertices[mesh.indices[i]].position);
+        }
+        surface.bounds.origin = (maxpos + minpos) * 0.5f;
+        surface.bounds.extents = (maxpos - minpos) * 0.5f;
+        surface.bounds.sphereRadius = glm::length(surface.bounds.extents);
+    }
+}
+
+}
+
+bool import_obj(std::string_view filePath, ThreadPool& pool, ObjScene& scene, ObjImportStats* stats){
+    std::filesystem::path path(filePath);
+    MappedFile file;
+    if(!file.open(path.string().c_str())){
+        fmt::println("Failed to open OBJ {}", filePath);
+        return false;
+    }
+    ObjImportStats localStats;
+    stats = stats ? stats : &localStats;
+    *stats = {};
+    stats->bytes = file.size();
+    auto start = std::chrono::steady_clock::now();
+
+    //split at the first newline after every chunk boundary
+    const char* text = (const char*)file.data();
+    size_t chunkCount = std::clamp<size_t>(file.size() / CHUNK_SIZE, 1, (pool.size() + 1) * 8);
+    std::vector<size_t> bounds(chunkCount + 1, file.size());
+    bounds[0] = 0;
+    for(size_t i = 1; i < chunkCount; ++i){
+        size_t at = std::max(file.size() * i / chunkCount, bounds[i - 1]);
+        const char* nl = at < file.size() ? (const char*)memchr(text + at, '\n', file.size() - at) : nullptr;
+        bounds[i] = nl ? (size_t)(nl + 1 - text) : file.size();
+    }
+    std::vector<ObjChunk> chunks(chunkCount);
+    pool.parallel_for((u32)chunkCount, [&](u32 i){
+        parse_chunk(text + bounds[i], text + bounds[i + 1], chunks[i]);
+    });
+    stats->parseMs = elapsed_ms(start);
+    start = std::chrono::steady_clock::now();
+
+    //offsets of every chunk in the merged arrays
+    struct ChunkBase{
+        size_t positions{0};
+        size_t uvs{0};
+        size_t normals{0};
+        size_t corners{0};
+    };
+    std::vector<ChunkBase> bases(chunkCount + 1);
+    bool colors = false;
+    u32 badLines = 0;
+    for(size_t i = 0; i < chunkCount; ++i){
+        bases[i + 1].positions = bases[i].positions + chunks[i].positions.size();
+        bases[i + 1].uvs = bases[i].uvs + chunks[i].uvs.size();
+        bases[i + 1].normals = bases[i].normals + chunks[i].normals.size();
+        bases[i + 1].corners = bases[i].corners + chunks[i].corners.size();
+        colors |= !chunks[i].colors.empty();
+        badLines += chunks[i].badLines;
+    }
+    ObjData data;
+    data.positions.resize(bases[chunkCount].positions);
+    data.colors.resize(colors ? data.positions.size() : 0);
+    data.uvs.resize(bases[chunkCount].uvs);
+    data.normals.resize(bases[chunkCount].normals);
+    data.corners.resize(bases[chunkCount].corners);
+    std::atomic<u32> badIndices{0};
+    pool.parallel_for((u32)chunkCount, [&](u32 i){
+        ObjChunk& chunk = chunks[i];
+        const ChunkBase& base = bases[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), data.positions.begin() + base.positions);
+        if(colors){
+            if(chunk.colors.empty()){
+                std::fill_n(data.colors.begin() + base.positions, chunk.positions.size(), vec3(1.f));
+            }else{
+                std::copy(chunk.colors.begin(), chunk.colors.end(), data.colors.begin() + base.positions);
+            }
+        }
+        std::copy(chunk.uvs.begin(), chunk.uvs.end(), data.uvs.begin() + base.uvs);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), data.normals.begin() + base.normals);
+        //relative indices become absolute, out of range ones are dropped
+        const size_t chunkOffset[3] = {base.positions, base.uvs, base.normals};
+        const size_t arraySize[3] = {data.positions.size(), data.uvs.size(), data.normals.size()};
+        u32 bad = 0;
+        Corner* out = data.corners.data() + base.corners;
+        for(Corner corner : chunk.corners){
+            for(u32 k = 0; k < 3; ++k){
+                if(corner.index[k] == NONE){
+                    continue;
+                }
+                i64 index = corner.index[k] + ((corner.relative >> k) & 1 ? (i64)chunkOffset[k] : 0);
+                if(index < 0 || index >= (i64)arraySize[k]){
+                    bad++;
+                    index = k == 0 ? 0 : NONE;
+                }
+                corner.index[k] = (i32)index;
+            }
+            corner.relative = 0;
+            *out++ = corner;
+        }
+        badIndices += bad;
+        //the chunk arrays are not needed anymore, halves the peak memory of huge files
+        chunk.positions = {};
+        chunk.colors = {};
+        chunk.uvs = {};
+        chunk.normals = {};
+        chunk.corners = {};
+    });
+    if(data.positions.empty() && !data.corners.empty()){
+        data.corners.clear();
+    }
+
+    //materials of every library, then the file name with .mtl as the exporters often name it
+    std::vector<std::string> libraries;
+    for(ObjChunk& chunk : chunks){
+        libraries.insert(libraries.end(), chunk.libraries.begin(), chunk.libraries.end());
+    }
+    for(const std::string& library : libraries){
+        parse_mtl(path.parent_path() / library, scene.materials);
+    }
+    if(scene.materials.empty()){
+        parse_mtl(std::filesystem::path(path).replace_extension(".mtl"), scene.materials);
+    }
+    auto find_material = [&](const std::string& name){
+        for(size_t i = 0; i < scene.materials.size(); ++i){
+            if(scene.materials[i].name == name){
+                return (i32)i;
+            }
+        }
+        return -1;
+    };
+
+    //corner ranges of every object and material, objects are the o and g lines
+    std::vector<ObjObject> objects(1);
+    objects[0].name = path.stem().string();
+    i32 material = -1;
+    u32 cursor = 0;
+    auto add_range = [&](u32 end){
+        if(end == cursor){
+            return;
+        }
+        ObjObject& object = objects.back();
+        auto surface = std::find_if(object.surfaces.begin(), object.surfaces.end(), [&](const ObjSurface& s){ return s.material == material; });
+        if(surface == object.surfaces.end()){
+            object.surfaces.push_back({material});
+            surface = object.surfaces.end() - 1;
+        }
+        surface->ranges.push_back({cursor, end - cursor});
+        object.cornerCount += end - cursor;
+        cursor = end;
+    };
+    for(size_t i = 0; i < chunkCount; ++i){
+        for(ObjEvent& event : chunks[i].events){
+            add_range((u32)(event.corner + bases[i].corners));
+            if(event.kind == ObjEvent::Object){
+                objects.push_back({event.name});
+            }else{
+                material = find_material(event.name);
+            }
+        }
+    }
+    add_range((u32)data.corners.size());
+    std::erase_if(objects, [](const ObjObject& object){ return object.cornerCount == 0; });
+    stats->mergeMs = elapsed_ms(start);
+    start = std::chrono::steady_clock::now();
+
+    //small objects one per task, big ones one after the other with the dedup spread on the pool
+    scene.meshes.resize(objects.size());
+    std::vector<u32> small;
+    for(u32 i = 0; i < objects.size(); ++i){
+        if(objects[i].cornerCount < PARALLEL_DEDUP_CORNERS){
+            small.push_back(i);
+        }else{
+            build_mesh(objects[i], data, &pool, scene.meshes[i]);
+        }
+    }
+    pool.parallel_for((u32)small.size(), [&](u32 i){
+        build_mesh(objects[small[i]], data, nullptr, scene.meshes[small[i]]);
+    });
+    stats->dedupMs = elapsed_ms(start);
+
+    for(const ImportedMesh& mesh : scene.meshes){
+        stats->triangles += mesh.indices.size() / 3;
+        stats->vertices += mesh.vertices.size();
+    }
+    if(badLines > 0 || badIndices > 0){
+        fmt::println("OBJ {}: skipped {} malformed lines and {} out of range indices", filePath, badLines, badIndices.load());
+    }
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "gltf_import.h"
+
+//cpu only OBJ/MTL import into the same ImportedMesh arrays as the glTF path. the file is mapped and
+//split into line aligned chunks parsed on the pool, every o/g becomes a mesh with one surface per material
+
+//material of an OBJ file, only the parts the engine can draw
+struct ObjMaterial{
+    std::string name;
+    //Kd and d
+    vec4 diffuse{1.f};
+    //map_Kd resolved against the directory of the .mtl file, empty when untextured
+    std::string diffuseTexture;
+};
+
+struct ObjScene{
+    //surfaceMaterials index into materials, -1 for faces without a known usemtl
+    std::vector<ImportedMesh> meshes;
+    std::vector<ObjMaterial> materials;
+};
+
+//milliseconds of each phase and what came out of the file
+struct ObjImportStats{
+    size_t bytes{0};
+    size_t triangles{0};
+    size_t vertices{0};
+    float parseMs{0.f};
+    float mergeMs{0.f};
+    float dedupMs{0.f};
+};
+
+//parse the file and the .mtl libraries it names, falls back to <name>.mtl next to it when they
+//can't be opened. false when the .obj itself can't be mapped
+bool import_obj(std::string_view filePath, ThreadPool& pool, ObjScene& scene, ObjImportStats* stats = nullptr);
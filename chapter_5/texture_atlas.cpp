@@ -0,0 +1,105 @@
+#include "texture_atlas.h"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstring>
+
+namespace atlas{
+
+static u32 align_up(u32 value){
+    return (value + PADDING - 1) & ~(PADDING - 1);
+}
+
+//tile with its padding, rounded up to whole texels of the last level
+static u32 footprint(u32 size){
+    return align_up(size + 2 * PADDING);
+}
+
+//texel of the tile a padding texel repeats, like a REPEAT sampler would read it
+static u32 wrap(i32 coord, u32 size){
+    i32 n = (i32)size;
+    return (u32)(((coord % n) + n) % n);
+}
+
+std::vector<Atlas> pack(std::span<Tile> tiles){
+    std::vector<Atlas> atlases;
+    if(tiles.empty()){
+        return atlases;
+    }
+    std::vector<u32> order(tiles.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](u32 a, u32 b){
+        if(tiles[a].height != tiles[b].height){
+            return tiles[a].height > tiles[b].height;
+        }
+        return tiles[a].width > tiles[b].width;
+    });
+
+    //shelves about as wide as a square holding everything, so a handful of tiles don't make a 2048 wide strip
+    size_t area = 0;
+    u32 widest = 0;
+    for(const Tile& tile : tiles){
+        area += (size_t)footprint(tile.width) * footprint(tile.height);
+        widest = std::max(widest, footprint(tile.width));
+    }
+    u32 shelfWidth = std::clamp(align_up((u32)std::ceil(std::sqrt((double)area))), widest, MAX_SIZE);
+
+    //place everything first, the atlases are sized to what they hold
+    struct Placement{
+        u32 x;
+        u32 y;
+    };
+    std::vector<Placement> placements(tiles.size());
+    u32 x = 0;
+    u32 y = 0;
+    u32 shelfHeight = 0;
+    atlases.emplace_back();
+    for(u32 i : order){
+        Tile& tile = tiles[i];
+        u32 w = footprint(tile.width);
+        u32 h = footprint(tile.height);
+        if(x + w > shelfWidth){
+            y += shelfHeight;
+            x = 0;
+            shelfHeight = 0;
+        }
+        if(y + h > MAX_SIZE){
+            atlases.emplace_back();
+            x = 0;
+            y = 0;
+            shelfHeight = 0;
+        }
+        Atlas& current = atlases.back();
+        tile.atlas = (u32)atlases.size() - 1;
+        placements[i] = {x, y};
+        current.width = std::max(current.width, x + w);
+        current.height = std::max(current.height, y + h);
+        x += w;
+        shelfHeight = std::max(shelfHeight, h);
+    }
+
+    for(Atlas& atlas : atlases){
+        atlas.pixels.resize((size_t)atlas.width * atlas.height * 4);
+    }
+    for(size_t i = 0; i < tiles.size(); ++i){
+        Tile& tile = tiles[i];
+        Atlas& atlas = atlases[tile.atlas];
+        Placement placement = placements[i];
+        u32 w = footprint(tile.width);
+        u32 h = footprint(tile.height);
+        for(u32 ty = 0; ty < h; ++ty){
+            u32 sy = wrap((i32)ty - (i32)PADDING, tile.height);
+            u8* dst = atlas.pixels.data() + ((size_t)(placement.y + ty) * atlas.width + placement.x) * 4;
+            const u8* src = tile.pixels + (size_t)sy * tile.width * 4;
+            for(u32 tx = 0; tx < w; ++tx){
+                u32 sx = wrap((i32)tx - (i32)PADDING, tile.width);
+                std::memcpy(dst + (size_t)tx * 4, src + (size_t)sx * 4, 4);
+            }
+        }
+        tile.uvTransform = vec4((float)tile.width / atlas.width, (float)tile.height / atlas.height,
+            (float)(placement.x + PADDING) / atlas.width, (float)(placement.y + PADDING) / atlas.height);
+    }
+    return atlases;
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vk_types.h>
+#include <span>
+
+//cpu only packer of small rgba8 textures into shared atlases, so the materials sampling them share
+//one image binding. tiles are wrapped into a padding as wide as the last usable mip level needs for
+//bilinear filtering, the shader wraps the uv inside the tile (shaders/atlas.glsl) so repeating
+//textures keep repeating
+
+namespace atlas{
+    //largest side of a texture that is worth packing
+    constexpr u32 MAX_TILE = 256;
+    constexpr u32 MAX_SIZE = 2048;
+    //mip levels of an atlas that don't bleed between tiles, materials clamp their sampler to them
+    constexpr u32 LEVELS = 4;
+    //texels of wrapped padding around every tile, one texel of it is left at the last level
+    constexpr u32 PADDING = 1 << (LEVELS - 1);
+
+    struct Tile{
+        u32 width;
+        u32 height;
+        //rgba8 texels, width * height * 4 bytes
+        const u8* pixels;
+
+        //filled in by pack: atlas the tile went into and the scale (xy) and offset (zw) from the
+        //uv of the texture to the uv in the atlas
+        u32 atlas{0};
+        vec4 uvTransform{1.f, 1.f, 0.f, 0.f};
+    };
+
+    struct Atlas{
+        u32 width{0};
+        u32 height{0};
+        std::vector<u8> pixels;
+    };
+
+    //shelf packs the tiles, tallest first, into as few atlases as it takes. sizes are multiples of
+    //PADDING so every tile starts on a texel of each of the LEVELS levels
+    std::vector<Atlas> pack(std::span<Tile> tiles);
+}
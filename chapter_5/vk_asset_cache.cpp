@@ -0,0 +1,70 @@
+#include "vk_asset_cache.h"
+
+template<typename T>
+std::optional<T> AssetCache::acquire(std::unordered_map<u64, Entry<T>>& entries, u64 key){
+    auto it = entries.find(key);
+    if(it == entries.end()){
+        misses++;
+        return {};
+    }
+    Entry<T>& entry = it->second;
+    entry.refs++;
+    hits++;
+    savedBytes += entry.bytes;
+    savedMs += entry.createMs;
+    return entry.resource;
+}
+
+template<typename T>
+bool AssetCache::release(std::unordered_map<u64, Entry<T>>& entries, u64 key){
+    auto it = entries.find(key);
+    if(it == entries.end()){
+        return false;
+    }
+    if(--it->second.refs > 0){
+        return false;
+    }
+    entries.erase(it);
+    return true;
+}
+
+std::optional<AssetCache::Texture> AssetCache::acquire_texture(u64 key){
+    return acquire(_textures, key);
+}
+
+std::optional<GPUMeshBuffers> AssetCache::acquire_mesh(u64 key){
+    return acquire(_meshes, key);
+}
+
+void AssetCache::add_texture(u64 key, const Texture& texture, size_t bytes, float createMs){
+    _textures[key] = {texture, 1, bytes, createMs};
+}
+
+void AssetCache::add_mesh(u64 key, const GPUMeshBuffers& mesh, size_t bytes, float createMs){
+    _meshes[key] = {mesh, 1, bytes, createMs};
+}
+
+bool AssetCache::release_texture(u64 key){
+    return release(_textures, key);
+}
+
+bool AssetCache::release_mesh(u64 key){
+    return release(_meshes, key);
+}
+
+size_t AssetCache::resident_bytes() const{
+    size_t bytes = 0;
+    for(auto& [key, entry] : _textures){
+        bytes += entry.bytes;
+    }
+    for(auto& [key, entry] : _meshes){
+        bytes += entry.bytes;
+    }
+    return bytes;
+}
+
+void AssetCache::print_stats() const{
+    fmt::println("asset cache: {} textures, {} meshes ({:.2f} MB), {} hits / {} misses, saved {:.2f} MB and {:.2f} ms",
+        _textures.size(), _meshes.size(), resident_bytes() / (1024.f * 1024.f), hits, misses,
+        savedBytes / (1024.f * 1024.f), savedMs);
+}
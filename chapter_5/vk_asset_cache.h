@@ -0,0 +1,58 @@
+#pragma once
+#include <vk_types.h>
+#include <unordered_map>
+#include <optional>
+
+//process wide cache of the gpu objects of loaded scenes, keyed by a hash of their content (hash.h).
+//identical textures and meshes of different files are created once and reference counted, samplers
+//have their own cache (vk_samplers.h).
+//main thread only, like everything else that creates vulkan objects
+class AssetCache{
+public:
+    struct Texture{
+        AllocatedImage image;
+        //texture streamer handle, UINT32_MAX when it isn't streamed
+        u32 stream{UINT32_MAX};
+    };
+
+private:
+    template<typename T>
+    struct Entry{
+        T resource;
+        u32 refs{0};
+        //gpu memory and creation time, what every further reference saves
+        size_t bytes{0};
+        float createMs{0.f};
+    };
+
+    std::unordered_map<u64, Entry<Texture>> _textures;
+    std::unordered_map<u64, Entry<GPUMeshBuffers>> _meshes;
+
+    template<typename T>
+    std::optional<T> acquire(std::unordered_map<u64, Entry<T>>& entries, u64 key);
+    template<typename T>
+    bool release(std::unordered_map<u64, Entry<T>>& entries, u64 key);
+
+public:
+    //running totals since startup
+    u32 hits{0};
+    u32 misses{0};
+    size_t savedBytes{0};
+    float savedMs{0.f};
+
+    //a new reference to the resource with this content, nothing when it has to be created
+    std::optional<Texture> acquire_texture(u64 key);
+    std::optional<GPUMeshBuffers> acquire_mesh(u64 key);
+
+    //register a resource created after a failed acquire, with one reference
+    void add_texture(u64 key, const Texture& texture, size_t bytes, float createMs);
+    void add_mesh(u64 key, const GPUMeshBuffers& mesh, size_t bytes, float createMs);
+
+    //drop a reference, true when it was the last one and the caller destroys the resource
+    bool release_texture(u64 key);
+    bool release_mesh(u64 key);
+
+    //gpu memory currently held by cached textures and meshes
+    size_t resident_bytes() const;
+    void print_stats() const;
+};
@@ -0,0 +1,148 @@
+#include "vk_bindless.h"
+#include "vk_engine.h"
+#include <vk_descriptors.h>
+
+void BindlessTable::init(VulkanEngine* engine){
+    _engine = engine;
+    VkDevice device = engine->_device;
+
+    //the texture array is written while frames in flight use other slots of it, and only the slots a
+    //material points at have to be valid
+    DescriptorLayoutBuilder builder;
+    builder.add_binding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    builder.add_binding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURES);
+    VkDescriptorBindingFlags bindingFlags[2] = {
+        0,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
+    };
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO};
+    flagsInfo.bindingCount = 2;
+    flagsInfo.pBindingFlags = bindingFlags;
+    layout = builder.build(device, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, &flagsInfo,
+        VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+
+    VkDescriptorPoolSize poolSizes[] = {
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURES}
+    };
+    VkDescriptorPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    VK_CHECK(vkCreateDescriptorPool(device, &poolInfo, nullptr, &_pool));
+
+    VkDescriptorSetAllocateInfo allocInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocInfo.descriptorPool = _pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+    VK_CHECK(vkAllocateDescriptorSets(device, &allocInfo, &set));
+
+    _materials = engine->create_buffer(sizeof(Material) * MAX_MATERIALS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    DescriptorWriter writer;
+    writer.write_buffer(0, _materials.buffer, sizeof(Material) * MAX_MATERIALS, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    writer.update_set(device, set);
+}
+
+void BindlessTable::cleanup(){
+    VkDevice device = _engine->_device;
+    _engine->destroy_buffer(_materials);
+    vkDestroyDescriptorPool(device, _pool, nullptr);
+    vkDestroyDescriptorSetLayout(device, layout, nullptr);
+    _textures.clear();
+    _textureSlots.clear();
+    _materialTextures.clear();
+    _freeTextures.clear();
+    _freeMaterials.clear();
+    _retired.clear();
+}
+
+u32 BindlessTable::acquire_texture(VkImageView view, VkSampler sampler){
+    auto it = _textureSlots.find({view, sampler});
+    if(it != _textureSlots.end()){
+        _textures[it->second].refs++;
+        return it->second;
+    }
+    u32 slot;
+    if(!_freeTextures.empty()){
+        slot = _freeTextures.back();
+        _freeTextures.pop_back();
+    }else if(_textureCount < MAX_TEXTURES){
+        slot = _textureCount++;
+        _textures.push_back({});
+    }else{
+        fmt::println("Bindless texture array is full, drawing with texture 0");
+        _textures[0].refs++;
+        return 0;
+    }
+    _textures[slot] = {view, sampler, 1};
+    _textureSlots[{view, sampler}] = slot;
+
+    //nothing in flight points at a free slot, so it can be written while the set is bound
+    DescriptorWriter writer;
+    writer.write_image(1, view, sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    writer.writes.back().dstArrayElement = slot;
+    writer.update_set(_engine->_device, set);
+    return slot;
+}
+
+void BindlessTable::release_texture(u32 slot){
+    TextureSlot& texture = _textures[slot];
+    if(--texture.refs == 0){
+        _textureSlots.erase({texture.view, texture.sampler});
+        _retired.push_back({slot, true, (u64)_engine->_frameNumber});
+    }
+}
+
+u32 BindlessTable::add_material(const vec4& colorFactor, const vec4& metalRoughnessFactor, VkImageView colorView, VkSampler colorSampler,
+    VkImageView metalRoughView, VkSampler metalRoughSampler){
+    u32 index;
+    if(!_freeMaterials.empty()){
+        index = _freeMaterials.back();
+        _freeMaterials.pop_back();
+    }else if(_materialCount < MAX_MATERIALS){
+        index = _materialCount++;
+        _materialTextures.push_back({});
+    }else{
+        fmt::println("Bindless material table is full, drawing with material 0");
+        return 0;
+    }
+    u32 color = acquire_texture(colorView, colorSampler);
+    u32 metalRough = acquire_texture(metalRoughView, metalRoughSampler);
+    _materialTextures[index] = {color, metalRough};
+
+    Material* materials = (Material*)_materials.allocationInfo.pMappedData;
+    materials[index] = {colorFactor, metalRoughnessFactor, color, metalRough, {0, 0}};
+    return index;
+}
+
+void BindlessTable::rewrite_material(u32 index, const vec4& colorFactor, const vec4& metalRoughnessFactor, VkImageView colorView, VkSampler colorSampler,
+    VkImageView metalRoughView, VkSampler metalRoughSampler){
+    u32 color = acquire_texture(colorView, colorSampler);
+    u32 metalRough = acquire_texture(metalRoughView, metalRoughSampler);
+    release_texture(_materialTextures[index].first);
+    release_texture(_materialTextures[index].second);
+    _materialTextures[index] = {color, metalRough};
+
+    Material* materials = (Material*)_materials.allocationInfo.pMappedData;
+    materials[index] = {colorFactor, metalRoughnessFactor, color, metalRough, {0, 0}};
+}
+
+void BindlessTable::remove_material(u32 index){
+    //also what a full table hands out, it lives as long as the engine
+    if(index == 0){
+        return;
+    }
+    release_texture(_materialTextures[index].first);
+    release_texture(_materialTextures[index].second);
+    _retired.push_back({index, false, (u64)_engine->_frameNumber});
+}
+
+void BindlessTable::update(){
+    u64 frame = (u64)_engine->_frameNumber;
+    while(!_retired.empty() && _retired.front().frame + FRAME_OVERLAP <= frame){
+        const Retired& retired = _retired.front();
+        (retired.texture ? _freeTextures : _freeMaterials).push_back(retired.index);
+        _retired.pop_front();
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vk_types.h>
+#include <vector>
+#include <deque>
+#include <map>
+
+class VulkanEngine;
+
+//one descriptor set shared by every bindless material (shaders/input_structures.glsl with USE_BINDLESS):
+//the constants of all materials in one storage buffer indexed by the material index of the draw, and
+//an update after bind array of every texture they sample. bound once per pipeline, so switching
+//materials costs nothing on the cpu. main thread only
+class BindlessTable{
+public:
+    //one material of the storage buffer, the layout matches the shader
+    struct Material{
+        vec4 colorFactor;
+        vec4 metalRoughnessFactor;
+        //slots in the texture array
+        u32 colorTexture;
+        u32 metalRoughTexture;
+        u32 pad[2];
+    };
+
+    static constexpr u32 MAX_TEXTURES = 4096;
+    static constexpr u32 MAX_MATERIALS = 16384;
+
+private:
+    struct TextureSlot{
+        VkImageView view;
+        VkSampler sampler;
+        u32 refs;
+    };
+    //slot freed in a frame, reused once that frame is out of flight
+    struct Retired{
+        u32 index;
+        bool texture;
+        u64 frame;
+    };
+
+    VulkanEngine* _engine{nullptr};
+    VkDescriptorPool _pool{VK_NULL_HANDLE};
+    AllocatedBuffer _materials;
+
+    std::vector<TextureSlot> _textures;
+    std::map<std::pair<VkImageView, VkSampler>, u32> _textureSlots;
+    //texture slots of every material, released with it
+    std::vector<std::pair<u32, u32>> _materialTextures;
+    std::vector<u32> _freeTextures;
+    std::vector<u32> _freeMaterials;
+    std::deque<Retired> _retired;
+    u32 _textureCount{0};
+    u32 _materialCount{0};
+
+    u32 acquire_texture(VkImageView view, VkSampler sampler);
+    void release_texture(u32 slot);
+
+public:
+    VkDescriptorSetLayout layout{VK_NULL_HANDLE};
+    VkDescriptorSet set{VK_NULL_HANDLE};
+
+    void init(VulkanEngine* engine);
+    void cleanup();
+
+    //write a material and the textures it samples, returns its index. the same view and sampler share a
+    //slot. when a table is full index 0 is returned, the first material added, which is never removed
+    u32 add_material(const vec4& colorFactor, const vec4& metalRoughnessFactor, VkImageView colorView, VkSampler colorSampler,
+        VkImageView metalRoughView, VkSampler metalRoughSampler);
+    //write a material again under the same index, for material 0 which can't be replaced by a new one.
+    //frames in flight draw with the old or the new textures, the old slots are reused FRAME_OVERLAP frames later
+    void rewrite_material(u32 index, const vec4& colorFactor, const vec4& metalRoughnessFactor, VkImageView colorView, VkSampler colorSampler,
+        VkImageView metalRoughView, VkSampler metalRoughSampler);
+    //frames in flight may still draw with it, the slots are only reused FRAME_OVERLAP frames later
+    void remove_material(u32 index);
+    //recycle the slots that are out of flight, once per frame
+    void update();
+};
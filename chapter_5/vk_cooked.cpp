@@ -0,0 +1,195 @@
+#include "vk_cooked.h"
+#include <cstdio>
+#include <algorithm>
+
+namespace cooked{
+
+//sections start on this alignment so the records can be read in place
+constexpr u64 SECTION_ALIGNMENT = 16;
+
+String Writer::add_string(std::string_view str){
+    String s;
+    s.offset = (u32)strings.size();
+    s.length = (u32)str.size();
+    strings.append(str);
+    return s;
+}
+
+bool Writer::write(ccharp path) const{
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.inputs = inputs;
+
+    //lay the sections out one after the other behind the header
+    u64 offset = sizeof(Header);
+    auto place = [&](Range& range, u64 count, u64 stride){
+        offset = (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+        range.offset = offset;
+        range.count = count;
+        offset += count * stride;
+    };
+    place(header.vertices, vertices.size(), sizeof(Vertex));
+    place(header.indices, indices.size(), sizeof(u32));
+    place(header.meshes, meshes.size(), sizeof(Mesh));
+    place(header.surfaces, surfaces.size(), sizeof(Surface));
+    place(header.materials, materials.size(), sizeof(Material));
+    place(header.samplers, samplers.size(), sizeof(Sampler));
+    place(header.textures, textures.size(), sizeof(Texture));
+    place(header.nodes, nodes.size(), sizeof(Node));
+    place(header.children, children.size(), sizeof(u32));
+    place(header.texels, texels.size(), 1);
+    place(header.strings, strings.size(), 1);
+    header.fileSize = offset;
+
+    FILE* file = fopen(path, "wb");
+    if(file == nullptr){
+        return false;
+    }
+    bool ok = true;
+    u64 written = 0;
+    auto put = [&](const Range& range, const void* data, u64 size){
+        //zero padding up to the section
+        static const u8 zeros[SECTION_ALIGNMENT]{};
+        if(range.offset > written){
+            ok &= fwrite(zeros, 1, range.offset - written, file) == range.offset - written;
+        }
+        if(size > 0){
+            ok &= fwrite(data, 1, size, file) == size;
+        }
+        written = range.offset + size;
+    };
+    ok &= fwrite(&header, sizeof(Header), 1, file) == 1;
+    written = sizeof(Header);
+    put(header.vertices, vertices.data(), vertices.size() * sizeof(Vertex));
+    put(header.indices, indices.data(), indices.size() * sizeof(u32));
+    put(header.meshes, meshes.data(), meshes.size() * sizeof(Mesh));
+    put(header.surfaces, surfaces.data(), surfaces.size() * sizeof(Surface));
+    put(header.materials, materials.data(), materials.size() * sizeof(Material));
+    put(header.samplers, samplers.data(), samplers.size() * sizeof(Sampler));
+    put(header.textures, textures.data(), textures.size() * sizeof(Texture));
+    put(header.nodes, nodes.data(), nodes.size() * sizeof(Node));
+    put(header.children, children.data(), children.size() * sizeof(u32));
+    put(header.texels, texels.data(), texels.size());
+    put(header.strings, strings.data(), strings.size());
+    ok &= fclose(file) == 0;
+    return ok;
+}
+
+bool Scene::open(ccharp path){
+    _header = nullptr;
+    if(!_file.open(path)){
+        return false;
+    }
+    if(_file.size() < sizeof(Header)){
+        fmt::println("Cooked scene {} is truncated", path);
+        return false;
+    }
+    const Header* header = (const Header*)_file.data();
+    if(header->magic != MAGIC){
+        fmt::println("{} is not a cooked scene", path);
+        return false;
+    }
+    if(header->version != VERSION){
+        fmt::println("Cooked scene {} has version {}, expected {}", path, header->version, VERSION);
+        return false;
+    }
+    if(header->fileSize != _file.size()){
+        fmt::println("Cooked scene {} is truncated", path);
+        return false;
+    }
+
+    //every section inside the file and aligned, every record pointing inside its section
+    auto fits = [&](const Range& range, u64 stride){
+        return range.offset % SECTION_ALIGNMENT == 0 && range.offset <= header->fileSize &&
+            range.count <= (header->fileSize - range.offset) / stride;
+    };
+    bool valid = fits(header->vertices, sizeof(Vertex)) && fits(header->indices, sizeof(u32)) &&
+        fits(header->meshes, sizeof(Mesh)) && fits(header->surfaces, sizeof(Surface)) &&
+        fits(header->materials, sizeof(Material)) && fits(header->samplers, sizeof(Sampler)) &&
+        fits(header->textures, sizeof(Texture)) && fits(header->nodes, sizeof(Node)) &&
+        fits(header->children, sizeof(u32)) && fits(header->texels, 1) && fits(header->strings, 1);
+    if(valid){
+        _header = header;
+        auto inside = [](u64 first, u64 count, u64 total){
+            return first <= total && count <= total - first;
+        };
+        auto name = [&](String str){
+            return inside(str.offset, str.length, header->strings.count);
+        };
+        for(const Mesh& mesh : meshes()){
+            valid &= name(mesh.name) && inside(mesh.firstVertex, mesh.vertexCount, header->vertices.count) &&
+                inside(mesh.firstIndex, mesh.indexCount, header->indices.count) &&
+                inside(mesh.firstSurface, mesh.surfaceCount, header->surfaces.count);
+        }
+        for(const Mesh& mesh : meshes()){
+            if(!inside(mesh.firstVertex, mesh.vertexCount, header->vertices.count) || !inside(mesh.firstIndex, mesh.indexCount, header->indices.count) ||
+                !inside(mesh.firstSurface, mesh.surfaceCount, header->surfaces.count)){
+                continue;
+            }
+            //meshlet building, quantization and the vertex shader all index the mesh vertices with these
+            for(u32 index : indices().subspan(mesh.firstIndex, mesh.indexCount)){
+                valid &= index < mesh.vertexCount;
+            }
+            for(const Surface& surface : surfaces().subspan(mesh.firstSurface, mesh.surfaceCount)){
+                valid &= surface.material < (i32)header->materials.count && surface.lodCount <= MAX_SURFACE_LODS &&
+                    inside(surface.startIndex, surface.count, mesh.indexCount);
+                for(u32 l = 0; l < std::min(surface.lodCount, MAX_SURFACE_LODS); ++l){
+                    valid &= inside(surface.lods[l].startIndex, surface.lods[l].count, mesh.indexCount);
+                }
+            }
+        }
+        for(const Material& material : materials()){
+            valid &= name(material.name) && material.colorImage < (i32)header->textures.count &&
+                material.colorSampler < (i32)header->samplers.count;
+        }
+        for(const Texture& texture : textures()){
+            valid &= name(texture.name) && name(texture.uri) && inside(texture.texelOffset, texture.texelSize, header->texels.count);
+            //rgba8 texels, an encoded KTX2 file without a size or none at all for textures that point at an image file
+            valid &= texture.texelSize == 0 || texture.texelSize == (u64)texture.width * texture.height * 4 ||
+                (texture.width == 0 && texture.height == 0);
+        }
+        for(const Node& node : nodes()){
+            valid &= name(node.name) && inside(node.firstChild, node.childCount, header->children.count) &&
+                node.mesh < (i32)header->meshes.count;
+        }
+        for(u32 child : children()){
+            valid &= child < header->nodes.count;
+        }
+        //the nodes have to form a forest, refreshTransform would recurse forever around a cycle. with no node
+        //the child of two parents, the nodes that can't be reached from a root are exactly the ones in cycles
+        if(valid){
+            std::vector<u8> parented(header->nodes.count, 0);
+            for(const Node& node : nodes()){
+                for(u32 child : children().subspan(node.firstChild, node.childCount)){
+                    valid &= parented[child] == 0;
+                    parented[child] = 1;
+                }
+            }
+            std::vector<u32> stack;
+            for(u32 n = 0; n < header->nodes.count; ++n){
+                if(!parented[n]){
+                    stack.push_back(n);
+                }
+            }
+            u64 reached = 0;
+            while(valid && !stack.empty()){
+                const Node& node = nodes()[stack.back()];
+                stack.pop_back();
+                reached++;
+                for(u32 child : children().subspan(node.firstChild, node.childCount)){
+                    stack.push_back(child);
+                }
+            }
+            valid &= reached == header->nodes.count;
+        }
+    }
+    if(!valid){
+        fmt::println("Cooked scene {} is corrupt", path);
+        _header = nullptr;
+        return false;
+    }
+    return true;
+}
+
+}
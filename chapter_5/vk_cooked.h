@@ -0,0 +1,171 @@
+#pragma once
+#include <vk_types.h>
+#include <FileUtils.h>
+#include "vk_loader.h"
+#include <type_traits>
+
+//cooked scene: a glTF file converted offline by chapter_5_cooker into one binary blob the runtime maps
+//and reads in place. every section is an array of fixed size records, vertices and indices are
+//already in the layout uploadMesh() takes. native endianness, any layout change bumps VERSION
+namespace cooked{
+
+constexpr u32 MAGIC = 0x4b4f4f43;//"COOK"
+constexpr u32 VERSION = 4;
+//extension appended to the source path, like .spv for shaders
+constexpr ccharp EXTENSION = ".cooked";
+
+//choices the cooker made that the runtime makes as well, a file cooked with other ones is skipped
+enum Inputs : u32{
+    //the source has textures with a KHR_texture_basisu image
+    HAS_BASISU = 1 << 0,
+    //and the materials sample those images, the cooker could transcode them
+    BASISU_SOURCES = 1 << 1,
+};
+
+//records of a section, offset in bytes from the start of the file
+struct Range{
+    u64 offset;
+    u64 count;
+};
+
+//characters in the string section
+struct String{
+    u32 offset;
+    u32 length;
+};
+
+struct Header{
+    u32 magic;
+    u32 version;
+    u64 fileSize;
+    u32 inputs;         //Inputs
+    u32 pad;
+    Range vertices;     //Vertex
+    Range indices;      //u32
+    Range meshes;       //Mesh
+    Range surfaces;     //Surface
+    Range materials;    //Material
+    Range samplers;     //Sampler
+    Range textures;     //Texture
+    Range nodes;        //Node
+    Range children;     //u32 node index
+    Range texels;       //u8
+    Range strings;      //char
+};
+
+struct Mesh{
+    String name;
+    u32 firstSurface;
+    u32 surfaceCount;
+    u32 firstVertex;
+    u32 vertexCount;
+    u32 firstIndex;
+    u32 indexCount;
+};
+
+struct Surface{
+    //relative to the mesh, indices already point at the mesh vertices
+    u32 startIndex;
+    u32 count;
+    Bounds bounds;
+    //-1 for the default material
+    i32 material;
+    //simplified levels, their ranges are relative to the mesh like startIndex
+    u32 lodCount;
+    SurfaceLod lods[MAX_SURFACE_LODS];
+};
+
+struct Material{
+    String name;
+    vec4 colorFactor;
+    vec4 metalRoughnessFactor;
+    u32 passType;
+    i32 colorImage;
+    i32 colorSampler;
+};
+
+struct Sampler{
+    u32 magFilter;
+    u32 minFilter;
+    u32 mipmapMode;
+};
+
+//tightly packed rgba8 texels in the texel section, an embedded KTX2 file there (width and height 0, its
+//levels stay in their file format) or the path of an image file
+struct Texture{
+    String name;
+    //relative to the cooked file
+    String uri;
+    u32 width;
+    u32 height;
+    u64 texelOffset;
+    u64 texelSize;
+};
+
+struct Node{
+    String name;
+    i32 mesh;
+    u32 firstChild;
+    u32 childCount;
+    mat4 localTransform;
+};
+
+//the sections are read with a plain cast, keep every record trivially copyable
+static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<Mesh> && std::is_trivially_copyable_v<Surface> &&
+    std::is_trivially_copyable_v<Material> && std::is_trivially_copyable_v<Texture> && std::is_trivially_copyable_v<Node> &&
+    std::is_trivially_copyable_v<Vertex>);
+
+//in memory scene the cooker fills, write() lays it out on disk
+struct Writer{
+    std::vector<Vertex> vertices;
+    std::vector<u32> indices;
+    std::vector<Mesh> meshes;
+    std::vector<Surface> surfaces;
+    std::vector<Material> materials;
+    std::vector<Sampler> samplers;
+    std::vector<Texture> textures;
+    std::vector<Node> nodes;
+    std::vector<u32> children;
+    std::vector<u8> texels;
+    std::string strings;
+    u32 inputs{0};
+
+    String add_string(std::string_view str);
+    bool write(ccharp path) const;
+};
+
+//cooked file mapped in memory, the spans point into the mapping and live as long as the scene
+class Scene{
+    MappedFile _file;
+    const Header* _header{nullptr};
+
+    template<typename T>
+    std::span<const T> section(const Range& range) const{
+        return std::span<const T>((const T*)(_file.data() + range.offset), range.count);
+    }
+
+public:
+    //map the file and validate it, false for missing, truncated, outdated or corrupt files. corrupt covers
+    //ranges outside their section, indices past the mesh vertices, texel sizes that aren't rgba8 and node
+    //graphs that aren't a forest
+    bool open(ccharp path);
+
+    std::span<const Vertex> vertices() const { return section<Vertex>(_header->vertices); }
+    std::span<const u32> indices() const { return section<u32>(_header->indices); }
+    std::span<const Mesh> meshes() const { return section<Mesh>(_header->meshes); }
+    std::span<const Surface> surfaces() const { return section<Surface>(_header->surfaces); }
+    std::span<const Material> materials() const { return section<Material>(_header->materials); }
+    std::span<const Sampler> samplers() const { return section<Sampler>(_header->samplers); }
+    std::span<const Texture> textures() const { return section<Texture>(_header->textures); }
+    std::span<const Node> nodes() const { return section<Node>(_header->nodes); }
+    std::span<const u32> children() const { return section<u32>(_header->children); }
+    std::span<const u8> texels(const Texture& texture) const {
+        return std::span<const u8>(_file.data() + _header->texels.offset + texture.texelOffset, texture.texelSize);
+    }
+    u32 inputs() const { return _header->inputs; }
+    std::string_view string(String str) const {
+        return std::string_view((const char*)_file.data() + _header->strings.offset + str.offset, str.length);
+    }
+};
+
+}
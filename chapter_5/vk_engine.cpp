@@ -23,6 +23,7 @@
 #include <array>
 #include <chrono>
 #include <thread>
+#include <limits>
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -99,6 +100,8 @@ void VulkanEngine::init(){
             peng->oldYPos = fypos;            
         });
     
+    _threadPool.init();
+
     init_vulkan();
 
     init_swapchain();
@@ -122,10 +125,8 @@ void VulkanEngine::init(){
     mainCamera.pitch = 0.f;
     mainCamera.yaw = 0.f;
 
-    std::string structurePath = "../assets/structure.glb";
-    auto structureFile = loadGltf(this,structurePath);
-    assert(structureFile.has_value());
-    loadedScenes["structure"] = *structureFile;
+    //drawn progressively as the loader thread and the upload queue catch up
+    loadedScenes["structure"] = loadGltfAsync(this,scenePath);
 
     _isInitialized = true;
 }
@@ -134,6 +135,10 @@ void VulkanEngine::cleanup(){
     if(_isInitialized){
 
         if(_device!=VK_NULL_HANDLE){
+            //loader threads may still queue work, stop them before anything is destroyed
+            _threadPool.shutdown();
+            _mainThreadJobs.clear();
+
             vkDeviceWaitIdle(_device);
 
             loadedScenes.clear();
@@ -245,31 +250,52 @@ void VulkanEngine::draw(){
     //start the command buffer recording
     VK_CHECK(vkBeginCommandBuffer(cmd, &cmdBeginInfo));
 
-    //make the swapchain image into writeable mode before rendering
-    vkutil::transition_image(cmd, _drawImage.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+    //take ownership of everything the upload queue finished since last frame
+    u64 uploadValue = _uploader.record_acquires(cmd);
+    //textures acquired just now get their mip chains before anything samples them
+    _mipGenerator.record(cmd);
+    stats.mip_dispatches = (int)_mipGenerator.computeCount;
+    stats.mip_blits = (int)_mipGenerator.blitCount;
+
+    VkImage swapchainImage = _swapchainImages[swapchainImageIndex];
+    //the swapchain image comes back from presentation with nothing worth keeping, the acquire
+    //semaphore is waited on at color attachment output
+    _barriers.track(swapchainImage, VK_IMAGE_ASPECT_COLOR_BIT,
+        {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE});
+    _barriers.barrierCount = 0;
+    _barriers.flushCount = 0;
+
+    //make the draw image writeable for the background, last frame's contents are not needed
+    _barriers.use(_drawImage.image, vkutil::ImageUse::ComputeWrite, true);
+    _barriers.flush(cmd);
 
     draw_background(cmd);
 
-    vkutil::transition_image(cmd, _drawImage.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-    vkutil::transition_image(cmd, _depthImage.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
-    draw_geometry(cmd);
+    _barriers.use(_drawImage.image, vkutil::ImageUse::ColorAttachment);
+    _barriers.use(_depthImage.image, vkutil::ImageUse::DepthAttachment, true);
+    _barriers.flush(cmd);
 
-    //make the swapchain image into presentable mode
-    vkutil::transition_image(cmd, _drawImage.image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-    vkutil::transition_image(cmd, _swapchainImages[swapchainImageIndex], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    draw_geometry(cmd);
 
-    //
+    _barriers.use(_drawImage.image, vkutil::ImageUse::TransferSrc);
+    _barriers.use(swapchainImage, vkutil::ImageUse::TransferDst, true);
+    _barriers.flush(cmd);
 
     //execute a copy from the draw image into the swapchain
-    vkutil::copy_image_to_image(cmd, _drawImage.image, _swapchainImages[swapchainImageIndex], _drawExtent, _swapchainExtent);
+    vkutil::copy_image_to_image(cmd, _drawImage.image, swapchainImage, _drawExtent, _swapchainExtent);
 
     //set swapchain image layout to Attachment Optimal so we can draw it
-    vkutil::transition_image(cmd, _swapchainImages[swapchainImageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    
+    _barriers.use(swapchainImage, vkutil::ImageUse::ColorAttachment);
+    _barriers.flush(cmd);
+
     //draw imgui into the swapchain image
     draw_imgui(cmd, _swapchainImageViews[swapchainImageIndex]);
-    
-    vkutil::transition_image(cmd, _swapchainImages[swapchainImageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+    //make the swapchain image into presentable mode
+    _barriers.use(swapchainImage, vkutil::ImageUse::Present);
+    _barriers.flush(cmd);
+    stats.barrier_count = (int)_barriers.barrierCount;
+    stats.barrier_batches = (int)_barriers.flushCount;
 
     //finialize the command buffer (we can no longer add commands, but it can now be executed)
     VK_CHECK(vkEndCommandBuffer(cmd));
@@ -280,10 +306,15 @@ void VulkanEngine::draw(){
 
     VkCommandBufferSubmitInfo cmdinfo = vkinit::command_buffer_submit_info(cmd);
 
-    VkSemaphoreSubmitInfo waitInfo = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, get_current_frame()._swapchainSemaphore);
+    VkSemaphoreSubmitInfo waitInfos[2];
+    waitInfos[0] = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, get_current_frame()._swapchainSemaphore);
+    //the acquired uploads are already complete, waiting on the timeline just orders them before this frame
+    waitInfos[1] = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, _uploader.timeline());
+    waitInfos[1].value = uploadValue;
     VkSemaphoreSubmitInfo signalInfo = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT, get_current_frame()._renderSemaphore);
 
-    VkSubmitInfo2 submit = vkinit::submit_info(&cmdinfo, &signalInfo, &waitInfo);
+    VkSubmitInfo2 submit = vkinit::submit_info(&cmdinfo, &signalInfo, waitInfos);
+    submit.waitSemaphoreInfoCount = uploadValue > 0 ? 2 : 1;
 
     //submit command buffer to the queue and execute it
     //_renderFence will now block until the graphic commands finish execution
@@ -323,7 +354,7 @@ void VulkanEngine::draw_imgui(VkCommandBuffer cmd, VkImageView targetImageView){
     vkCmdEndRendering(cmd);
 }
 
-bool is_visible(const RenderObject & obj, const mat4& viewproj){
+bool is_visible(const Bounds& bounds, const mat4& transform, const mat4& viewproj){
     std::array<vec3, 8> corners{
         vec3(1.f,  1.f,  1.f),
         vec3(1.f,  1.f, -1.f),
@@ -335,18 +366,18 @@ bool is_visible(const RenderObject & obj, const mat4& viewproj){
         vec3(-1.f,-1.f, -1.f)
     };
 
-    mat4 matrix = viewproj * obj.transform;
+    mat4 matrix = viewproj * transform;
 
     vec3 min={1.5f,1.5f,1.5f};
     vec3 max={-1.5f,-1.5,-1.5f};
 
     for(i32 c = 0; c < 8; ++c){
         //project each corner into clip space
-        vec4 v = matrix * vec4(obj.bounds.origin + (corners[c] * obj.bounds.extents), 1.f);
+        vec4 v = matrix * vec4(bounds.origin + (corners[c] * bounds.extents), 1.f);
 
         //perspective correction
         v.x = v.x / v.w;
-        v.y = v.z / v.w;
+        v.y = v.y / v.w;
         v.z = v.z / v.w;
 
         min = glm::min(vec3(v),min);
@@ -360,6 +391,48 @@ bool is_visible(const RenderObject & obj, const mat4& viewproj){
     return true;
 }
 
+//coarsest level of the surface whose error stays under maxPixelError on screen. projectionScale converts
+//a size at distance 1 into pixels
+u32 select_lod(const GeoSurface& surface, const mat4& transform, vec3 cameraPosition, float projectionScale, float maxPixelError){
+    if(surface.lodCount == 0){
+        return 0;
+    }
+    float scale = std::max(std::max(glm::length(vec3(transform[0])), glm::length(vec3(transform[1]))), glm::length(vec3(transform[2])));
+    vec3 center = vec3(transform * vec4(surface.bounds.origin, 1.f));
+    //nearest point of the bounding sphere, anything closer than that is drawn at full detail
+    float distance = glm::length(center - cameraPosition) - surface.bounds.sphereRadius * scale;
+    if(distance <= 0.f){
+        return 0;
+    }
+    float pixelsPerUnit = projectionScale / distance;
+    u32 lod = 0;
+    while(lod < surface.lodCount && surface.lods[lod].error * scale * pixelsPerUnit <= maxPixelError){
+        lod++;
+    }
+    return lod;
+}
+
+//create info of a default sampler, the cache applies the global filtering on top
+static VkSamplerCreateInfo default_sampler_info(VkFilter filter){
+    VkSamplerCreateInfo smpl{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    smpl.magFilter = filter;
+    smpl.minFilter = filter;
+    return smpl;
+}
+
+//pixels the diameter of the bounding sphere covers on screen. the texture is assumed to span the surface
+//once, which is what the residency request turns into a mip level
+static float projected_size(const Bounds& bounds, const mat4& transform, vec3 cameraPosition, float projectionScale){
+    float scale = std::max(std::max(glm::length(vec3(transform[0])), glm::length(vec3(transform[1]))), glm::length(vec3(transform[2])));
+    vec3 center = vec3(transform * vec4(bounds.origin, 1.f));
+    float radius = bounds.sphereRadius * scale;
+    float distance = glm::length(center - cameraPosition) - radius;
+    if(distance <= 0.f){
+        return std::numeric_limits<float>::max();
+    }
+    return 2.f * radius * projectionScale / distance;
+}
+
 void VulkanEngine::draw_geometry(VkCommandBuffer cmd){
 
     //reset counters
@@ -373,23 +446,80 @@ void VulkanEngine::draw_geometry(VkCommandBuffer cmd){
     opaque_draws.reserve(mainDrawContext.OpaqueSurfaces.size());
 
     for(size_t i=0; i < mainDrawContext.OpaqueSurfaces.size(); i++){
-        if(is_visible(mainDrawContext.OpaqueSurfaces[i], sceneData.viewproj)){
+        const RenderObject& r = mainDrawContext.OpaqueSurfaces[i];
+        if(is_visible(mainDrawContext.bounds[r.boundsIndex], mainDrawContext.transforms[r.transformIndex], sceneData.viewproj)){
             opaque_draws.push_back((u32)i);
         }
         
     }
 
-    //sort the opaque surfaces by material and mesh
+    //sort the opaque surfaces by material set, index type and mesh. materials packed into the same atlas
+    //may share a set, so the set is the key rather than the material. bindless materials share one
+    //pipeline and set, so there only the index buffer binds are left to save
     std::sort(opaque_draws.begin(), opaque_draws.end(), [&](const auto& iA, const auto& iB){
         const RenderObject& A = mainDrawContext.OpaqueSurfaces[iA];
         const RenderObject& B = mainDrawContext.OpaqueSurfaces[iB];
-        if(A.material == B.material){
-            return A.indexBuffer < B.indexBuffer;
-        }else{
-            return A.material < B.material;
+        VkDescriptorSet setA = mainDrawContext.materials[A.materialId]->materialSet;
+        VkDescriptorSet setB = mainDrawContext.materials[B.materialId]->materialSet;
+        if(!bindlessMaterials && setA != setB){
+            return setA < setB;
         }
+        if(A.indexType != B.indexType){
+            return A.indexType < B.indexType;
+        }
+        return A.meshId < B.meshId;
     });
 
+    //level of detail from the projected error, 0 is the full surface
+    float projectionScale = std::abs(sceneData.proj[1][1]) * _drawExtent.height * 0.5f;
+    stats.lod_draws = 0;
+    auto lod_of = [&](const RenderObject& r){
+        if(!useLods){
+            return 0u;
+        }
+        const MeshAsset* mesh = mainDrawContext.meshes[r.meshId];
+        u32 lod = select_lod(mesh->surfaces[r.surfaceIndex], mainDrawContext.transforms[r.transformIndex], mainCamera.position, projectionScale, lodPixelError);
+        stats.lod_draws += lod > 0;
+        return lod;
+    };
+    std::vector<u32> opaque_lods(opaque_draws.size());
+    for(size_t i = 0; i < opaque_draws.size(); ++i){
+        opaque_lods[i] = lod_of(mainDrawContext.OpaqueSurfaces[opaque_draws[i]]);
+    }
+
+    //tell the streamer how large every drawn texture is on screen, it keeps the levels that covers
+    auto request_texture = [&](const RenderObject& r){
+        u32 stream = mainDrawContext.materialStreams[r.materialId];
+        if(stream != UINT32_MAX){
+            _textureStreamer.request(stream, projected_size(mainDrawContext.bounds[r.boundsIndex], mainDrawContext.transforms[r.transformIndex],
+                mainCamera.position, projectionScale));
+        }
+    };
+    for(u32 i : opaque_draws){
+        request_texture(mainDrawContext.OpaqueSurfaces[i]);
+    }
+    for(const RenderObject& r : mainDrawContext.TransparentSurfaces){
+        request_texture(r);
+    }
+
+    //queue the full detail opaque surfaces that have meshlets for gpu culling, the rest is drawn whole
+    std::vector<u32> meshlet_draws(opaque_draws.size(), UINT32_MAX);
+    _meshletCuller.begin(sceneData.viewproj, mainCamera.position, meshletConeCulling);
+    if(meshletCulling){
+        for(size_t i = 0; i < opaque_draws.size(); ++i){
+            if(opaque_lods[i] > 0){
+                continue;
+            }
+            const RenderObject& r = mainDrawContext.OpaqueSurfaces[opaque_draws[i]];
+            const MeshAsset* mesh = mainDrawContext.meshes[r.meshId];
+            meshlet_draws[i] = _meshletCuller.add(mainDrawContext.transforms[r.transformIndex], mesh->meshBuffers, mesh->surfaces[r.surfaceIndex]);
+        }
+    }
+    //compute has to be recorded outside of the render pass
+    _meshletCuller.record(cmd);
+    stats.meshlet_draws = (int)_meshletCuller.drawCount;
+    stats.meshlet_count = (int)_meshletCuller.meshletCount;
+
     //allocate a new uniform buffer for the scene data
     AllocatedBuffer gpuSceneDataBuffer = create_buffer(sizeof(GPUSceneData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
     //add it to the deletion queue of this frame so it gets deleted once its been used
@@ -442,15 +572,21 @@ void VulkanEngine::draw_geometry(VkCommandBuffer cmd){
    //defined outside of the draw function, this is the state we will try to skip
    MaterialPipeline* lastPipeline=nullptr;
    MaterialInstance* lastMaterial=nullptr;
+   VkDescriptorSet lastMaterialSet = VK_NULL_HANDLE;
    VkBuffer lastIndexBuffer = VK_NULL_HANDLE;
-    auto draw = [&](const RenderObject&r){
-        if(r.material != lastMaterial){   
-            lastMaterial = r.material;
+   stats.material_binds = 0;
+    auto draw = [&](const RenderObject&r, u32 meshletDraw, u32 lod){
+        //resolve the handles against the side tables
+        MaterialInstance* material = mainDrawContext.materials[r.materialId];
+        const MeshAsset* mesh = mainDrawContext.meshes[r.meshId];
+        const GeoSurface& surface = mesh->surfaces[r.surfaceIndex];
+        if(material != lastMaterial){   
+            lastMaterial = material;
             //rebind pipeline and descriptors if the material has changed
-            if(r.material->pipeline != lastPipeline){
-                lastPipeline = r.material->pipeline; 
-                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, r.material->pipeline->pipeline);
-                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, r.material->pipeline->layout, 0, 1, &globalDescriptor, 0, nullptr);
+            if(material->pipeline != lastPipeline){
+                lastPipeline = material->pipeline; 
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, material->pipeline->pipeline);
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, material->pipeline->layout, 0, 1, &globalDescriptor, 0, nullptr);
                 //set dynamic viewport and scissor
                 VkViewport viewport{};
                 viewport.x = 0.f;
@@ -469,32 +605,56 @@ void VulkanEngine::draw_geometry(VkCommandBuffer cmd){
                 scissor.extent.height = _drawExtent.height;
 
                 vkCmdSetScissor(cmd, 0, 1, &scissor);
+                if(bindlessMaterials){
+                    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, material->pipeline->layout, 1, 1, &_bindless.set, 0, nullptr);
+                    stats.material_binds++;
+                }
+                //the pipeline change may have disturbed set 1
+                lastMaterialSet = VK_NULL_HANDLE;
             }
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, r.material->pipeline->layout, 1, 1, &r.material->materialSet,0,nullptr);
-            if(r.indexBuffer != lastIndexBuffer){
-                lastIndexBuffer = r.indexBuffer;
-                vkCmdBindIndexBuffer(cmd,r.indexBuffer,0, VK_INDEX_TYPE_UINT32);
+            //bindless materials are picked by the index in the push constants, materials sharing a set
+            //only differ by what is pushed per draw
+            if(material->materialSet != VK_NULL_HANDLE && material->materialSet != lastMaterialSet){
+                lastMaterialSet = material->materialSet;
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, material->pipeline->layout, 1, 1, &material->materialSet,0,nullptr);
+                stats.material_binds++;
             }
         }
+        //meshes change more often than materials, so check the index buffer on every draw
+        if(mesh->meshBuffers.indexBuffer.buffer != lastIndexBuffer){
+            lastIndexBuffer = mesh->meshBuffers.indexBuffer.buffer;
+            vkCmdBindIndexBuffer(cmd,lastIndexBuffer,0, (VkIndexType)r.indexType);
+        }
         GPUDrawPushConstants push_constants;    
-        push_constants.vertexBuffer = r.vertexBufferAddress;
-        push_constants.worldMatrix = r.transform;
+        push_constants.vertexBuffer = mesh->meshBuffers.vertexBufferAddress;
+        push_constants.worldMatrix = mainDrawContext.transforms[r.transformIndex];
+        push_constants.vertexFormat = mesh->meshBuffers.vertexFormat;
+        push_constants.materialIndex = material->bindlessIndex;
+        push_constants.positionOffset = vec4(mesh->meshBuffers.positionOffset, 0.f);
+        push_constants.positionScale = vec4(mesh->meshBuffers.positionScale, 0.f);
+        push_constants.uvTransform = material->uvTransform;
         
         vkCmdPushConstants(cmd, _meshPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GPUDrawPushConstants), &push_constants);
-        vkCmdDrawIndexed(cmd,r.indexCount, 1, r.firstIndex, 0, 0);
+        u32 startIndex = lod > 0 ? surface.lods[lod - 1].startIndex : surface.startIndex;
+        u32 count = lod > 0 ? surface.lods[lod - 1].count : surface.count;
+        if(meshletDraw != UINT32_MAX){
+            _meshletCuller.draw(cmd, meshletDraw);
+        }else{
+            vkCmdDrawIndexed(cmd, count, 1, startIndex, 0, 0);
+        }
 
-        //add counters for trianles and draws
+        //add counters for trianles and draws, meshlet draws count the whole surface
         stats.drawcall_count++;
-        stats.triangle_count += r.indexCount / 3;
+        stats.triangle_count += count / 3;
         
     };
 
-    for(auto&r : opaque_draws){//mainDrawContext.OpaqueSurfaces){
-        draw(mainDrawContext.OpaqueSurfaces[r]);
+    for(size_t i = 0; i < opaque_draws.size(); ++i){
+        draw(mainDrawContext.OpaqueSurfaces[opaque_draws[i]], meshlet_draws[i], opaque_lods[i]);
     }
 
     for(auto&r : mainDrawContext.TransparentSurfaces){
-        draw(r);
+        draw(r, UINT32_MAX, lod_of(r));
     }
 
 
@@ -508,13 +668,85 @@ void VulkanEngine::draw_geometry(VkCommandBuffer cmd){
     
 }
 
+void VulkanEngine::run_on_main_thread(std::function<void()>&& job){
+    std::lock_guard<std::mutex> lock(_mainThreadMutex);
+    _mainThreadJobs.push_back(std::move(job));
+}
+
+void VulkanEngine::process_main_thread_jobs(float budgetMs){
+    auto start = std::chrono::system_clock::now();
+    //everything uploaded this frame goes out in one submit
+    UploadBatchScope uploadBatch(_uploader);
+    while(true){
+        std::function<void()> job;
+        {
+            std::lock_guard<std::mutex> lock(_mainThreadMutex);
+            if(_mainThreadJobs.empty()){
+                break;
+            }
+            job = std::move(_mainThreadJobs.front());
+            _mainThreadJobs.pop_front();
+        }
+        job();
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - start);
+        if(elapsed.count() / 1000.f >= budgetMs){
+            break;
+        }
+    }
+}
+
+void VulkanEngine::refresh_default_samplers(){
+    if(_defaultSamplerGeneration == _samplers.generation){
+        return;
+    }
+    _defaultSamplerGeneration = _samplers.generation;
+    //the old samplers are destroyed once the frames in flight with them are done
+    VkSampler nearest = _samplers.acquire(default_sampler_info(VK_FILTER_NEAREST));
+    VkSampler linear = _samplers.acquire(default_sampler_info(VK_FILTER_LINEAR));
+    _samplers.release(_defaultSamplerNearest);
+    _samplers.release(_defaultSamplerLinear);
+    _defaultSamplerNearest = nearest;
+    _defaultSamplerLinear = linear;
+
+    _defaultMaterialResources.colorSampler = linear;
+    _defaultMaterialResources.metalRoughSampler = linear;
+    if(bindlessMaterials){
+        //material 0 is also what a full table hands out, it keeps its index
+        _bindless.rewrite_material(defaultData.bindlessIndex, _defaultMaterialConstants.colorFactor, _defaultMaterialConstants.metalRoughnessFactor,
+            _defaultMaterialResources.colorImage.imageView, linear, _defaultMaterialResources.metalRoughImage.imageView, linear);
+    }else{
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        if(!_retiredDefaultSets.empty() && _retiredDefaultSets.front().second + FRAME_OVERLAP <= (u64)_frameNumber){
+            set = _retiredDefaultSets.front().first;
+            _retiredDefaultSets.pop_front();
+        }
+        _retiredDefaultSets.push_back({defaultData.materialSet, (u64)_frameNumber});
+        defaultData = metalRoughMaterial.write_material(_device, MaterialPass::MainColor, _defaultMaterialResources, globalDescriptorAllocator, set);
+    }
+    _defaultMaterial->data = defaultData;
+}
+
 void VulkanEngine::update_scene(){
     auto start = std::chrono::system_clock::now();
+    //ahead of the scenes built below, which write their materials with the default samplers
+    refresh_default_samplers();
+    //finish the loading work handed over by the worker threads
+    process_main_thread_jobs(2.f);
+    //next round of texture mips, then bump the materials that can use more of them
+    _textureStreamer.update();
+    stats.streaming_textures = (int)_textureStreamer.streamingCount;
+    stats.streamed_bytes = _textureStreamer.bytesLastFrame;
+    stats.texture_resident_bytes = _textureStreamer.residentBytes;
+    stats.starved_textures = (int)_textureStreamer.starvedCount;
+    if(bindlessMaterials){
+        _bindless.update();
+    }
+    _samplers.update();
+
     mainCamera.update();
     mat4 view = mainCamera.getViewMatrix();
 
-    mainDrawContext.OpaqueSurfaces.clear();
-    mainDrawContext.TransparentSurfaces.clear();
+    mainDrawContext.clear();
 
     loadedNodes["Suzanne"]->Draw(mat4(1.f),mainDrawContext);
 
@@ -577,6 +809,36 @@ void VulkanEngine::run(){
             ImGui::Text("update time %f ms", stats.scene_update_time);
             ImGui::Text("triangles %i", stats.triangle_count);
             ImGui::Text("draw %i", stats.drawcall_count);
+            ImGui::Text("material binds %i", stats.material_binds);
+            if(!bindlessMaterials){
+                //below one set per material when materials share atlases, or have no texture and equal constants
+                size_t materialCount = 0;
+                size_t setCount = 0;
+                for(auto& [name, scene] : loadedScenes){
+                    materialCount += scene->materialList.size();
+                    setCount += scene->materialSets.size();
+                }
+                ImGui::Text("material sets %zu for %zu materials", setCount, materialCount);
+            }
+            ImGui::Text("streaming textures %i (%zu KB)", stats.streaming_textures, stats.streamed_bytes / 1024);
+            if(_textureStreamer.memoryBudget > 0){
+                ImGui::Text("texture residency %.1f / %.1f MB, %i textures starved", stats.texture_resident_bytes / (1024.f * 1024.f),
+                    _textureStreamer.memoryBudget / (1024.f * 1024.f), stats.starved_textures);
+            }
+            ImGui::Text("mip generation %i dispatches, %i blits", stats.mip_dispatches, stats.mip_blits);
+            ImGui::Text("barriers %i in %i batches", stats.barrier_count, stats.barrier_batches);
+            ImGui::Text("meshlet culling %i surfaces, %i meshlets", stats.meshlet_draws, stats.meshlet_count);
+            ImGui::Text("lod %i simplified draws", stats.lod_draws);
+            ImGui::Text("asset cache %u hits, saved %.2f MB %.2f ms", _assetCache.hits, _assetCache.savedBytes / (1024.f * 1024.f), _assetCache.savedMs);
+            ImGui::Text("samplers %zu", _samplers.size());
+            //loaded materials pick the new settings up on their next draw
+            float anisotropy = _samplers.anisotropy();
+            float lodBias = _samplers.lod_bias();
+            bool filteringChanged = ImGui::SliderFloat("anisotropy", &anisotropy, 1.f, _samplers.max_anisotropy());
+            filteringChanged |= ImGui::SliderFloat("lod bias", &lodBias, -2.f, 2.f);
+            if(filteringChanged){
+                _samplers.set_filtering(anisotropy, lodBias);
+            }
             ImGui::End();
             // if(ImGui::Begin("background")){
             //     ImGui::SliderFloat("Render Scale", &renderScale, 0.3f, 1.f);
@@ -643,6 +905,13 @@ void VulkanEngine::init_vulkan(){
     VkPhysicalDeviceVulkan12Features features12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
     features12.bufferDeviceAddress = VK_TRUE;
     features12.descriptorIndexing = VK_TRUE;
+    //the bindless material table, all part of what descriptorIndexing guarantees
+    features12.runtimeDescriptorArray = VK_TRUE;
+    features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    features12.descriptorBindingPartiallyBound = VK_TRUE;
+    features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    features12.timelineSemaphore = VK_TRUE;
 
     //use vkbootstrap to select gpu.
     //we want a gpu that can write to the surface and supports vulkan 1.3 with the correct features
@@ -654,6 +923,32 @@ void VulkanEngine::init_vulkan(){
                             .select()
                             .value();
 
+    //block compressed textures from KTX2 files, optional. without it basis universal transcodes to rgba8
+    VkPhysicalDeviceFeatures compression{};
+    compression.textureCompressionBC = VK_TRUE;
+    _bcSupported = physicalDevice.enable_features_if_present(compression);
+    _basisTarget = _bcSupported ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_R8G8B8A8_UNORM;
+    //anisotropic filtering for the sampler cache, optional as well
+    VkPhysicalDeviceFeatures anisotropy{};
+    anisotropy.samplerAnisotropy = VK_TRUE;
+    _anisotropySupported = physicalDevice.enable_features_if_present(anisotropy);
+    //the compute mip generator indexes its array of level views, without it mips are blitted
+    VkPhysicalDeviceFeatures storageIndexing{};
+    storageIndexing.shaderStorageImageArrayDynamicIndexing = VK_TRUE;
+    _storageImageIndexingSupported = physicalDevice.enable_features_if_present(storageIndexing);
+    //meshlet culling draws whatever survived with batches of vkCmdDrawIndexedIndirectCount, optional too.
+    //without them every surface is drawn whole
+    VkPhysicalDeviceFeatures multiDraw{};
+    multiDraw.multiDrawIndirect = VK_TRUE;
+    VkPhysicalDeviceVulkan12Features indirectCount{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    indirectCount.drawIndirectCount = VK_TRUE;
+    _indirectCountSupported = physicalDevice.enable_features_if_present(multiDraw) &&
+        physicalDevice.enable_extension_features_if_present(indirectCount);
+    if(!_indirectCountSupported && meshletCulling){
+        fmt::println("multiDrawIndirect or drawIndirectCount missing, meshlet culling is off");
+        meshletCulling = false;
+    }
+
     //create the final vulkan device
     vkb::DeviceBuilder deviceBuilder(physicalDevice);
 
@@ -667,6 +962,16 @@ void VulkanEngine::init_vulkan(){
     _graphicsQueue = vkbDevice.get_queue(vkb::QueueType::graphics).value();
     _graphicsQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::graphics).value();
 
+    //prefer a dedicated transfer queue for uploads, fall back to the graphics queue
+    auto transferQueue = vkbDevice.get_dedicated_queue(vkb::QueueType::transfer);
+    if(transferQueue.has_value()){
+        _transferQueue = transferQueue.value();
+        _transferQueueFamily = vkbDevice.get_dedicated_queue_index(vkb::QueueType::transfer).value();
+    }else{
+        _transferQueue = _graphicsQueue;
+        _transferQueueFamily = _graphicsQueueFamily;
+    }
+
     //init vma 
     VmaAllocatorCreateInfo allocatorInfo{};
     allocatorInfo.physicalDevice = physicalDevice;
@@ -677,6 +982,11 @@ void VulkanEngine::init_vulkan(){
     _mainDeletionQueue.push_function([&](){
         vmaDestroyAllocator(_allocator);
     });
+
+    _samplers.init(this, _anisotropySupported);
+    _mainDeletionQueue.push_function([&](){
+        _samplers.cleanup();
+    });
 }
 
 void VulkanEngine::create_swapchain(u32 width, u32 height){
@@ -746,6 +1056,9 @@ void VulkanEngine::init_swapchain(){
 
     VK_CHECK(vkCreateImageView(_device, &dview_info, nullptr, &_depthImage.imageView));
 
+    //both start out undefined, every frame discards them on first use
+    _barriers.track(_drawImage.image, VK_IMAGE_ASPECT_COLOR_BIT);
+    _barriers.track(_depthImage.image, VK_IMAGE_ASPECT_DEPTH_BIT);
 
     //add to deletion queues
     _mainDeletionQueue.push_function([=](){
@@ -764,6 +1077,7 @@ void VulkanEngine::destroy_swapchain(){
 
         for(size_t i=0; i< _swapchainImageViews.size(); ++i){
             vkDestroyImageView(_device, _swapchainImageViews[i], nullptr);
+            _barriers.forget(_swapchainImages[i]);
         }
         
     }
@@ -806,6 +1120,13 @@ void VulkanEngine::init_commands(){
     _mainDeletionQueue.push_function([=](){
         vkDestroyCommandPool(_device, _immCommandPool, nullptr);
     });
+
+    _uploader.init(this, _transferQueue, _transferQueueFamily, _graphicsQueueFamily);
+    _textureStreamer.init(this);
+    _mainDeletionQueue.push_function([&](){
+        _textureStreamer.cleanup();
+        _uploader.cleanup();
+    });
 }
 
 void VulkanEngine::init_sync_structures(){
@@ -917,7 +1238,25 @@ void VulkanEngine::init_pipelines(){
 
     init_mesh_pipeline();
 
+    //the material pipelines are built against its layout
+    if(bindlessMaterials){
+        _bindless.init(this);
+        _mainDeletionQueue.push_function([&](){
+            _bindless.cleanup();
+        });
+    }
+
     metalRoughMaterial.build_pipelines(this);
+
+    _mipGenerator.init(this);
+    _mainDeletionQueue.push_function([&](){
+        _mipGenerator.cleanup();
+    });
+
+    _meshletCuller.init(this);
+    _mainDeletionQueue.push_function([&](){
+        _meshletCuller.cleanup();
+    });
 }
 
 void VulkanEngine::init_triangle_pipeline(){
@@ -1141,18 +1480,13 @@ void VulkanEngine::init_default_data(){
     _errorCheckerboardImage = create_image(pixels.data(), VkExtent3D{16, 16, 1}, VK_FORMAT_R8G8B8A8_UNORM,
         VK_IMAGE_USAGE_SAMPLED_BIT);
 
-    VkSamplerCreateInfo smpl{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
-    smpl.magFilter = VK_FILTER_NEAREST;
-    smpl.minFilter = VK_FILTER_NEAREST;
-    vkCreateSampler(_device, &smpl, nullptr, &_defaultSamplerNearest);
-
-    smpl.magFilter = VK_FILTER_LINEAR;
-    smpl.minFilter = VK_FILTER_LINEAR;
-    vkCreateSampler(_device, &smpl, nullptr, &_defaultSamplerLinear);
+    _defaultSamplerNearest = _samplers.acquire(default_sampler_info(VK_FILTER_NEAREST));
+    _defaultSamplerLinear = _samplers.acquire(default_sampler_info(VK_FILTER_LINEAR));
+    _defaultSamplerGeneration = _samplers.generation;
 
     _mainDeletionQueue.push_function([&](){
-        vkDestroySampler(_device, _defaultSamplerNearest, nullptr);
-        vkDestroySampler(_device, _defaultSamplerLinear, nullptr);
+        _samplers.release(_defaultSamplerNearest);
+        _samplers.release(_defaultSamplerLinear);
 
         destroy_image(_whiteImage);
         destroy_image(_greyImage);
@@ -1160,7 +1494,7 @@ void VulkanEngine::init_default_data(){
         destroy_image(_errorCheckerboardImage);
     });
 
-    GLTFMetallic_Roughness::MaterialResources materialResources;
+    GLTFMetallic_Roughness::MaterialResources& materialResources = _defaultMaterialResources;
     //default the material textures
     materialResources.colorImage = _whiteImage;
     materialResources.colorSampler = _defaultSamplerLinear;
@@ -1174,6 +1508,7 @@ void VulkanEngine::init_default_data(){
     GLTFMetallic_Roughness::MaterialConstants* sceneUniformData = (GLTFMetallic_Roughness::MaterialConstants*)materialConstants.allocation->GetMappedData();
     sceneUniformData->colorFactor = vec4(1.f);
     sceneUniformData->metalRoughnessFactor = vec4(1.f, 0.5f, 0.f, 0.f);
+    _defaultMaterialConstants = *sceneUniformData;
 
     _mainDeletionQueue.push_function([=, this](){
         destroy_buffer(materialConstants);
@@ -1182,7 +1517,13 @@ void VulkanEngine::init_default_data(){
     materialResources.dataBuffer  = materialConstants.buffer;
     materialResources.dataBufferOffset = 0;
 
-    defaultData = metalRoughMaterial.write_material(_device, MaterialPass::MainColor, materialResources, globalDescriptorAllocator);
+    if(bindlessMaterials){
+        //the first material of the table, never removed
+        defaultData = metalRoughMaterial.write_material(MaterialPass::MainColor, materialResources, *sceneUniformData, _bindless);
+    }else{
+        defaultData = metalRoughMaterial.write_material(_device, MaterialPass::MainColor, materialResources, globalDescriptorAllocator);
+    }
+    _defaultMaterial = std::make_shared<GLTFMaterial>(defaultData);
     
     testMeshes = loadGltfMeshes(this,"../assets/basicmesh.glb").value();
 
@@ -1193,7 +1534,7 @@ void VulkanEngine::init_default_data(){
         newNode->worldTransform = mat4(1.f);
 
         for(auto& s : newNode->mesh->surfaces){
-            s.material = std::make_shared<GLTFMaterial>(defaultData);
+            s.material = _defaultMaterial;
         }
         loadedNodes[m->name] = std::move(newNode);
     }
@@ -1220,8 +1561,8 @@ VkShaderModule VulkanEngine::get_shader(ccharp shaderSrcPath, VkShaderStageFlagB
     }
 
     if(needCompile){
-        if(!vkutil::compile_shader_module(shaderSrcPath, _device, VK_SHADER_STAGE_COMPUTE_BIT, &shader)){
-            fmt::print("Error when building the compute shader\n");
+        if(!vkutil::compile_shader_module(shaderSrcPath, _device, stage, &shader)){
+            fmt::print("Error when building the shader {}\n", shaderSrcPath);
             return VK_NULL_HANDLE;
         }
     }
@@ -1338,14 +1679,16 @@ void VulkanEngine::destroy_buffer(const AllocatedBuffer& buffer){
 }
 
 AllocatedImage VulkanEngine::create_image(VkExtent3D size, VkFormat format, VkImageUsageFlags usage, bool mipmapped){
+    return allocate_image(size, format, usage, mipmapped ? vkutil::mip_level_count(size.width, size.height) : 1);
+}
+
+AllocatedImage VulkanEngine::allocate_image(VkExtent3D size, VkFormat format, VkImageUsageFlags usage, u32 mipLevels){
     AllocatedImage newImage;
     newImage.imageFormat = format;
     newImage.imageExtent = size;
 
     VkImageCreateInfo img_info = vkinit::image_create_info(format, usage, size);
-    if(mipmapped){
-        img_info.mipLevels = static_cast<u32>(std::floor(std::log2(std::max(size.width, size.height))))+1;
-    }
+    img_info.mipLevels = mipLevels;
 
     //always allocate images on dedicated GPU memory
     VmaAllocationCreateInfo allocInfo{};
@@ -1364,7 +1707,7 @@ AllocatedImage VulkanEngine::create_image(VkExtent3D size, VkFormat format, VkIm
 
     //build a image-view for the image
     VkImageViewCreateInfo view_info = vkinit::imageview_create_info(format, newImage.image, aspectFlag);
-    view_info.subresourceRange.layerCount = img_info.mipLevels;
+    view_info.subresourceRange.levelCount = img_info.mipLevels;
 
     VK_CHECK(vkCreateImageView(_device, &view_info, nullptr, &newImage.imageView));
 
@@ -1372,32 +1715,36 @@ AllocatedImage VulkanEngine::create_image(VkExtent3D size, VkFormat format, VkIm
 }
 
 AllocatedImage VulkanEngine::create_image(void* data, VkExtent3D size, VkFormat format, VkImageUsageFlags usage, bool mipmapped){
-    size_t data_size = size.depth * size.width * size.height * 4;
-    AllocatedBuffer uploadbuffer = create_buffer(data_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
-
-    memcpy(uploadbuffer.allocationInfo.pMappedData, data, data_size);
-
-    AllocatedImage new_image = create_image(size, format, usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, mipmapped);
-
-    immediate_submit([&](VkCommandBuffer cmd){
-        vkutil::transition_image(cmd, new_image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    size_t data_size = size.depth * vkutil::image_level_size(format, size.width, size.height, 0);
+    mipmapped = mipmapped && !vkutil::is_block_compressed(format);
 
-        VkBufferImageCopy copyRegion{};
-        
-        copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        copyRegion.imageSubresource.layerCount = 1;
-        copyRegion.imageExtent = size;
+    usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    if(mipmapped && _mipGenerator.supports(format, size)){
+        //the compute mip generator writes the levels as storage images
+        usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    }
+    AllocatedImage new_image = create_image(size, format, usage, mipmapped);
 
-        //copy the buffer into the image
-        vkCmdCopyBufferToImage(cmd, uploadbuffer.buffer, new_image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
-            &copyRegion);
+    //copy goes through the upload queue, the image is usable once its ticket is ready
+    _uploader.upload_image(data, data_size, new_image);
+    new_image.uploadTicket = _uploader.submit();
+    if(mipmapped){
+        //recorded in the same frame the upload is acquired, so the ticket covers the mips too
+        _mipGenerator.queue(new_image, new_image.uploadTicket);
+    }
 
-        vkutil::transition_image(cmd, new_image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    });
+    return new_image;
+}
 
-    destroy_buffer(uploadbuffer);
+AllocatedImage VulkanEngine::create_image(const MipChain& mips, VkImageUsageFlags usage){
+    VkExtent3D size{mips.width, mips.height, 1};
+    AllocatedImage new_image = allocate_image(size, mips.format, usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT, (u32)mips.levels.size());
 
+    //the first level moves the whole chain into transfer dst, the rest share its barrier
+    for(u32 level = 0; level < mips.levels.size(); ++level){
+        _uploader.upload_image(mips.levels[level].data(), mips.levels[level].size(), new_image, level, level == 0);
+    }
+    new_image.uploadTicket = _uploader.submit();
     return new_image;
 }
 
@@ -1406,11 +1753,35 @@ void VulkanEngine::destroy_image(const AllocatedImage& img){
     vmaDestroyImage(_allocator, img.image, img.allocation);
 }
 
-GPUMeshBuffers VulkanEngine::uploadMesh(std::span<u32> indices, std::span<Vertex> vertices){
-    const size_t vertexBufferSize = vertices.size() * sizeof(Vertex);
-    const size_t indexBufferSize = indices.size() * sizeof(u32);
+GPUMeshBuffers VulkanEngine::uploadMesh(std::span<const u32> indices, std::span<const Vertex> vertices){
+    return upload_mesh_buffers(indices, vertices.size(), vertices.data(), vertices.size() * sizeof(Vertex));
+}
+
+GPUMeshBuffers VulkanEngine::uploadMesh(std::span<const u16> indices, std::span<const Vertex> vertices){
+    return upload_mesh_buffers(indices.data(), indices.size() * sizeof(u16), VK_INDEX_TYPE_UINT16, vertices.data(), vertices.size() * sizeof(Vertex));
+}
+
+GPUMeshBuffers VulkanEngine::uploadMesh(std::span<const u32> indices, std::span<const PackedVertex> vertices, vec3 positionOffset, vec3 positionScale){
+    GPUMeshBuffers newMesh = upload_mesh_buffers(indices, vertices.size(), vertices.data(), vertices.size() * sizeof(PackedVertex));
+    newMesh.vertexFormat = VertexFormat::Packed;
+    newMesh.positionOffset = positionOffset;
+    newMesh.positionScale = positionScale;
+    return newMesh;
+}
+
+GPUMeshBuffers VulkanEngine::upload_mesh_buffers(std::span<const u32> indices, size_t vertexCount, const void* vertices, size_t vertexBufferSize){
+    //every index of a mesh this small fits in 16 bits, halving the index buffer
+    if(vertexCount <= 65536){
+        std::vector<u16> narrowed(indices.begin(), indices.end());
+        return upload_mesh_buffers(narrowed.data(), narrowed.size() * sizeof(u16), VK_INDEX_TYPE_UINT16, vertices, vertexBufferSize);
+    }
+    return upload_mesh_buffers(indices.data(), indices.size() * sizeof(u32), VK_INDEX_TYPE_UINT32, vertices, vertexBufferSize);
+}
+
+GPUMeshBuffers VulkanEngine::upload_mesh_buffers(const void* indices, size_t indexBufferSize, VkIndexType indexType, const void* vertices, size_t vertexBufferSize){
 
     GPUMeshBuffers newMesh;
+    newMesh.indexType = indexType;
 
     //create vertex buffer
     newMesh.vertexBuffer = create_buffer(vertexBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
@@ -1425,36 +1796,31 @@ GPUMeshBuffers VulkanEngine::uploadMesh(std::span<u32> indices, std::span<Vertex
     newMesh.indexBuffer = create_buffer(indexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         VMA_MEMORY_USAGE_GPU_ONLY);
 
-    AllocatedBuffer staging = create_buffer(vertexBufferSize + indexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+    //vertices are pulled through the buffer address in the vertex shader
+    _uploader.upload_buffer(vertices, vertexBufferSize, newMesh.vertexBuffer.buffer, 0,
+        VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+    _uploader.upload_buffer(indices, indexBufferSize, newMesh.indexBuffer.buffer, 0,
+        VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT);
+    newMesh.uploadTicket = _uploader.submit();
 
-    void * data = staging.allocation->GetMappedData();
-
-    //copy vertex buffer
-    memcpy(data, vertices.data(),vertexBufferSize);
-    //copy index buffer
-    memcpy((char*)data+vertexBufferSize,indices.data(),indexBufferSize);
-
-    immediate_submit([&](VkCommandBuffer cmd){
-        VkBufferCopy vertexCopy{0};
-        vertexCopy.dstOffset = 0;
-        vertexCopy.srcOffset = 0;
-        vertexCopy.size = vertexBufferSize;
-
-        vkCmdCopyBuffer(cmd, staging.buffer, newMesh.vertexBuffer.buffer, 1, &vertexCopy);
+    return newMesh;
 
-        VkBufferCopy indexCopy{};
-        indexCopy.dstOffset = 0;
-        indexCopy.srcOffset = vertexBufferSize;
-        indexCopy.size = indexBufferSize;
 
-        vkCmdCopyBuffer(cmd, staging.buffer, newMesh.indexBuffer.buffer, 1, &indexCopy);
-    });
-
-    destroy_buffer(staging);
+}
 
-    return newMesh;
+void VulkanEngine::uploadMeshlets(GPUMeshBuffers& mesh, std::span<const Meshlet> meshlets){
+    const size_t meshletBufferSize = meshlets.size() * sizeof(Meshlet);
+    mesh.meshletBuffer = create_buffer(meshletBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY);
 
+    VkBufferDeviceAddressInfo addrInfo{VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+    addrInfo.buffer = mesh.meshletBuffer.buffer;
+    mesh.meshletBufferAddress = vkGetBufferDeviceAddress(_device, &addrInfo);
 
+    _uploader.upload_buffer(meshlets.data(), meshletBufferSize, mesh.meshletBuffer.buffer, 0,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+    //the mesh is drawn once its ticket is ready, make it cover the meshlets too
+    mesh.uploadTicket = _uploader.submit();
 }
 
 void VulkanEngine::centreWindow()
@@ -1516,9 +1882,11 @@ void VulkanEngine::centreWindow()
 }
 
 void GLTFMetallic_Roughness::build_pipelines(VulkanEngine * engine){    
-    ccharp meshFragPath = "../shaders/mesh.frag";
+    //the bindless shaders read the material out of the table by the index in the push constants
+    bool bindless = engine->bindlessMaterials;
+    ccharp meshFragPath = bindless ? "../shaders/mesh_pbr.frag" : "../shaders/mesh.frag";
     const VkShaderModule meshFragShader = engine->get_shader(meshFragPath, VK_SHADER_STAGE_FRAGMENT_BIT);    
-    ccharp meshVertPath = "../shaders/mesh.vert";
+    ccharp meshVertPath = bindless ? "../shaders/mesh_bindless.vert" : "../shaders/mesh.vert";
     const VkShaderModule meshVertexShader = engine->get_shader(meshVertPath, VK_SHADER_STAGE_VERTEX_BIT);
 
     VkPushConstantRange matrixRange{};
@@ -1533,7 +1901,7 @@ void GLTFMetallic_Roughness::build_pipelines(VulkanEngine * engine){
 
     materialLayout = layoutBuilder.build(engine->_device, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
 
-    VkDescriptorSetLayout layouts[] = {engine->_gpuSceneDataDescriptorLayout, materialLayout};
+    VkDescriptorSetLayout layouts[] = {engine->_gpuSceneDataDescriptorLayout, bindless ? engine->_bindless.layout : materialLayout};
 
     VkPipelineLayoutCreateInfo mesh_layout_info = vkinit::pipeline_layout_create_info();
     mesh_layout_info.setLayoutCount = 2;
@@ -1580,7 +1948,8 @@ void GLTFMetallic_Roughness::build_pipelines(VulkanEngine * engine){
 
 }
 
-MaterialInstance GLTFMetallic_Roughness::write_material(VkDevice device, MaterialPass pass, const MaterialResources & resources, DescriptorAllocatorGrowable& descriptorAllocator){
+MaterialInstance GLTFMetallic_Roughness::write_material(VkDevice device, MaterialPass pass, const MaterialResources & resources, DescriptorAllocatorGrowable& descriptorAllocator,
+    VkDescriptorSet set){
     MaterialInstance matData;
     matData.passType = pass;
     if(pass == MaterialPass::Transparent){
@@ -1589,9 +1958,9 @@ MaterialInstance GLTFMetallic_Roughness::write_material(VkDevice device, Materia
         matData.pipeline = &opaquePipeline;
     }
 
-    matData.materialSet = descriptorAllocator.allocate(device, materialLayout);
+    matData.materialSet = set != VK_NULL_HANDLE ? set : descriptorAllocator.allocate(device, materialLayout);
 
-    writer.clear();
+    DescriptorWriter writer;
     writer.write_buffer(0, resources.dataBuffer, sizeof(MaterialConstants), resources.dataBufferOffset, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
     writer.write_image(1, resources.colorImage.imageView, resources.colorSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
     writer.write_image(2, resources.metalRoughImage.imageView, resources.metalRoughSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
@@ -1600,18 +1969,87 @@ MaterialInstance GLTFMetallic_Roughness::write_material(VkDevice device, Materia
     return matData;
 }
 
+MaterialInstance GLTFMetallic_Roughness::write_material(MaterialPass pass, const MaterialResources& resources, const MaterialConstants& constants, BindlessTable& table){
+    MaterialInstance matData;
+    matData.passType = pass;
+    if(pass == MaterialPass::Transparent){
+        matData.pipeline = &transparentPipeline;
+    }else{
+        matData.pipeline = &opaquePipeline;
+    }
+    matData.materialSet = VK_NULL_HANDLE;
+    matData.bindlessIndex = table.add_material(constants.colorFactor, constants.metalRoughnessFactor, resources.colorImage.imageView, resources.colorSampler,
+        resources.metalRoughImage.imageView, resources.metalRoughSampler);
+    return matData;
+}
+
+u32 DrawContext::add_transform(const mat4& transform){
+    transforms.push_back(transform);
+    return (u32)transforms.size()-1;
+}
+
+u32 DrawContext::add_mesh(const MeshAsset* mesh){
+    u32 drawId = mesh->drawId.value();
+    if(drawId >= meshSlots.size()){
+        meshSlots.resize(drawId + 1);
+    }
+    Slot& slot = meshSlots[drawId];
+    if(slot.frame != frame){
+        slot = {frame, (u32)meshes.size()};
+        meshes.push_back(mesh);
+    }
+    return slot.id;
+}
+
+u32 DrawContext::add_material(GLTFMaterial* material){
+    u32 drawId = material->drawId.value();
+    if(drawId >= materialSlots.size()){
+        materialSlots.resize(drawId + 1);
+    }
+    Slot& slot = materialSlots[drawId];
+    if(slot.frame != frame){
+        slot = {frame, (u32)materials.size()};
+        materials.push_back(&material->data);
+        materialStreams.push_back(material->textureStream);
+    }
+    return slot.id;
+}
+
+void DrawContext::clear(){
+    //vector clear keeps the capacity and the slots go stale with the frame stamp, so once the tables
+    //cover every id nothing allocates
+    OpaqueSurfaces.clear();
+    TransparentSurfaces.clear();
+    transforms.clear();
+    bounds.clear();
+    meshes.clear();
+    materials.clear();
+    materialStreams.clear();
+    frame++;
+}
+
 void MeshNode::Draw(const mat4& topMatrix, DrawContext&ctx){
+    //the buffers are not created yet or still in flight on the upload queue
+    if(mesh->meshBuffers.indexBuffer.buffer == VK_NULL_HANDLE || !VulkanEngine::Get()._uploader.is_ready(mesh->meshBuffers.uploadTicket)){
+        Node::Draw(topMatrix, ctx);
+        return;
+    }
     mat4 nodeMatrix = topMatrix * worldTransform;
 
-    for(auto& s : mesh->surfaces){
+    //one transform and one mesh entry per node, shared by all of its surfaces
+    u32 transformIndex = ctx.add_transform(nodeMatrix);
+    u32 meshId = ctx.add_mesh(mesh.get());
+
+    for(u32 i = 0; i < (u32)mesh->surfaces.size(); ++i){
+        const GeoSurface& s = mesh->surfaces[i];
         RenderObject def;
-        def.indexCount = s.count;
-        def.firstIndex = s.startIndex;
-        def.indexBuffer = mesh->meshBuffers.indexBuffer.buffer;
-        def.material = &s.material->data;
-        def.bounds = s.bounds;
-        def.transform = nodeMatrix;
-        def.vertexBufferAddress = mesh->meshBuffers.vertexBufferAddress;
+        def.meshId = meshId;
+        def.surfaceIndex = i;
+        def.materialId = ctx.add_material(s.material.get());
+        def.transformIndex = transformIndex;
+        def.boundsIndex = (u32)ctx.bounds.size();
+        def.indexType = mesh->meshBuffers.indexType;
+        ctx.bounds.push_back(s.bounds);
         if(s.material->data.passType == MaterialPass::Transparent){
             ctx.TransparentSurfaces.push_back(def);
         }else{
@@ -8,6 +8,16 @@
 #include <deque>
 #include <functional>
 #include "vk_loader.h"
+#include "vk_upload.h"
+#include "vk_streaming.h"
+#include "vk_mipgen.h"
+#include "vk_meshlets.h"
+#include "vk_asset_cache.h"
+#include "vk_bindless.h"
+#include "vk_samplers.h"
+#include <meshes.h>
+#include <thread_pool.h>
+#include <mutex>
 #include <camera.h>
 
 struct DeletionQueue{
@@ -51,16 +61,18 @@ struct ComputeEffect{
     ComputePushConstants data;
 };
 
+//compact draw record, the heavy data lives in the DrawContext side tables
 struct RenderObject{
-    u32 indexCount;
-    u32 firstIndex;
-    VkBuffer indexBuffer;
-    MaterialInstance * material;
-    Bounds bounds;
-    mat4 transform;
-    VkDeviceAddress vertexBufferAddress;
+    u32 meshId;         //index into DrawContext::meshes
+    u32 surfaceIndex;   //index into MeshAsset::surfaces
+    u32 materialId;     //index into DrawContext::materials
+    u32 transformIndex; //index into DrawContext::transforms
+    u32 boundsIndex;    //index into DrawContext::bounds
+    u32 indexType;      //VkIndexType of the mesh index buffer, part of the sort key
 };
 
+static_assert(sizeof(RenderObject) == 24);
+
 struct GLTFMetallic_Roughness{
     MaterialPipeline opaquePipeline;
     MaterialPipeline transparentPipeline;
@@ -82,17 +94,45 @@ struct GLTFMetallic_Roughness{
         u32 dataBufferOffset;
     };
 
-    DescriptorWriter writer;
-
     void build_pipelines(VulkanEngine*engine);
     void clear_resources(VkDevice device);
-    MaterialInstance write_material(VkDevice device, MaterialPass pass, const MaterialResources&resources, DescriptorAllocatorGrowable& DescriptorAllocator);
+    //set is written over instead of allocating a new one when given, no frame in flight may still use it.
+    //reentrant, threads may write materials at once as long as each allocates from its own allocator
+    MaterialInstance write_material(VkDevice device, MaterialPass pass, const MaterialResources&resources, DescriptorAllocatorGrowable& DescriptorAllocator,
+        VkDescriptorSet set = VK_NULL_HANDLE);
+    //bindless variant, the constants and textures go into the table instead of a set of their own.
+    //dataBuffer is not used
+    MaterialInstance write_material(MaterialPass pass, const MaterialResources& resources, const MaterialConstants& constants, BindlessTable& table);
 };
 
 
 struct DrawContext{
     std::vector<RenderObject> OpaqueSurfaces;
     std::vector<RenderObject> TransparentSurfaces;
+
+    //side tables (SoA), culling only walks bounds/transforms and sorting only the records
+    std::vector<mat4> transforms;
+    std::vector<Bounds> bounds;
+    std::vector<const MeshAsset*> meshes;
+    std::vector<MaterialInstance*> materials;
+    //texture streamer handle of each material's texture, UINT32_MAX when it has none
+    std::vector<u32> materialStreams;
+
+    //dedup so the same mesh/material always maps to the same id within a frame. indexed by DrawId, a
+    //slot holds the id of this frame when its stamp is the current frame, so nothing is hashed or
+    //cleared per frame
+    struct Slot{
+        u32 frame{0};
+        u32 id{0};
+    };
+    std::vector<Slot> meshSlots;
+    std::vector<Slot> materialSlots;
+    u32 frame{1};
+
+    u32 add_transform(const mat4& transform);
+    u32 add_mesh(const MeshAsset* mesh);
+    u32 add_material(GLTFMaterial* material);
+    void clear();
 };
 
 
@@ -107,6 +147,18 @@ struct EngineStats{
     int drawcall_count;
     float scene_update_time;
     float mesh_draw_time;
+    int streaming_textures;
+    size_t streamed_bytes;
+    size_t texture_resident_bytes;
+    int starved_textures;
+    int mip_dispatches;
+    int mip_blits;
+    int meshlet_draws;
+    int meshlet_count;
+    int lod_draws;
+    int barrier_count;
+    int barrier_batches;
+    int material_binds;
 };
 
 constexpr unsigned int FRAME_OVERLAP = 2;//max frames?
@@ -150,6 +202,16 @@ class VulkanEngine{
     VkInstance _instance{VK_NULL_HANDLE};
     VkDebugUtilsMessengerEXT _debug_messenger;
     VkPhysicalDevice _physical{VK_NULL_HANDLE};
+    //textureCompressionBC, enabled when the device has it
+    bool _bcSupported{false};
+    //what basis universal textures are transcoded to, BC7 with BC support and rgba8 without
+    VkFormat _basisTarget{VK_FORMAT_R8G8B8A8_UNORM};
+    //samplerAnisotropy, enabled when the device has it
+    bool _anisotropySupported{false};
+    //shaderStorageImageArrayDynamicIndexing, for the compute mip generator
+    bool _storageImageIndexingSupported{false};
+    //multiDrawIndirect and drawIndirectCount, meshlet culling needs both
+    bool _indirectCountSupported{false};
     VkDevice _device{VK_NULL_HANDLE};
     VkSurfaceKHR _surface{VK_NULL_HANDLE};
 
@@ -161,6 +223,10 @@ class VulkanEngine{
     VkQueue _graphicsQueue{VK_NULL_HANDLE};
     u32 _graphicsQueueFamily{UINT32_MAX};
 
+    //dedicated transfer queue, same as the graphics queue if the device has none
+    VkQueue _transferQueue{VK_NULL_HANDLE};
+    u32 _transferQueueFamily{UINT32_MAX};
+
     VkSwapchainKHR _swapchain{VK_NULL_HANDLE};
     VkFormat _swapchainImageFormat{VK_FORMAT_UNDEFINED};
 
@@ -175,6 +241,8 @@ class VulkanEngine{
     //draw resources
     AllocatedImage _drawImage;
     AllocatedImage _depthImage;
+    //layout/stage/access of the draw, depth and swapchain images
+    vkutil::BarrierBuilder _barriers;
     VkExtent2D _drawExtent;
     float renderScale = 1.f;
 
@@ -186,6 +254,8 @@ class VulkanEngine{
 
     VkSampler _defaultSamplerLinear;
     VkSampler _defaultSamplerNearest;
+    //SamplerCache::generation the default samplers were acquired with
+    u32 _defaultSamplerGeneration{0};
 
     DescriptorAllocatorGrowable globalDescriptorAllocator;
 
@@ -213,12 +283,69 @@ class VulkanEngine{
     VkCommandBuffer _immCommandBuffer;
     VkCommandPool _immCommandPool;
 
+    //asynchronous mesh/texture uploads
+    UploadService _uploader;
+    //mip by mip upload of loaded textures
+    TextureStreamer _textureStreamer;
+    //mip chains of uploaded textures, built on the gpu
+    MipGenerator _mipGenerator;
+    //gpu culling of the meshlets of opaque surfaces
+    MeshletCuller _meshletCuller;
+    //gpu objects shared by every loaded scene, keyed by content
+    AssetCache _assetCache;
+    //constants and textures of every material when bindlessMaterials is set
+    BindlessTable _bindless;
+    //every sampler, shared by identical create infos. holds the global anisotropy and lod bias
+    SamplerCache _samplers;
+    //file loaded at init, a glTF file (or its cooked copy) or an OBJ file with its MTL materials
+    std::string scenePath{"../assets/structure.glb"};
+    //parser of loaded glTF files, can be switched between loads
+    GltfBackend gltfBackend{GltfBackend::FastGltf};
+    //the tinygltf backend decodes images on the pool while meshes convert instead of while parsing
+    bool parallelImageDecode{true};
+    //loaded textures stream cpu built mips instead of generating them on the gpu
+    bool streamTextures{false};
+    //materials live in one bindless table instead of a descriptor set each, so draws only rebind
+    //when the pipeline changes. read by init, can't be switched afterwards
+    bool bindlessMaterials{true};
+    //loaded meshes are uploaded in the 16 byte PackedVertex format instead of the 48 byte Vertex
+    bool quantizeVertices{true};
+    //small textures of a loaded file are packed into atlases, materials with the same atlas, sampler
+    //and constants then share one descriptor set
+    bool packAtlases{true};
+    //loaded surfaces are split into meshlets and culled per meshlet on the gpu. turned off by init on
+    //devices without _indirectCountSupported
+    bool meshletCulling{true};
+    //also cull meshlets facing away from the camera. off by default, the mesh pipelines draw
+    //both sides of every triangle and glTF doubleSided is not tracked yet
+    bool meshletConeCulling{false};
+    //draw surfaces at the coarsest level whose error projects to at most lodPixelError pixels
+    bool useLods{true};
+    float lodPixelError{1.f};
+
+    //background loading, workers hand their vulkan work back through the main thread queue
+    ThreadPool _threadPool;
+    std::mutex _mainThreadMutex;
+    std::deque<std::function<void()>> _mainThreadJobs;
+
+    //queue a job for the main thread, safe to call from any thread
+    void run_on_main_thread(std::function<void()>&& job);
+    //run queued jobs until the budget is used up, at least one runs per call
+    void process_main_thread_jobs(float budgetMs);
+
     std::vector<ComputeEffect> backgroundEffects;
     i32 currentBackgroundEffect{0};
 
     std::vector<std::shared_ptr<MeshAsset>> testMeshes;
 
     MaterialInstance defaultData;
+    //what defaultData is written from, it is written again when the default samplers change
+    GLTFMetallic_Roughness::MaterialResources _defaultMaterialResources;
+    GLTFMetallic_Roughness::MaterialConstants _defaultMaterialConstants;
+    //material of the test meshes, draws with defaultData
+    std::shared_ptr<GLTFMaterial> _defaultMaterial;
+    //sets defaultData was written into before, reused once out of flight
+    std::deque<std::pair<VkDescriptorSet, u64>> _retiredDefaultSets;
     GLTFMetallic_Roughness metalRoughMaterial;
 
     DrawContext mainDrawContext;
@@ -233,15 +360,31 @@ class VulkanEngine{
     EngineStats stats;
 
     void update_scene();
+    //acquire the default samplers again once the global filtering changed and write defaultData with them,
+    //before any loaded file writes its materials
+    void refresh_default_samplers();
 
     AllocatedBuffer create_buffer(size_t allocSize, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage);
     void destroy_buffer(const AllocatedBuffer& buffer);
     AllocatedImage create_image(VkExtent3D size, VkFormat format, VkImageUsageFlags usage, bool mipmapped=false);
+    //block compressed formats are never mipmapped, the gpu can't render into them
     AllocatedImage create_image(void* data, VkExtent3D size, VkFormat format, VkImageUsageFlags usage, bool mipmapped=false);
+    //every level of the chain uploaded in one submit, nothing is generated
+    AllocatedImage create_image(const MipChain& mips, VkImageUsageFlags usage);
+    //image and view with mipLevels levels and undefined contents
+    AllocatedImage allocate_image(VkExtent3D size, VkFormat format, VkImageUsageFlags usage, u32 mipLevels);
     void destroy_image(const AllocatedImage& img);
 
     void immediate_submit(std::function<void(VkCommandBuffer cmd)>&&function);
-    GPUMeshBuffers uploadMesh(std::span<u32> indices, std::span<Vertex> vertices);
+    //32 bit indices are narrowed to 16 bits when the mesh has at most 65536 vertices
+    GPUMeshBuffers uploadMesh(std::span<const u32> indices, std::span<const Vertex> vertices);
+    GPUMeshBuffers uploadMesh(std::span<const u16> indices, std::span<const Vertex> vertices);
+    //quantized vertices, positions relative to the given box, see PackedVertex
+    GPUMeshBuffers uploadMesh(std::span<const u32> indices, std::span<const PackedVertex> vertices, vec3 positionOffset, vec3 positionScale);
+    //meshlet records of the mesh surfaces, for the culling pass
+    void uploadMeshlets(GPUMeshBuffers& mesh, std::span<const Meshlet> meshlets);
+    GPUMeshBuffers upload_mesh_buffers(std::span<const u32> indices, size_t vertexCount, const void* vertices, size_t vertexBufferSize);
+    GPUMeshBuffers upload_mesh_buffers(const void* indices, size_t indexBufferSize, VkIndexType indexType, const void* vertices, size_t vertexBufferSize);
 
     static VulkanEngine& Get();
 
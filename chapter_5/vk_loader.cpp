@@ -1,626 +1,965 @@
-#include <stb_image.h>
 #include <iostream>
 #include "vk_loader.h"
 
 #include "vk_engine.h"
+#include "vk_streaming.h"
+#include "vk_cooked.h"
+#include <FileUtils.h>
+#include <meshes.h>
+#include <hash.h>
 #include "vk_initializers.h"
 #include "vk_types.h"
 #include <glm/gtc/quaternion.hpp>
 #include <fmt/core.h>
 #include <glm/ext.hpp>
+#include <chrono>
 
-//#define __USE__FASTGLTF
-#if defined __USE__FASTGLTF
-#include <fastgltf/core.hpp>
-#include <fastgltf/types.hpp>
-#include <fastgltf/tools.hpp>
-#include <fastgltf/glm_element_traits.hpp>
-//#include <fastgltf/parser.hpp>
-#else
 //#define TINYGLTF_NO_STB_IMAGE
 #include <tiny_gltf.h>
-#endif
+#include <fastgltf/core.hpp>
+#include "gltf_import.h"
+#include "fastgltf_import.h"
+#include "obj_import.h"
+#include "ktx2.h"
+#include "texture_atlas.h"
+
+//DrawId values, recycled so the DrawContext tables stay as large as the most assets alive at once
+static std::mutex drawIdMutex;
+static std::vector<u32> freeDrawIds;
+static u32 drawIdCount = 0;
+
+DrawId::DrawId(){
+    std::lock_guard lock(drawIdMutex);
+    if(!freeDrawIds.empty()){
+        _value = freeDrawIds.back();
+        freeDrawIds.pop_back();
+    }else{
+        _value = drawIdCount++;
+    }
+}
+
+DrawId::~DrawId(){
+    std::lock_guard lock(drawIdMutex);
+    freeDrawIds.push_back(_value);
+}
 
 std::optional<std::vector<std::shared_ptr<MeshAsset>>> loadGltfMeshes(VulkanEngine* engine, std::filesystem::path filePath){
     std::cout << "Loading GLTF:" << filePath << std::endl;
-#if defined __USE__FASTGLTF
-    fastgltf::GltfDataBuffer data;
-    data.loadFromFile(filePath);
+    tinygltf::Model model;
+    std::vector<std::shared_ptr<MeshAsset>> meshes;
+    if(!parse_gltf(filePath.string(), model)){
+        return meshes;
+    }
+    //same accessor decoding as the scenes, the test meshes are drawn as they are stored
+    MeshOptimizeOptions options;
+    options.enabled = false;
+    options.lodCount = 0;
+    std::vector<ImportedMesh> imported = convert_meshes(model, engine->_threadPool, options);
+
+    constexpr bool OverrideColors = false;
+
+    //all meshes of the file go to the gpu in one submit
+    UploadBatchScope uploadBatch(engine->_uploader);
+    for(ImportedMesh& mesh : imported){
+        if(OverrideColors){
+            for(Vertex&vtx : mesh.vertices){
+                vtx.color = glm::vec4(vtx.normal, 1.f);
+            }
+        }
+        MeshAsset newMesh;
+        newMesh.name = mesh.name;
+        newMesh.surfaces = mesh.surfaces;
+        newMesh.meshBuffers = engine->uploadMesh(std::span<const u32>(mesh.indices), std::span<const Vertex>(mesh.vertices));
+        meshes.emplace_back(std::make_shared<MeshAsset>(std::move(newMesh)));
+    }
+    return meshes;
+}
 
-    constexpr auto gltfOptions = fastgltf::Options::LoadGLBBuffers | fastgltf::Options::LoadExternalBuffers;
 
-    fastgltf::Asset gltf;
-    fastgltf::Parser parser{};
-    
-    auto load = parser.loadBinaryGLTF(&data, filePath.parent_path(), gltfOptions);
-    if(load){
-        gltf = std::move(load.get());
+//decoded image with its cpu mip chain
+struct ImportedImage{
+    std::string name;
+    MipChain mips;
+    //mip 0 read straight out of a cooked file instead of mips
+    std::span<const u8> mapped;
+    //the chain came out of a KTX2 file, it is uploaded as it is and never generated
+    bool fileMips{false};
+    //content hash of the texels, the asset cache key. 0 when the image failed to load
+    u64 hash{0};
+};
+
+//everything the worker thread produces for the main thread, from a glTF file or a cooked one
+struct ImportedScene{
+    std::vector<ImportedMesh> meshes;
+    std::vector<ImportedImage> images;
+    std::vector<ImportedMaterial> materials;
+    std::vector<VkSamplerCreateInfo> samplers;
+    std::vector<ImportedNode> nodes;
+    //keeps the mapping alive while meshes and textures are uploaded out of it
+    std::shared_ptr<cooked::Scene> cooked;
+    //for the load breakdown
+    bool fromCooked{false};
+};
+
+//hand decoded rgba8 texels to the image, building the mip chain when it is streamed
+static void take_pixels(VulkanEngine* pengine, ImportedImage& image, std::vector<u8>&& pixels, u32 width, u32 height){
+    if(pengine->streamTextures){
+        image.mips = build_mip_chain(std::move(pixels), width, height);
     }else{
-        fmt::print("Failed to load glTF: {} \n", fastgltf::to_underlying(load.error()));
-        return {};
+        //mip 0 only, the gpu builds the rest
+        image.mips.width = width;
+        image.mips.height = height;
+        image.mips.levels.push_back(std::move(pixels));
     }
+}
 
-#else
-    tinygltf::TinyGLTF loader;
-    tinygltf::Model model;
-    std::string err;
-    std::string warn;
-
-    auto ext = filePath.extension();
-    bool res=false;
-    std::string pathstr = filePath.string();
-    ccharp path = pathstr.c_str();
-    if(ext == ".glb")
-        res = loader.LoadBinaryFromFile(&model, &err, &warn, path);
-    else
-        res = loader.LoadASCIIFromFile(&model, &err, &warn, path);
-
-    std::vector<std::shared_ptr<MeshAsset>> meshes;
-    std::vector<u32> indices;
-    std::vector<Vertex> vertices;
-    if(res){
-        for(auto&mesh : model.meshes){
-            MeshAsset newMesh;
-
-            newMesh.name = mesh.name;
-
-            //clear the mesh arrays each mesh, we don't want to merge them by error
-            indices.clear();
-            vertices.clear();
-
-            for(auto&&p : mesh.primitives){
-                
-                GeoSurface newSurface;
-                newSurface.startIndex = (u32)indices.size();
-                //newSurface.count = (u32)accessor.count;
-
-                size_t initial_vtx = vertices.size();
-
-                //load indexes
-                {
-                    const tinygltf::Accessor& accessor = model.accessors[p.indices];
-				    const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
-                    newSurface.count = (u32)accessor.count;
-                    switch(accessor.componentType){
-                        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:{
-                            u16*ptr = (u16*)(model.buffers[view.buffer].data.data() + (accessor.byteOffset + view.byteOffset));
-                            for(size_t i = 0; i < accessor.count; ++i){
-                                indices.push_back(ptr[i]);
-                            }
-                        }
-                            break;
-                        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:{
-                            u32*ptr = (u32*)(model.buffers[view.buffer].data.data() + (accessor.byteOffset + view.byteOffset));
-                            for(size_t i = 0; i < accessor.count; ++i){
-                                indices.push_back(ptr[i]);
-                            }
-                        }
-                            break;
-                        default:
-                        assert(0);
-                            break;
-                    }
-                }
-
-                //load vertex positions
-                {
-                    auto attr = p.attributes["POSITION"];
-                    const tinygltf::Accessor& accessor = model.accessors[attr];
-				    const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
-                    vec3*ptr = (vec3*)(model.buffers[view.buffer].data.data() + (accessor.byteOffset + view.byteOffset));
-                    vertices.resize(vertices.size() + accessor.count);
-                    for(size_t i=0; i < accessor.count; i++){
-                        Vertex vtx{};
-                        vtx.position = *ptr++;                                           
-                        vtx.normal = vec3(1.f, 0.f, 0.f);
-                        vtx.color = vec4(1.f);
-                        vertices[initial_vtx+i] = vtx;
-
-                    }
-                }
-                //load vtx normals
-                {
-                    assert(p.attributes.find("NORMAL") != p.attributes.end());
-                    auto attr = p.attributes["NORMAL"];
-                    const tinygltf::Accessor& accessor = model.accessors[attr];
-				    const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
-                    vec3*ptr = (vec3*)(model.buffers[view.buffer].data.data() + (accessor.byteOffset + view.byteOffset));
-                    for(size_t i=0; i < accessor.count; i++){
-                        vertices[initial_vtx+i].normal = *ptr++;                        
-                    }
-                }
-                //load UVs
-                {
-                    assert(p.attributes.find("TEXCOORD_0") != p.attributes.end());
-                    auto attr = p.attributes["TEXCOORD_0"];
-                    const tinygltf::Accessor& accessor = model.accessors[attr];
-				    const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
-                    vec2*ptr = (vec2*)(model.buffers[view.buffer].data.data() + (accessor.byteOffset + view.byteOffset));
-                    for(size_t i=0; i < accessor.count; i++){
-                        vec2 uv = *ptr++;
-                        vertices[initial_vtx+i].uv_x = uv.x;
-                        vertices[initial_vtx+i].uv_y = uv.y;                        
-                    }
-                }
-                newMesh.surfaces.push_back(newSurface);
-            }
-
-            constexpr bool OverrideColors = false;
+//hand a decoded image to the imported one, png/jpeg texels go through take_pixels and KTX2 chains are kept as they are
+static void take_image(VulkanEngine* pengine, ImportedImage& image, DecodedImage&& decoded){
+    if(decoded.pixels.empty()){
+        return;
+    }
+    if(decoded.format == VK_FORMAT_R8G8B8A8_UNORM && decoded.mips.empty()){
+        take_pixels(pengine, image, std::move(decoded.pixels), decoded.width, decoded.height);
+        return;
+    }
+    if(vkutil::is_block_compressed(decoded.format) && !pengine->_bcSupported){
+        fmt::println("Image {} is {}, the device can't sample BC formats", image.name, string_VkFormat(decoded.format));
+        return;
+    }
+    image.fileMips = true;
+    image.mips.width = decoded.width;
+    image.mips.height = decoded.height;
+    image.mips.format = decoded.format;
+    image.mips.levels.push_back(std::move(decoded.pixels));
+    for(std::vector<u8>& level : decoded.mips){
+        image.mips.levels.push_back(std::move(level));
+    }
+}
 
-            if(OverrideColors){
-                for(Vertex&vtx : vertices){
-                    vtx.color = glm::vec4(vtx.normal, 1.f);
-                }
-            }
+//decode time of every image, and of all of them summed over the threads against the wall time
+static void print_decode_times(const std::string& path, const ImportedScene& imported, std::span<const float> decodeMs, float wallMs){
+    float total = 0.f;
+    for(size_t i = 0; i < decodeMs.size(); ++i){
+        const ImportedImage& image = imported.images[i];
+        fmt::println("  image {} '{}' {}x{} decoded in {:.2f} ms", i, image.name, image.mips.width, image.mips.height, decodeMs[i]);
+        total += decodeMs[i];
+    }
+    if(!decodeMs.empty()){
+        fmt::println("{}: {} images, {:.2f} ms of decoding done in {:.2f} ms", path, decodeMs.size(), total, wallMs);
+    }
+}
 
-            newMesh.meshBuffers = engine->uploadMesh(indices, vertices);
-            meshes.emplace_back(std::make_shared<MeshAsset>(std::move(newMesh)));
+//parse and convert a glTF file with tinygltf. cpu only
+static std::shared_ptr<ImportedScene> import_tinygltf(VulkanEngine* pengine, const std::string& path){
+    tinygltf::Model gltf;
+    if(!pengine->parallelImageDecode){
+        //images are decoded one after the other on this thread once the file is parsed
+        EncodedImages encoded;
+        if(!parse_gltf(path, gltf, &encoded)){
+            return nullptr;
+        }
+        auto imported = std::make_shared<ImportedScene>();
+        imported->meshes = convert_meshes(gltf, pengine->_threadPool);
+        imported->images.resize(gltf.images.size());
+        for(u32 i = 0; i < gltf.images.size(); ++i){
+            DecodedImage image = decode_image(gltf.images[i].name, encoded.bytes[i], pengine->_basisTarget);
+            imported->images[i].name = std::move(image.name);
+            take_image(pengine, imported->images[i], std::move(image));
+            encoded.bytes[i] = {};
         }
+        imported->materials = convert_materials(gltf, ktx2::can_transcode());
+        imported->samplers = convert_samplers(gltf);
+        imported->nodes = convert_nodes(gltf);
+        return imported;
+    }
 
-        
-    }        
-    return meshes;
-#endif
+    //images are only copied out while parsing, then decode on the workers while this thread converts
+    //the rest of the file. their mip chains are built on the thread that decoded them
+    EncodedImages encoded;
+    if(!parse_gltf(path, gltf, &encoded)){
+        return nullptr;
+    }
+    auto imported = std::make_shared<ImportedScene>();
+    imported->images.resize(gltf.images.size());
+    std::vector<float> decodeMs(gltf.images.size(), 0.f);
+    auto decodeStart = std::chrono::steady_clock::now();
+    AsyncImageDecode decode;
+    decode.start(pengine->_threadPool, gltf, std::move(encoded), [pengine, &imported, &decodeMs](u32 i, DecodedImage&& image){
+        ImportedImage& out = imported->images[i];
+        out.name = std::move(image.name);
+        decodeMs[i] = image.decodeMs;
+        take_image(pengine, out, std::move(image));
+    }, pengine->_basisTarget);
+    imported->meshes = convert_meshes(gltf, pengine->_threadPool);
+    imported->materials = convert_materials(gltf, ktx2::can_transcode());
+    imported->samplers = convert_samplers(gltf);
+    imported->nodes = convert_nodes(gltf);
+    decode.finish();
+    float wallMs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - decodeStart).count() / 1000.f;
+    print_decode_times(path, *imported, decodeMs, wallMs);
+    return imported;
 }
 
-#if defined(__USE__FASTGLTF)
-VkFilter extract_filter(fastgltf::Filter filter){
-    switch(filter){
-        //nearest samplers
-        case fastgltf::Filter::Nearest;
-        case fastgltf::Filter::NearestMipMapNearest;
-        case fastgltf::Filter::NearestMipMapLinear:
-            return VK_FILTER_NEAREST;
-        //linear samplers
-        case fastgltf::Filter::Linear:
-        case fastgltf::Filter::LinearMipMapNearest:
-        case fastgltf::Filter::MipMapLinear:
-        default:
-            return VK_FILTER_LINEAR;
+//parse and convert a glTF file with fastgltf, images are decoded in parallel after parsing. cpu only
+static std::shared_ptr<ImportedScene> import_fastgltf(VulkanEngine* pengine, const std::string& path){
+    fastgltf::Asset gltf;
+    if(!parse_gltf(path, gltf)){
+        return nullptr;
     }
+    auto imported = std::make_shared<ImportedScene>();
+    imported->meshes = convert_meshes(gltf, pengine->_threadPool);
+    auto decodeStart = std::chrono::steady_clock::now();
+    std::vector<DecodedImage> decoded = decode_images(gltf, std::filesystem::path(path).parent_path(), pengine->_threadPool, pengine->_basisTarget);
+    imported->images.resize(decoded.size());
+    std::vector<float> decodeMs(decoded.size());
+    pengine->_threadPool.parallel_for((u32)decoded.size(), [&](u32 i){
+        DecodedImage& image = decoded[i];
+        imported->images[i].name = std::move(image.name);
+        decodeMs[i] = image.decodeMs;
+        take_image(pengine, imported->images[i], std::move(image));
+    });
+    float wallMs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - decodeStart).count() / 1000.f;
+    print_decode_times(path, *imported, decodeMs, wallMs);
+    imported->materials = convert_materials(gltf, ktx2::can_transcode());
+    imported->samplers = convert_samplers(gltf);
+    imported->nodes = convert_nodes(gltf);
+    return imported;
 }
-VkSamplerMipmapMode extract_mipmap_mode(fastgltf::Filter filter){
-    switch(filter){
-        case fastgltf::Filter::NearestMipMapNearest:
-        case fastgltf::Filter::LinearMipMapNearest:
-            return VK_SAMPLER_MIPMAP_MODE_NEAREST;
-        case fastgltf::Filter::NearestMipMapLinear:
-        case fastgltf::Filter::LinearMipMapLinear:
-        default:
-            return VK_SAMPLER_MIPMAP_MODE_LINEAR;
+
+static std::shared_ptr<ImportedScene> import_gltf(VulkanEngine* pengine, const std::string& path){
+    if(pengine->gltfBackend == GltfBackend::FastGltf){
+        return import_fastgltf(pengine, path);
     }
-}
-#else
-VkFilter extract_filter(int filter){
-    switch(filter){
-        case TINYGLTF_TEXTURE_FILTER_NEAREST:
-        case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_LINEAR:
-        case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_NEAREST:
-            return VK_FILTER_NEAREST;
-        case TINYGLTF_TEXTURE_FILTER_LINEAR:
-        case TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_LINEAR:
-        case TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_NEAREST:
-        default:
-            return VK_FILTER_LINEAR;
-
-    }
-    return VK_FILTER_MAX_ENUM;
-}
-VkSamplerMipmapMode extract_mipmap_mode(int filter){
-    switch(filter){
-        case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_LINEAR:
-        case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_NEAREST:
-            return VK_SAMPLER_MIPMAP_MODE_NEAREST;
-        case TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_LINEAR:
-        case TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_NEAREST:
-        default:
-            return VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    }
-    return VK_SAMPLER_MIPMAP_MODE_MAX_ENUM;
+    return import_tinygltf(pengine, path);
 }
 
+//map a cooked scene, vertices, indices and embedded texels stay in the mapping until they are staged.
+//embedded KTX2 files and the image files referenced by the scene still go through decode_image
+static std::shared_ptr<ImportedScene> import_cooked(VulkanEngine* pengine, const std::string& path){
+    auto scene = std::make_shared<cooked::Scene>();
+    if(!scene->open(path.c_str())){
+        return nullptr;
+    }
+    //cooked with the basisu sources while this build can't transcode them, or the other way around
+    if((scene->inputs() & cooked::HAS_BASISU) && ((scene->inputs() & cooked::BASISU_SOURCES) != 0) != ktx2::can_transcode()){
+        fmt::println("Cooked scene {} was cooked {} basis universal textures, loading the source", path,
+            ktx2::can_transcode() ? "without" : "with");
+        return nullptr;
+    }
+    auto imported = std::make_shared<ImportedScene>();
+    imported->cooked = scene;
+    imported->fromCooked = true;
+
+    std::span<const Vertex> vertices = scene->vertices();
+    std::span<const u32> indices = scene->indices();
+    std::span<const cooked::Surface> surfaces = scene->surfaces();
+    for(const cooked::Mesh& mesh : scene->meshes()){
+        ImportedMesh& newmesh = imported->meshes.emplace_back();
+        newmesh.name = scene->string(mesh.name);
+        for(const cooked::Surface& surface : surfaces.subspan(mesh.firstSurface, mesh.surfaceCount)){
+            GeoSurface newSurface;
+            newSurface.startIndex = surface.startIndex;
+            newSurface.count = surface.count;
+            newSurface.bounds = surface.bounds;
+            newSurface.lodCount = surface.lodCount;
+            for(u32 l = 0; l < surface.lodCount; ++l){
+                newSurface.lods[l] = surface.lods[l];
+            }
+            newmesh.surfaces.push_back(newSurface);
+            newmesh.surfaceMaterials.push_back(surface.material);
+        }
+        newmesh.mappedVertices = vertices.subspan(mesh.firstVertex, mesh.vertexCount);
+        newmesh.mappedIndices = indices.subspan(mesh.firstIndex, mesh.indexCount);
+    }
 
-#endif
+    for(const cooked::Material& mat : scene->materials()){
+        ImportedMaterial& newMat = imported->materials.emplace_back();
+        newMat.name = scene->string(mat.name);
+        newMat.colorFactor = mat.colorFactor;
+        newMat.metalRoughnessFactor = mat.metalRoughnessFactor;
+        newMat.passType = (MaterialPass)mat.passType;
+        newMat.colorImage = mat.colorImage;
+        newMat.colorSampler = mat.colorSampler;
+    }
 
-std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanEngine * pengine, std::string_view filePath){
-    fmt::print("LOading GLTF: {}", filePath);
+    for(const cooked::Sampler& sampler : scene->samplers()){
+        VkSamplerCreateInfo sampl{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+        sampl.maxLod = VK_LOD_CLAMP_NONE;
+        sampl.minLod = 0;
+        sampl.magFilter = (VkFilter)sampler.magFilter;
+        sampl.minFilter = (VkFilter)sampler.minFilter;
+        sampl.mipmapMode = (VkSamplerMipmapMode)sampler.mipmapMode;
+        imported->samplers.push_back(sampl);
+    }
 
-    std::shared_ptr<LoadedGLTF> scene = std::make_shared<LoadedGLTF>();
+    std::span<const u32> children = scene->children();
+    for(const cooked::Node& node : scene->nodes()){
+        ImportedNode& newNode = imported->nodes.emplace_back();
+        newNode.name = scene->string(node.name);
+        newNode.mesh = node.mesh;
+        newNode.localTransform = node.localTransform;
+        std::span<const u32> nodeChildren = children.subspan(node.firstChild, node.childCount);
+        newNode.children.assign(nodeChildren.begin(), nodeChildren.end());
+    }
 
-    scene->creator = pengine;
-    LoadedGLTF& file = *scene.get();
-#if defined (__USE__FASTGLTF)
-    fastgltf::Parser parser{};
+    std::span<const cooked::Texture> textures = scene->textures();
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    imported->images.resize(textures.size());
+    pengine->_threadPool.parallel_for((u32)textures.size(), [&](u32 i){
+        const cooked::Texture& texture = textures[i];
+        ImportedImage& image = imported->images[i];
+        image.name = scene->string(texture.name);
+        if(texture.texelSize > 0 && texture.width == 0){
+            take_image(pengine, image, decode_image(image.name, scene->texels(texture), pengine->_basisTarget));
+            return;
+        }
+        if(texture.texelSize > 0){
+            std::span<const u8> texels = scene->texels(texture);
+            if(pengine->streamTextures){
+                take_pixels(pengine, image, std::vector<u8>(texels.begin(), texels.end()), texture.width, texture.height);
+            }else{
+                image.mips.width = texture.width;
+                image.mips.height = texture.height;
+                image.mapped = texels;
+            }
+            return;
+        }
+        std::string_view uri = scene->string(texture.uri);
+        if(uri.empty()){
+            return;
+        }
+        //png/jpeg or KTX2, same as the images of a glTF file
+        std::string imagePath = (directory / uri).string();
+        MappedFile file;
+        if(!file.open(imagePath.c_str())){
+            return;
+        }
+        take_image(pengine, image, decode_image(image.name, std::span<const u8>(file.data(), file.size()), pengine->_basisTarget));
+    });
+    return imported;
+}
 
-    constexpr auto gltfOptions = fastgltf::Options::DontRequireValidAssetNumber | fastgltf::Options::LoadGLBBuffers | fastgltf::Options::LoadExternalBuffers;
+//parse an OBJ file and its MTL materials, every o/g becomes a mesh drawn by a node of its own. the
+//diffuse textures are decoded in parallel, each file once however many materials use it. cpu only
+static std::shared_ptr<ImportedScene> import_obj_scene(VulkanEngine* pengine, const std::string& path){
+    ObjScene scene;
+    ObjImportStats stats;
+    if(!import_obj(path, pengine->_threadPool, scene, &stats)){
+        return nullptr;
+    }
+    float totalMs = stats.parseMs + stats.mergeMs + stats.dedupMs;
+    fmt::println("{}: {} triangles, {} vertices, {:.2f} ms ({:.0f} MB/s)", path, stats.triangles, stats.vertices,
+        totalMs, stats.bytes / (1e3f * std::max(totalMs, 1e-3f)));
+
+    auto imported = std::make_shared<ImportedScene>();
+    std::vector<std::string> imagePaths;
+    for(const ObjMaterial& mat : scene.materials){
+        ImportedMaterial& newMat = imported->materials.emplace_back();
+        newMat.name = mat.name;
+        newMat.colorFactor = mat.diffuse;
+        newMat.metalRoughnessFactor = vec4(1.f, 0.5f, 0.f, 0.f);
+        newMat.passType = mat.diffuse.a < 1.f ? MaterialPass::Transparent : MaterialPass::MainColor;
+        newMat.colorImage = -1;
+        //trilinear repeat, OBJ has no sampler state
+        newMat.colorSampler = -1;
+        if(!mat.diffuseTexture.empty()){
+            auto it = std::find(imagePaths.begin(), imagePaths.end(), mat.diffuseTexture);
+            newMat.colorImage = (i32)(it - imagePaths.begin());
+            if(it == imagePaths.end()){
+                imagePaths.push_back(mat.diffuseTexture);
+            }
+        }
+    }
 
-    fastgltf::GltfDataBuffer data;
-    data.loadFromFile(filePath);
-    fastgltf::Asset gltf;
+    //faces without a known usemtl get a white material of their own instead of whatever came first
+    bool unassigned = false;
+    for(const ImportedMesh& mesh : scene.meshes){
+        unassigned |= std::find(mesh.surfaceMaterials.begin(), mesh.surfaceMaterials.end(), -1) != mesh.surfaceMaterials.end();
+    }
+    if(unassigned){
+        i32 fallback = (i32)imported->materials.size();
+        imported->materials.push_back({"default", vec4(1.f), vec4(1.f, 0.5f, 0.f, 0.f), MaterialPass::MainColor, -1, -1});
+        for(ImportedMesh& mesh : scene.meshes){
+            std::replace(mesh.surfaceMaterials.begin(), mesh.surfaceMaterials.end(), -1, fallback);
+        }
+    }
 
-    std::filesystem::path path = filePath;
+    imported->meshes = std::move(scene.meshes);
+    for(size_t m = 0; m < imported->meshes.size(); ++m){
+        ImportedNode& node = imported->nodes.emplace_back();
+        node.name = imported->meshes[m].name;
+        node.mesh = (i32)m;
+        node.localTransform = mat4(1.f);
+    }
 
-    auto type = fastgltf::determineGltfFileType(&data);
-    if(type == fastgltf::GtlfType::glTF){
-        auto load = parser.loadGLTF(&dat, path.parent_path(), gltfOptions);
-        if(load){
-            gltf = std::move(load.get());
-        }else{
-            std::cerr << "Failed to load glTF: " << fastgltf::to_underlying(load.error()) << std::endl;
-            return {};
+    auto decodeStart = std::chrono::steady_clock::now();
+    imported->images.resize(imagePaths.size());
+    std::vector<float> decodeMs(imagePaths.size());
+    pengine->_threadPool.parallel_for((u32)imagePaths.size(), [&](u32 i){
+        ImportedImage& image = imported->images[i];
+        image.name = std::filesystem::path(imagePaths[i]).filename().string();
+        MappedFile file;
+        if(!file.open(imagePaths[i].c_str())){
+            fmt::println("Failed to open {}", imagePaths[i]);
+            return;
         }
-    }else if(type == fastgltf::GltfType::GLB){
-        auto load = parser.loadBinaryGLTF(&data, path.parent_path(), gltfOptions);
-        if(load){
-            gltf = std::move(load.get());
-        }else{
-            std::cerr << "Failed to load glTF: " << fastgltf::to_underlying(load.error()) << std::endl;
-            return {};
+        DecodedImage decoded = decode_image(image.name, std::span<const u8>(file.data(), file.size()), pengine->_basisTarget);
+        decodeMs[i] = decoded.decodeMs;
+        take_image(pengine, image, std::move(decoded));
+    });
+    float wallMs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - decodeStart).count() / 1000.f;
+    print_decode_times(path, *imported, decodeMs, wallMs);
+    return imported;
+}
+
+//split every surface into meshlets for the gpu culling pass, one mesh per task. runs before quantization,
+//the bounds use the full precision positions
+static void build_scene_meshlets(VulkanEngine* pengine, ImportedScene& imported){
+    std::atomic<u64> meshletCount{0};
+    pengine->_threadPool.parallel_for((u32)imported.meshes.size(), [&](u32 m){
+        ImportedMesh& mesh = imported.meshes[m];
+        std::span<const Vertex> vertices = mesh.mappedVertices.empty() ? std::span<const Vertex>(mesh.vertices) : mesh.mappedVertices;
+        std::span<const u32> indices = mesh.mappedIndices.empty() ? std::span<const u32>(mesh.indices) : mesh.mappedIndices;
+        for(GeoSurface& surface : mesh.surfaces){
+            std::vector<Meshlet> meshlets = build_meshlets(indices.subspan(surface.startIndex, surface.count), surface.startIndex, vertices);
+            surface.firstMeshlet = (u32)mesh.meshlets.size();
+            surface.meshletCount = (u32)meshlets.size();
+            mesh.meshlets.insert(mesh.meshlets.end(), meshlets.begin(), meshlets.end());
+        }
+        meshletCount += mesh.meshlets.size();
+    });
+    fmt::println("meshlets: {} for {} meshes", meshletCount.load(), imported.meshes.size());
+}
+
+//pack the vertices of every mesh into the 16 byte format, relative to the mesh bounding box. one mesh per task
+static void quantize_meshes(VulkanEngine* pengine, ImportedScene& imported){
+    std::atomic<u64> fullBytes{0};
+    std::atomic<u64> packedBytes{0};
+    pengine->_threadPool.parallel_for((u32)imported.meshes.size(), [&](u32 m){
+        ImportedMesh& mesh = imported.meshes[m];
+        std::span<const Vertex> vertices = mesh.mappedVertices.empty() ? std::span<const Vertex>(mesh.vertices) : mesh.mappedVertices;
+        if(vertices.empty()){
+            return;
+        }
+        vec3 minpos = vertices[0].position;
+        vec3 maxpos = vertices[0].position;
+        for(const Vertex& v : vertices){
+            minpos = glm::min(minpos, v.position);
+            maxpos = glm::max(maxpos, v.position);
+        }
+        mesh.positionOffset = minpos;
+        mesh.positionScale = maxpos - minpos;
+        mesh.packedVertices = pack_vertices(vertices, mesh.positionOffset, mesh.positionScale);
+        //the full vertices are not uploaded anymore
+        mesh.vertices = {};
+        mesh.mappedVertices = {};
+        fullBytes += vertices.size() * sizeof(Vertex);
+        packedBytes += mesh.packedVertices.size() * sizeof(PackedVertex);
+    });
+    fmt::println("vertex quantization: {:.2f} MB -> {:.2f} MB", fullBytes / (1024.f * 1024.f), packedBytes / (1024.f * 1024.f));
+}
+
+//pack the small color textures of the file into atlases, so the materials sampling them share one image.
+//only textures that every material samples with a repeating sampler, the shader wraps the uv inside the tile
+static void pack_scene_atlases(VulkanEngine* pengine, ImportedScene& imported){
+    size_t imageCount = imported.images.size();
+    std::vector<u8> sampled(imageCount, 0);
+    std::vector<u8> repeating(imageCount, 1);
+    for(const ImportedMaterial& mat : imported.materials){
+        if(mat.colorImage < 0){
+            continue;
+        }
+        sampled[mat.colorImage] = 1;
+        if(mat.colorSampler >= 0){
+            const VkSamplerCreateInfo& info = imported.samplers[mat.colorSampler];
+            if(info.addressModeU != VK_SAMPLER_ADDRESS_MODE_REPEAT || info.addressModeV != VK_SAMPLER_ADDRESS_MODE_REPEAT){
+                repeating[mat.colorImage] = 0;
+            }
         }
-    }else{
-        std::cerr << "Failed to determine glTF container" << std::endl;
-        return {};
     }
-    //we can estimate the descriptors we will need accurately
-    std::vector<DescriptorAllocatorGrowable::PoolSizeRatio> sizes = {
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,3},
-        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,3},
-        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,1}
-    };
-    file.descriptorPool.init(pengine->_device, gltf.materials.size(), sizes);
+    std::vector<atlas::Tile> tiles;
+    //image of every tile, and tile of every packed image
+    std::vector<u32> tileImages;
+    std::vector<i32> imageTiles(imageCount, -1);
+    for(size_t i = 0; i < imageCount; ++i){
+        const ImportedImage& image = imported.images[i];
+        if(!sampled[i] || !repeating[i] || image.fileMips || image.mips.format != VK_FORMAT_R8G8B8A8_UNORM){
+            continue;
+        }
+        if((image.mips.levels.empty() && image.mapped.empty()) || std::max(image.mips.width, image.mips.height) > atlas::MAX_TILE){
+            continue;
+        }
+        const u8* pixels = image.mapped.empty() ? image.mips.levels[0].data() : image.mapped.data();
+        imageTiles[i] = (i32)tiles.size();
+        tiles.push_back({image.mips.width, image.mips.height, pixels});
+        tileImages.push_back((u32)i);
+    }
+    if(tiles.size() < 2){
+        return;
+    }
+    auto packStart = std::chrono::system_clock::now();
+    std::vector<atlas::Atlas> atlases = atlas::pack(tiles);
+
+    //the images that stay on their own keep their order, the atlases go after them
+    std::vector<ImportedImage> images;
+    std::vector<i32> remap(imageCount, -1);
+    for(size_t i = 0; i < imageCount; ++i){
+        if(imageTiles[i] < 0){
+            remap[i] = (i32)images.size();
+            images.push_back(std::move(imported.images[i]));
+        }
+    }
+    u32 firstAtlas = (u32)images.size();
+    size_t atlasBytes = 0;
+    for(size_t a = 0; a < atlases.size(); ++a){
+        ImportedImage& image = images.emplace_back();
+        image.name = fmt::format("atlas{}", a);
+        atlasBytes += atlases[a].pixels.size();
+        take_pixels(pengine, image, std::move(atlases[a].pixels), atlases[a].width, atlases[a].height);
+    }
+    for(size_t t = 0; t < tiles.size(); ++t){
+        remap[tileImages[t]] = (i32)(firstAtlas + tiles[t].atlas);
+    }
+    for(ImportedMaterial& mat : imported.materials){
+        if(mat.colorImage < 0){
+            continue;
+        }
+        if(imageTiles[mat.colorImage] >= 0){
+            mat.uvTransform = tiles[imageTiles[mat.colorImage]].uvTransform;
+        }
+        mat.colorImage = remap[mat.colorImage];
+    }
+    imported.images = std::move(images);
+    auto packEnd = std::chrono::system_clock::now();
+    fmt::println("packed {} of {} textures into {} atlases ({:.2f} MB) in {:.2f} ms", tiles.size(), imageCount, atlases.size(),
+        atlasBytes / (1024.f * 1024.f), std::chrono::duration_cast<std::chrono::microseconds>(packEnd - packStart).count() / 1000.f);
+}
 
-    for(fastgltf::Sampler& sampler : gltf.samplers){
-        VkSamplerCreateInfo sampl{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
-        sampl.maxLod = VK_LOD_CLAMP_NONE;
-        sampl.minLod = 0;
-        sampl.magFilter = extract_filter(sampler.magFilter.value_or(fastgltf::Filter::Nearest));
-        sampl.minFilter = extract_filter(sampler.minFilter.value_or(fastgltf::Filter::Nearest));
+//content hashes of every image and mesh for the asset cache, one asset per task. taken after quantization
+//so they cover exactly what gets uploaded
+static void hash_scene(VulkanEngine* pengine, ImportedScene& imported){
+    u32 imageCount = (u32)imported.images.size();
+    pengine->_threadPool.parallel_for(imageCount + (u32)imported.meshes.size(), [&](u32 i){
+        if(i < imageCount){
+            ImportedImage& image = imported.images[i];
+            if(image.mips.levels.empty() && image.mapped.empty()){
+                return;
+            }
+            std::span<const u8> texels = image.mapped.empty() ? std::span<const u8>(image.mips.levels[0]) : image.mapped;
+            //a streamed image and a gpu mipmapped one are different resources
+            u32 header[] = {image.mips.width, image.mips.height, (u32)image.mips.levels.size() > 1 ? 1u : 0u, (u32)image.mips.format};
+            image.hash = xxhash64(texels, xxhash64(header, sizeof(header)));
+            return;
+        }
+        ImportedMesh& mesh = imported.meshes[i - imageCount];
+        std::span<const u32> indices = mesh.mappedIndices.empty() ? std::span<const u32>(mesh.indices) : mesh.mappedIndices;
+        u64 hash = xxhash64(indices);
+        if(!mesh.packedVertices.empty()){
+            vec3 box[] = {mesh.positionOffset, mesh.positionScale};
+            hash = xxhash64(std::span<const PackedVertex>(mesh.packedVertices), xxhash64(box, sizeof(box), hash));
+        }else{
+            std::span<const Vertex> vertices = mesh.mappedVertices.empty() ? std::span<const Vertex>(mesh.vertices) : mesh.mappedVertices;
+            hash = xxhash64(vertices, hash);
+        }
+        mesh.hash = xxhash64(std::span<const Meshlet>(mesh.meshlets), hash);
+    });
+}
 
-        sampl.mipmapMode = extract_mipmap_mode(sampler.minFilter.value_or(fastgltf::Filter::Nearest));
+//the cooked file next to the source wins while it is at least as new and was cooked with the same
+//choices the runtime makes, or when there is no source
+//OBJ files are always parsed, they are not cooked
+static std::shared_ptr<ImportedScene> import_scene(VulkanEngine* pengine, const std::string& path){
+    std::shared_ptr<ImportedScene> imported;
+    std::string cookedPath = path + cooked::EXTENSION;
+    bool obj = std::filesystem::path(path).extension() == ".obj";
+    if(obj){
+        imported = import_obj_scene(pengine, path);
+    }else if(fileExists(cookedPath.c_str()) && (!fileExists(path.c_str()) || fileTime(cookedPath.c_str()) >= fileTime(path.c_str()))){
+        imported = import_cooked(pengine, cookedPath);
+        //outdated or corrupt, fall back to the source
+    }
+    if(!imported && !obj){
+        imported = import_gltf(pengine, path);
+    }
+    if(imported && pengine->meshletCulling){
+        build_scene_meshlets(pengine, *imported);
+    }
+    if(imported && pengine->quantizeVertices){
+        quantize_meshes(pengine, *imported);
+    }
+    if(imported && pengine->packAtlases){
+        pack_scene_atlases(pengine, *imported);
+    }
+    if(imported){
+        hash_scene(pengine, *imported);
+    }
+    return imported;
+}
 
-        VkSampler newSampler;
-        vkCreateSampler(pengine->_device, &sampl, nullptr, &newSampler);
-        file.samplers.push_back(newSampler);
+//create the gpu image of a decoded glTF image, or share the one another file created for the same texels. main thread only
+static void create_texture(VulkanEngine* pengine, LoadedGLTF& file, ImportedImage& image, size_t index){
+    if(image.mips.levels.empty() && image.mapped.empty()){
+        file.textures[index] = pengine->_errorCheckerboardImage;
+        fmt::println("Failed to load GLTF texture {}", image.name);
+        return;
     }
+    if(auto cached = pengine->_assetCache.acquire_texture(image.hash)){
+        file.textures[index] = cached->image;
+        file.textureStreams[index] = cached->stream;
+        file.textureHashes[index] = image.hash;
+        file.images[image.name.c_str()] = cached->image;
+        image.mips.levels.clear();
+        image.mapped = {};
+        return;
+    }
+    auto createStart = std::chrono::system_clock::now();
+    VkExtent3D imageSize;
+    imageSize.width = image.mips.width;
+    imageSize.height = image.mips.height;
+    imageSize.depth = 1;
+
+    AllocatedImage newImage;
+    if(image.fileMips && !pengine->streamTextures){
+        //the whole KTX2 chain in one go
+        newImage = pengine->create_image(image.mips, VK_IMAGE_USAGE_SAMPLED_BIT);
+        image.mips.levels.clear();
+    }else if(image.mips.levels.size() > 1){
+        //the streamer owns the image, it may replace it with a smaller or larger one later
+        file.textureStreams[index] = pengine->_textureStreamer.add(std::move(image.mips));
+        newImage = pengine->_textureStreamer.image(file.textureStreams[index]);
+    }else{
+        //upload mip 0 and let the mip generator fill in the rest, block compressed images stay at one level
+        void* pixels = image.mapped.empty() ? (void*)image.mips.levels[0].data() : (void*)image.mapped.data();
+        newImage = pengine->create_image(pixels, imageSize, image.mips.format, VK_IMAGE_USAGE_SAMPLED_BIT, true);
+        image.mips.levels.clear();
+        image.mapped = {};
+    }
+    auto createEnd = std::chrono::system_clock::now();
+    file.textures[index] = newImage;
+    file.textureHashes[index] = image.hash;
+    file.images[image.name.c_str()]= newImage;
+    pengine->_assetCache.add_texture(image.hash, {newImage, file.textureStreams[index]}, newImage.allocationInfo.size,
+        std::chrono::duration_cast<std::chrono::microseconds>(createEnd - createStart).count() / 1000.f);
+}
 
-    //temporal arrays for all the objects to use while creating the GLTF data
-    std::vector<std::shared_ptr<MeshAsset>> meshes;
-    std::vector<std::shared_ptr<Node>> nodes;
-    std::vector<AllocatedImage> images;
-    std::vector<std::shared_ptr<GLTFMaterial>> materials;
-    //load all textures
-    for(fastgltf::Image&image : gltf.images){
-        images.push_back(pengine->_errorCheckerboardImage);
+//image to sample for the texture, streamed ones change size with the residency budget
+static const AllocatedImage& texture_image(VulkanEngine* pengine, LoadedGLTF& file, i32 index){
+    u32 stream = file.textureStreams[index];
+    return stream != UINT32_MAX ? pengine->_textureStreamer.image(stream) : file.textures[index];
+}
+
+//lowest mip level of the texture that can be sampled, UINT32_MAX while nothing is resident
+static u32 texture_level(VulkanEngine* pengine, LoadedGLTF& file, i32 index){
+    u32 stream = file.textureStreams[index];
+    if(stream != UINT32_MAX){
+        return pengine->_textureStreamer.resident_level(stream);
+    }
+    const AllocatedImage& image = file.textures[index];
+    if(image.image == pengine->_greyImage.image){
+        //not created yet
+        return UINT32_MAX;
     }
-    //create buffer to hote the material data
-    file.materialDataBuffer = pengine->create_buffer(sizeof(GLTFMetallic_Roughness::MaterialConstants)* gltf.materials.size(),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    //failed textures are the checkerboard, otherwise the ticket covers the upload and the generated mips
+    return pengine->_uploader.is_ready(image.uploadTicket) ? 0 : UINT32_MAX;
+}
 
-    i32 data_index=0;
-    GLTFMetallic_Roughness::MaterialConstants * sceneMaterialConstants = (GLTFMetallic_Roughness::MaterialConstants*)file.materialDataBuffer.info.pMappedData;
-    for(fastgltf::Material& mat : gltf.materials){
-        std::shared_ptr<GLTFMaterial> newMat = std::make_shared<GLTFMaterial>();
-        materials.push_back(newMat);
-        file.materials[mat.name.c_str()] = newMat;
+//drop a material's reference to the set it shares, the last one retires the set
+static void release_material_set(VulkanEngine* pengine, LoadedGLTF& file, u64 key){
+    auto it = file.materialSets.find(key);
+    if(it == file.materialSets.end()){
+        return;
+    }
+    if(--it->second.refs == 0){
+        file.retiredSets.push_back({it->second.instance.materialSet, (u64)pengine->_frameNumber});
+        file.materialSets.erase(it);
+    }
+}
 
+//a new material set write_gltf_material left to the caller, allocated and written on any thread
+struct MaterialSetWrite{
+    LoadedGLTF::SharedSet* shared;
+    MaterialPass passType;
+    GLTFMetallic_Roughness::MaterialResources resources;
+};
+
+//write the material with whatever textures are resident right now. materials that would write the same
+//descriptor set share it, a new one goes into a set retired FRAME_OVERLAP frames ago when there is one.
+//with bindless materials a new entry of the material table is written instead. the set or entry and
+//the sampler reference the material had are released, frames in flight may still draw with them.
+//with setWrites a new set is only queued there and the returned instance is incomplete, the caller
+//writes the queued sets and takes the instances out of file.materialSets
+static MaterialInstance write_gltf_material(VulkanEngine* pengine, LoadedGLTF& file, PendingMaterial& material,
+    std::vector<MaterialSetWrite>* setWrites = nullptr){
+    i32 colorImage = material.colorImage;
+    i32 colorSampler = material.colorSampler;
+    GLTFMetallic_Roughness::MaterialResources materialResources;
+    //default the material textures
+    materialResources.colorImage = pengine->_whiteImage;
+    materialResources.colorSampler = pengine->_defaultSamplerLinear;
+    materialResources.metalRoughImage = pengine->_whiteImage;
+    materialResources.metalRoughSampler = pengine->_defaultSamplerLinear;
+
+    //set the uniform buffer for the material data
+    materialResources.dataBuffer = file.materialDataBuffer.buffer;
+    materialResources.dataBufferOffset = material.dataIndex * sizeof(GLTFMetallic_Roughness::MaterialConstants);
+
+    VkSampler sampler = VK_NULL_HANDLE;
+    if(colorImage >= 0){
+        VkSamplerCreateInfo info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+        info.magFilter = VK_FILTER_LINEAR;
+        info.minFilter = VK_FILTER_LINEAR;
+        info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        info.maxLod = VK_LOD_CLAMP_NONE;
+        if(colorSampler >= 0){
+            info = file.samplerInfos[colorSampler];
+        }
+        u32 level = texture_level(pengine, file, colorImage);
+        if(level == UINT32_MAX){
+            //not created or still uploading, draw with the placeholder
+            materialResources.colorImage = pengine->_greyImage;
+        }else{
+            materialResources.colorImage = texture_image(pengine, file, colorImage);
+            //keep the sampler off the levels that are still streaming in
+            info.minLod = (float)level;
+        }
+        if(material.uvTransform != vec4(1.f, 1.f, 0.f, 0.f)){
+            //below these the tiles of an atlas bleed into each other
+            info.maxLod = std::max(info.minLod, std::min(info.maxLod, (float)(atlas::LEVELS - 1)));
+        }
+        sampler = pengine->_samplers.acquire(info);
+        materialResources.colorSampler = sampler;
+    }
+    MaterialInstance instance;
+    if(pengine->bindlessMaterials){
         GLTFMetallic_Roughness::MaterialConstants constants;
-        constants.colorFactors = mat.pbrData.baseColorFactor;
-        constants.metalRoughFactor.x = mat.pbrData.metallicFactor;
-        constants.metalRoughFactor.y = mat.pbrData.roughnessFactor;
-        //write material parameters to buffer
-        sceneMaterialConstants[data_index] = constants;
-
-        MaterialPass passType = MaterialPass::MainColor;
-        if(mat.alphaMode == fastgltf::AlphaMode::Blend){
-            passType = MaterialPass::Transparent;
-        }
-
-        GLTFMetallic_Roughness::MaterialResources materialResources;
-        //default the material textures
-        materialResources.colorImage = pengine->_whiteImage;
-        materialResources.colorSampler = pengine->_defaultSamplerLinear;
-        materialResources.metalRoughImage = pengine->_whiteImage;
-        materialResources.metalRoughSampler = pengine->_defaultSamplerLinar;
-
-        //set the uniform buffer for the material data
-        materialResources.dataBuffer = file.materialDataBuffer.buffer;
-        materialResources.dataBufferOffset = data_index * sizeof(GLTFMetallic_Roughness::MaterialConstants);
-        //grab textures from gltf file
-        if(mat.pbrData.baseColorTexture.has_value()){
-            size_t img = gltf.textures[mat.pbrData.baseColorTexture.value().textureIndex].imageIndex.value();
-            size_t sampler = gltf.textures[mat.pbrData.baseColorTexture.value().textureIndex].samplerIndex.value();
-
-            materialResources.colorImage = images[img];
-            materialResources.colorSampler = file.samplers[sampler];            
+        constants.colorFactor = material.colorFactor;
+        constants.metalRoughnessFactor = material.metalRoughnessFactor;
+        instance = pengine->metalRoughMaterial.write_material(material.passType, materialResources, constants, pengine->_bindless);
+        u32 old = material.material->data.bindlessIndex;
+        if(old != UINT32_MAX){
+            pengine->_bindless.remove_material(old);
         }
-        //build material
-        newMat->data = pengine->metalRoughMaterial.write_material(pengine->_device, passType, materialResources, file.descriptorPool);
-
-        data_index++;
+    }else{
+        //everything the set is written from, the constants of materials with equal factors are equal
+        u64 handles[] = {(u64)material.passType, (u64)materialResources.colorImage.imageView, (u64)materialResources.colorSampler};
+        vec4 factors[] = {material.colorFactor, material.metalRoughnessFactor};
+        u64 key = xxhash64(handles, sizeof(handles), xxhash64(factors, sizeof(factors)));
+        auto it = file.materialSets.find(key);
+        if(it != file.materialSets.end()){
+            it->second.refs++;
+            instance = it->second.instance;
+        }else if(setWrites){
+            LoadedGLTF::SharedSet& shared = file.materialSets[key];
+            shared.refs = 1;
+            setWrites->push_back({&shared, material.passType, materialResources});
+        }else{
+            VkDescriptorSet set = VK_NULL_HANDLE;
+            if(!file.retiredSets.empty() && file.retiredSets.front().second + FRAME_OVERLAP <= (u64)pengine->_frameNumber){
+                set = file.retiredSets.front().first;
+                file.retiredSets.pop_front();
+            }
+            instance = pengine->metalRoughMaterial.write_material(pengine->_device, material.passType, materialResources,
+                file.descriptorPool.local(pengine->_device), set);
+            file.materialSets[key] = {instance, 1};
+        }
+        release_material_set(pengine, file, material.setKey);
+        material.setKey = key;
     }
-    //use the same vectors for all meshes so that the memory doesn't reallocate often
-    std::vector<u32> indices;
-    std::vector<Vertex> vertices;
-    for(fastgltf::Mesh& mesh : gltf.meshes){
-        std::shared_ptr<MeshAsset> newmesh = std::make_shared<MeshAsset>();
-        meshes.push_back(newmesh);
-        file.meshes[mesh.name.c_str()] = newmesh;
-        newmesh->name - mesh.name;
+    instance.uvTransform = material.uvTransform;
+    //destroyed only once the frames in flight with the old set are done
+    pengine->_samplers.release(material.sampler);
+    material.sampler = sampler;
+    return instance;
+}
 
-        //clear the mesh arrays each mesh, we don't want to merge them by error
-        indices.clear();
-        vertices.clear();
+//upload the converted mesh, or share the buffers another file uploaded for the same data. main thread only
+static void upload_mesh(VulkanEngine* pengine, MeshAsset& mesh, ImportedMesh& imported){
+    if(auto cached = pengine->_assetCache.acquire_mesh(imported.hash)){
+        mesh.meshBuffers = *cached;
+    }else{
+        auto createStart = std::chrono::system_clock::now();
+        std::span<const u32> indices = imported.mappedIndices.empty() ? std::span<const u32>(imported.indices) : imported.mappedIndices;
+        if(!imported.packedVertices.empty()){
+            mesh.meshBuffers = pengine->uploadMesh(indices, imported.packedVertices, imported.positionOffset, imported.positionScale);
+        }else if(!imported.mappedVertices.empty()){
+            //copied from the mapped file into staging, nothing to convert
+            mesh.meshBuffers = pengine->uploadMesh(indices, imported.mappedVertices);
+        }else{
+            mesh.meshBuffers = pengine->uploadMesh(indices, imported.vertices);
+        }
+        if(!imported.meshlets.empty()){
+            pengine->uploadMeshlets(mesh.meshBuffers, imported.meshlets);
+        }
+        auto createEnd = std::chrono::system_clock::now();
+        const GPUMeshBuffers& buffers = mesh.meshBuffers;
+        size_t bytes = buffers.indexBuffer.allocationInfo.size + buffers.vertexBuffer.allocationInfo.size + buffers.meshletBuffer.allocationInfo.size;
+        pengine->_assetCache.add_mesh(imported.hash, buffers, bytes,
+            std::chrono::duration_cast<std::chrono::microseconds>(createEnd - createStart).count() / 1000.f);
     }
-#else
-    tinygltf::TinyGLTF loader;
-    tinygltf::Model gltf;
-    std::string err;
-    std::string warn;
-
-    std::filesystem::path path = filePath;
+    mesh.cacheKey = imported.hash;
+    //staged, the cpu copies are no longer needed
+    imported.indices = {};
+    imported.mappedIndices = {};
+    imported.vertices = {};
+    imported.mappedVertices = {};
+    imported.packedVertices = {};
+    imported.meshlets = {};
+}
 
-    bool res=false;
 
-    auto ext = path.extension();
-    
-    std::string pathstr = path.string();
-    ccharp pathtoload = pathstr.c_str();
-    if(ext == ".glb")
-        res = loader.LoadBinaryFromFile(&gltf, &err, &warn, pathtoload);
-    else
-        res = loader.LoadASCIIFromFile(&gltf, &err, &warn, pathtoload);
-    if(res){
+//create every vulkan object of the file on the main thread. when deferred, textures and meshes are
+//queued as separate main thread jobs so a big file is spread over several frames
+static void build_scene(VulkanEngine* pengine, std::shared_ptr<LoadedGLTF> scene, std::shared_ptr<ImportedScene> imported, bool deferred){
+    LoadedGLTF& file = *scene;
 
-    }else{
-        std::cerr << "Failed to load glTF: " << warn << ", " << err << std::endl;
-        return {};
-    }
     //we can estimate the descriptors we will need accurately
     std::vector<DescriptorAllocatorGrowable::PoolSizeRatio> sizes = {
         {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,3},
         {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,3},
         {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,1}
     };
-    file.descriptorPool.init(pengine->_device, (u32)gltf.materials.size(),sizes);
-
-    for(auto & sampler : gltf.samplers){
-        VkSamplerCreateInfo sampl{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
-        sampl.maxLod = VK_LOD_CLAMP_NONE;
-        sampl.minLod = 0;
-        sampl.magFilter = extract_filter(sampler.magFilter);
-        sampl.minFilter = extract_filter(sampler.minFilter);
-        sampl.mipmapMode = extract_mipmap_mode(sampler.minFilter);
-        VkSampler newSampler;
-        vkCreateSampler(pengine->_device, &sampl, nullptr, &newSampler);
-        file.samplers.push_back(newSampler);
+    if(!pengine->bindlessMaterials){
+        //per thread, the material sets are written on the pool
+        u32 threads = pengine->_threadPool.size() + 1;
+        file.descriptorPool.init(pengine->_device, std::max(1u, (u32)imported->materials.size() / threads), sizes);
     }
+
+    //created per material through the sampler cache
+    file.samplerInfos = imported->samplers;
+    file.samplerGeneration = pengine->_samplers.generation;
     //temporal arrays for all the objects to use while creating the GLTF data
     std::vector<std::shared_ptr<MeshAsset>> meshes;
     std::vector<std::shared_ptr<Node>> nodes;
-    std::vector<AllocatedImage> images;
     std::vector<std::shared_ptr<GLTFMaterial>> materials;
-    for(auto&image : gltf.images){
-        //images.push_back(pengine->_errorCheckerboardImage);
-        VkExtent3D imageSize;
-        imageSize.width = image.width;
-        imageSize.height = image.height;
-        imageSize.depth = 1;
-
-        AllocatedImage newImage = pengine->create_image(image.image.data(), imageSize, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT, false);
-        if(newImage.image == VK_NULL_HANDLE){
-            images.push_back(pengine->_errorCheckerboardImage);
-            fmt::print("Failed to load GLTF texture");
+
+    //grey until the texture is created and uploaded
+    size_t imageCount = imported->images.size();
+    file.textures.assign(imageCount, pengine->_greyImage);
+    file.textureStreams.assign(imageCount, UINT32_MAX);
+    file.textureHashes.assign(imageCount, 0);
+    for(size_t i = 0; i < imageCount; ++i){
+        if(deferred){
+            pengine->run_on_main_thread([pengine, scene, imported, i](){
+                create_texture(pengine, *scene, imported->images[i], i);
+            });
         }else{
-            images.push_back(newImage);
-            file.images[image.name.c_str()]= newImage;
+            create_texture(pengine, file, imported->images[i], i);
         }
     }
-    //create buffer to hote the material data
-    file.materialDataBuffer = pengine->create_buffer(sizeof(GLTFMetallic_Roughness::MaterialConstants)* gltf.materials.size(),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
 
-    i32 data_index=0;
-    GLTFMetallic_Roughness::MaterialConstants * sceneMaterialConstants = (GLTFMetallic_Roughness::MaterialConstants*)file.materialDataBuffer.allocationInfo.pMappedData;
+    //create buffer to hote the material data, bindless materials keep theirs in the engine's table
+    GLTFMetallic_Roughness::MaterialConstants * sceneMaterialConstants = nullptr;
+    if(!pengine->bindlessMaterials){
+        file.materialDataBuffer = pengine->create_buffer(sizeof(GLTFMetallic_Roughness::MaterialConstants)* std::max<size_t>(1, imported->materials.size()),
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        sceneMaterialConstants = (GLTFMetallic_Roughness::MaterialConstants*)file.materialDataBuffer.allocationInfo.pMappedData;
+    }
 
-    for(auto& mat : gltf.materials){
+    //the distinct sets are allocated and written together once every material is resolved
+    std::vector<MaterialSetWrite> setWrites;
+    std::vector<u64> setKeys;
+    u32 data_index=0;
+    for(auto& mat : imported->materials){
         std::shared_ptr<GLTFMaterial> newMat = std::make_shared<GLTFMaterial>();
         materials.push_back(newMat);
         file.materials[mat.name.c_str()] =  newMat;
 
-        GLTFMetallic_Roughness::MaterialConstants constants;
-        constants.colorFactor = vec4(mat.pbrMetallicRoughness.baseColorFactor[0],mat.pbrMetallicRoughness.baseColorFactor[1],
-            mat.pbrMetallicRoughness.baseColorFactor[2], mat.pbrMetallicRoughness.baseColorFactor[3]);
-        constants.metalRoughnessFactor.x = (float)mat.pbrMetallicRoughness.metallicFactor;
-        constants.metalRoughnessFactor.y = (float)mat.pbrMetallicRoughness.roughnessFactor;
-        //write material parameters to buffer
-        sceneMaterialConstants[data_index] = constants;
-
-        MaterialPass passType = MaterialPass::MainColor;
-        if(mat.alphaMode == "BLEND"){
-            passType = MaterialPass::Transparent;
-        }
-
-        GLTFMetallic_Roughness::MaterialResources materialResources;
-        //default the material textures
-        materialResources.colorImage = pengine->_whiteImage;
-        materialResources.colorSampler = pengine->_defaultSamplerLinear;
-        materialResources.metalRoughImage = pengine->_whiteImage;
-        materialResources.metalRoughSampler = pengine->_defaultSamplerLinear;
-
-        //set the uniform buffer for the material data
-        materialResources.dataBuffer = file.materialDataBuffer.buffer;
-        materialResources.dataBufferOffset = data_index * sizeof(GLTFMetallic_Roughness::MaterialConstants);
-        //grab textures from gltf file
-        if(mat.pbrMetallicRoughness.baseColorTexture.index>=0){
-            size_t img = gltf.textures[mat.pbrMetallicRoughness.baseColorTexture.index].source;
-            size_t sampler = gltf.textures[mat.pbrMetallicRoughness.baseColorTexture.index].sampler;
-
-            materialResources.colorImage = images[img];
-            materialResources.colorSampler = file.samplers[sampler];
+        if(sceneMaterialConstants){
+            GLTFMetallic_Roughness::MaterialConstants constants;
+            constants.colorFactor = mat.colorFactor;
+            constants.metalRoughnessFactor = mat.metalRoughnessFactor;
+            //write material parameters to buffer
+            sceneMaterialConstants[data_index] = constants;
         }
+
         //build material
-        newMat->data = pengine->metalRoughMaterial.write_material(pengine->_device, passType, materialResources, file.descriptorPool);
+        PendingMaterial pending{newMat, mat.passType, data_index, mat.colorImage, mat.colorSampler, mat.colorFactor, mat.metalRoughnessFactor,
+            mat.uvTransform, UINT32_MAX, VK_NULL_HANDLE};
+        newMat->data = write_gltf_material(pengine, file, pending, &setWrites);
+        setKeys.push_back(pending.setKey);
+        if(mat.colorImage >= 0){
+            pending.residentLevel = texture_level(pengine, file, mat.colorImage);
+            pending.image = texture_image(pengine, file, mat.colorImage).image;
+            newMat->textureStream = file.textureStreams[mat.colorImage];
+        }
+        //untextured ones too, they sample the engine's default samplers
+        file.pendingMaterials.push_back(pending);
 
         data_index++;
     }
-    //use the same vectors for all meshes so that the memory doesn't reallocate often
-    std::vector<u32> indices;
-    std::vector<Vertex> vertices;
-    for(auto& mesh : gltf.meshes){
+    if(!setWrites.empty()){
+        //each thread allocates from its own pools of the file, and the writes touch different sets
+        auto writeStart = std::chrono::system_clock::now();
+        pengine->_threadPool.parallel_for((u32)setWrites.size(), [&](u32 i){
+            MaterialSetWrite& write = setWrites[i];
+            write.shared->instance = pengine->metalRoughMaterial.write_material(pengine->_device, write.passType, write.resources,
+                file.descriptorPool.local(pengine->_device));
+        });
+        for(size_t m = 0; m < materials.size(); ++m){
+            materials[m]->data = file.materialSets[setKeys[m]].instance;
+            materials[m]->data.uvTransform = imported->materials[m].uvTransform;
+        }
+        auto writeEnd = std::chrono::system_clock::now();
+        fmt::println("{} material sets for {} materials written on {} threads in {:.2f} ms", setWrites.size(), materials.size(),
+            pengine->_threadPool.size() + 1, std::chrono::duration_cast<std::chrono::microseconds>(writeEnd - writeStart).count() / 1000.f);
+    }
+    //primitives without a material use the first one
+    if(materials.empty()){
+        std::shared_ptr<GLTFMaterial> newMat = std::make_shared<GLTFMaterial>();
+        materials.push_back(newMat);
+        file.materials["default"] = newMat;
+        PendingMaterial pending{newMat, MaterialPass::MainColor, 0, -1, -1, vec4(1.f), vec4(1.f, 0.5f, 0.f, 0.f),
+            vec4(1.f, 1.f, 0.f, 0.f), UINT32_MAX, VK_NULL_HANDLE};
+        if(sceneMaterialConstants){
+            sceneMaterialConstants[0] = {pending.colorFactor, pending.metalRoughnessFactor};
+        }
+        newMat->data = write_gltf_material(pengine, file, pending);
+        file.pendingMaterials.push_back(pending);
+    }
+    file.materialList = materials;
+
+    for(size_t m = 0; m < imported->meshes.size(); ++m){
+        ImportedMesh& src = imported->meshes[m];
         std::shared_ptr<MeshAsset> newmesh = std::make_shared<MeshAsset>();
         meshes.push_back(newmesh);
-        file.meshes[mesh.name.c_str()] = newmesh;
-        newmesh->name = mesh.name;
-
-        for(auto&& p : mesh.primitives){
-            GeoSurface newSurface;
-            newSurface.startIndex = (u32)indices.size();
-            newSurface.count = (u32)gltf.accessors[p.indices].count;
-
-            u32 initial_vtx = (u32)vertices.size();
-            //load indexes
-            {
-                const tinygltf::Accessor& accessor = gltf.accessors[p.indices];
-                const tinygltf::BufferView& view = gltf.bufferViews[accessor.bufferView];
-                newSurface.count = (u32)accessor.count;
-                switch(accessor.componentType){
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:{
-                        u16*ptr = (u16*)(gltf.buffers[view.buffer].data.data() + (accessor.byteOffset + view.byteOffset));
-                        for(size_t i = 0; i < accessor.count; ++i){
-                            indices.push_back(ptr[i]+initial_vtx);
-                        }
-                    }
-                        break;
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:{
-                        u32*ptr = (u32*)(gltf.buffers[view.buffer].data.data() + (accessor.byteOffset + view.byteOffset));
-                        for(size_t i = 0; i < accessor.count; ++i){
-                            indices.push_back(ptr[i]+initial_vtx);
-                        }
-                    }
-                        break;
-                    default:
-                    assert(0);
-                        break;
-                }
-            }
-            //load vertex positions
-            {
-                auto attr = p.attributes["POSITION"];
-                const tinygltf::Accessor& accessor = gltf.accessors[attr];
-                const tinygltf::BufferView& view = gltf.bufferViews[accessor.bufferView];
-                vec3*ptr = (vec3*)(gltf.buffers[view.buffer].data.data() + (accessor.byteOffset + view.byteOffset));
-                vertices.resize(vertices.size() + accessor.count);
-                for(size_t i=0; i < accessor.count; i++){
-                    Vertex vtx{};
-                    vtx.position = *ptr++;                                           
-                    vtx.normal = vec3(1.f, 0.f, 0.f);
-                    vtx.color = vec4(1.f);
-                    vertices[initial_vtx+i] = vtx;
-
-                }
-            }
-            //load vtx normals
-            {
-                //assert(p.attributes.find("NORMAL") != p.attributes.end());
-                auto attr = p.attributes["NORMAL"];
-                if(attr >= 0){
-                    const tinygltf::Accessor& accessor = gltf.accessors[attr];
-                    const tinygltf::BufferView& view = gltf.bufferViews[accessor.bufferView];
-                    vec3*ptr = (vec3*)(gltf.buffers[view.buffer].data.data() + (accessor.byteOffset + view.byteOffset));
-                    for(size_t i=0; i < accessor.count; i++){
-                        vertices[initial_vtx+i].normal = *ptr++;                        
-                    }
-                }
-            }
-            //load UVs
-            {
-                //assert(p.attributes.find("TEXCOORD_0") != p.attributes.end());
-                if(p.attributes.find("TEXCOORD_0")!=p.attributes.end()){
-                    auto attr = p.attributes["TEXCOORD_0"];                
-                    const tinygltf::Accessor& accessor = gltf.accessors[attr];
-                    const tinygltf::BufferView& view = gltf.bufferViews[accessor.bufferView];
-                    vec2*ptr = (vec2*)(gltf.buffers[view.buffer].data.data() + (accessor.byteOffset + view.byteOffset));
-                    for(size_t i=0; i < accessor.count; i++){
-                        vec2 uv = *ptr++;
-                        vertices[initial_vtx+i].uv_x = uv.x;
-                        vertices[initial_vtx+i].uv_y = uv.y;                        
-                    }                
-                }
-            }
-            //load vertex colors
-            {
-                //assert(p.attributes.find("COLOR_0") != p.attributes.end());
-                if(p.attributes.find("COLOR_0")!=p.attributes.end()){
-                    auto attr = p.attributes["COLOR_0"];                
-                    const tinygltf::Accessor& accessor = gltf.accessors[attr];
-                    const tinygltf::BufferView& view = gltf.bufferViews[accessor.bufferView];
-                    vec4 *ptr = (vec4*)(gltf.buffers[view.buffer].data.data() + (accessor.byteOffset + view.byteOffset));
-                    for(size_t i=0; i < accessor.count; i++){                    
-                        vec4 color = *ptr++;
-                        vertices[initial_vtx+i].color = color;                    
-                    }                
-                }
-            }
-
-            if(p.material>=0){
-                newSurface.material = materials[p.material];
-            }else{
-                newSurface.material = materials[0];
-            }
-            //loop the vertices of this surface, find min/max bounds
-            vec3 minpos = vertices[initial_vtx].position;
-            vec3 maxpos = vertices[initial_vtx].position;
-            for(i32 i=initial_vtx; i < (i32)vertices.size(); ++i){
-                minpos = glm::min(minpos, vertices[i].position);
-                maxpos = glm::max(maxpos, vertices[i].position);
-            }
-            //calculate origin and extents from the min/max, use extent length for radius
-            newSurface.bounds.origin = (maxpos + minpos) * 0.5f;
-            newSurface.bounds.extents = (maxpos - minpos) * 0.5f;
-            newSurface.bounds.sphereRadius = glm::length(newSurface.bounds.extents);
-            newmesh->surfaces.push_back(newSurface);
+        file.meshes[src.name.c_str()] = newmesh;
+        newmesh->name = src.name;
+        newmesh->surfaces = src.surfaces;
+        for(size_t s = 0; s < newmesh->surfaces.size(); ++s){
+            i32 material = src.surfaceMaterials[s];
+            newmesh->surfaces[s].material = material >= 0 ? materials[material] : materials[0];
+        }
+        //until the buffers exist the mesh node draws nothing
+        if(deferred){
+            pengine->run_on_main_thread([pengine, newmesh, imported, m](){
+                upload_mesh(pengine, *newmesh, imported->meshes[m]);
+            });
+        }else{
+            upload_mesh(pengine, *newmesh, src);
         }
-        newmesh->meshBuffers = pengine->uploadMesh(indices,vertices);        
     }
+
     //load all noddes and their meshes
-    for(auto& node : gltf.nodes){
+    for(auto& node : imported->nodes){
         std::shared_ptr<Node> newNode;
 
         //find if the node has a mesh, and if it does hook it to the mesh pointer and allocate it with the meshnode class
         if(node.mesh>-1){
             newNode = std::make_shared<MeshNode>();
-            static_cast<MeshNode*>(newNode.get())->mesh = meshes[node.mesh];            
+            static_cast<MeshNode*>(newNode.get())->mesh = meshes[node.mesh];
         }else{
             newNode = std::make_shared<Node>();
         }
 
         nodes.push_back(newNode);
         file.nodes[node.name.c_str()];
-        vec3 tl = vec3(0.f);
-        vec3 sc = vec3(1.f);
-        quat rot = quat();
-        mat4 xform = mat4(1.f);
-        if(node.rotation.size()==4)
-			rot = glm::make_quat(node.rotation.data());
-		if(node.translation.size() == 3)
-			tl = glm::make_vec3(node.translation.data());
-		if(node.scale.size() == 3)
-			sc = glm::make_vec3(node.scale.data());
-		if(node.matrix.size() == 16)
-			newNode->localTransform = glm::make_mat4x4(node.matrix.data());
-        else{
-            mat4 tm = glm::translate(mat4(1.f),tl);
-            mat4 rm = mat4(rot);
-            mat4 sm = glm::scale(mat4(1.f),sc);
-            newNode->localTransform = tm * rm * sm;
-        }        
+        newNode->localTransform = node.localTransform;
     }
     //run loop again to setup transform hierarchy
-    for(size_t i=0; i < gltf.nodes.size(); ++i){
-        auto& node = gltf.nodes[i];
+    for(size_t i=0; i < imported->nodes.size(); ++i){
         std::shared_ptr<Node>& sceneNode = nodes[i];
 
-        for(auto& c : node.children){
+        for(u32 c : imported->nodes[i].children){
             sceneNode->children.push_back(nodes[c]);
             nodes[c]->parent = sceneNode;
         }
@@ -632,13 +971,105 @@ std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanEngine * pengine, std:
             node->refreshTransform(mat4(1.f));
         }
     }
+    file.state = LoadState::Ready;
+    //dedup savings so far, deferred after the texture and mesh jobs queued above
+    if(deferred){
+        pengine->run_on_main_thread([pengine](){
+            pengine->_assetCache.print_stats();
+        });
+    }else{
+        pengine->_assetCache.print_stats();
+    }
+}
+
+std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanEngine * pengine, std::string_view filePath){
+    fmt::print("LOading GLTF: {}", filePath);
+
+    std::shared_ptr<LoadedGLTF> scene = std::make_shared<LoadedGLTF>();
+
+    scene->creator = pengine;
+    LoadedGLTF& file = *scene.get();
+    //milliseconds between two time points, for the load breakdown
+    auto elapsed_ms = [](auto start, auto end){
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.f;
+    };
+    auto loadStart = std::chrono::system_clock::now();
+    u32 firstSubmit = pengine->_uploader.submitCount;
+
+    auto imported = import_scene(pengine, std::string(filePath));
+    if(!imported){
+        file.state = LoadState::Failed;
+        return {};
+    }
+    auto buildStart = std::chrono::system_clock::now();
+    auto submitStart = buildStart;
+    {
+        //every copy of this file is collected and submitted together when the scope closes
+        UploadBatchScope uploadBatch(pengine->_uploader, &file.uploadTicket);
+        build_scene(pengine, scene, imported, false);
+        submitStart = std::chrono::system_clock::now();
+    }
+    auto loadEnd = std::chrono::system_clock::now();
+
+    fmt::println("glTF {} loaded in {:.2f} ms: {} {:.2f} ({} meshes), build {:.2f} ({} images, {} materials), submit {:.2f} ({} submits)",
+        filePath, elapsed_ms(loadStart, loadEnd), imported->fromCooked ? "map cooked" : "parse and convert",
+        elapsed_ms(loadStart, buildStart), imported->meshes.size(),
+        elapsed_ms(buildStart, submitStart), imported->images.size(), imported->materials.size(),
+        elapsed_ms(submitStart, loadEnd), pengine->_uploader.submitCount - firstSubmit);
     return scene;
-#endif
-    
+}
 
+std::shared_ptr<LoadedGLTF> loadGltfAsync(VulkanEngine * pengine, std::string_view filePath){
+    std::shared_ptr<LoadedGLTF> scene = std::make_shared<LoadedGLTF>();
+    scene->creator = pengine;
+    fmt::println("Loading GLTF in the background: {}", filePath);
+    std::string path{filePath};
+    pengine->_threadPool.push([pengine, scene, path](){
+        auto loadStart = std::chrono::system_clock::now();
+        auto imported = import_scene(pengine, path);
+        if(!imported){
+            scene->state = LoadState::Failed;
+            return;
+        }
+        auto loadEnd = std::chrono::system_clock::now();
+        fmt::println("glTF {} {} on a worker in {:.2f} ms", path, imported->fromCooked ? "mapped from the cooked file" : "parsed",
+            std::chrono::duration_cast<std::chrono::microseconds>(loadEnd - loadStart).count() / 1000.f);
+
+        //everything below creates vulkan objects or records uploads
+        pengine->run_on_main_thread([pengine, scene, imported](){
+            build_scene(pengine, scene, imported, true);
+        });
+    });
+    return scene;
 }
 
 void LoadedGLTF::Draw(const mat4 & topMatrix, DrawContext& ctx){
+    //still on the loader thread, nothing to draw yet
+    if(state.load() != LoadState::Ready){
+        return;
+    }
+    //follow the textures as their mips become resident and streamed ones change size, and the global
+    //sampler settings. write_gltf_material keeps the old set around for the frames in flight
+    bool refilter = samplerGeneration != creator->_samplers.generation;
+    samplerGeneration = creator->_samplers.generation;
+    for(PendingMaterial& pending : pendingMaterials){
+        if(pending.colorImage < 0){
+            //only the default samplers of the engine can change under it
+            if(refilter){
+                pending.material->data = write_gltf_material(creator, *this, pending);
+            }
+            continue;
+        }
+        u32 level = texture_level(creator, *this, pending.colorImage);
+        VkImage image = texture_image(creator, *this, pending.colorImage).image;
+        if(!refilter && level == pending.residentLevel && image == pending.image){
+            continue;
+        }
+        pending.material->data = write_gltf_material(creator, *this, pending);
+        pending.material->textureStream = textureStreams[pending.colorImage];
+        pending.residentLevel = level;
+        pending.image = image;
+    }
     //create renderables from the scenenodes
     for(auto& n : topNodes){
         n->Draw(topMatrix, ctx);
@@ -647,24 +1078,45 @@ void LoadedGLTF::Draw(const mat4 & topMatrix, DrawContext& ctx){
 
 void LoadedGLTF::clearAll(){
     VkDevice device  = creator->_device;
+    AssetCache& cache = creator->_assetCache;
 
     descriptorPool.destroy_pools(device);
     creator->destroy_buffer(materialDataBuffer);
+    for(auto& m : materialList){
+        if(m->data.bindlessIndex != UINT32_MAX){
+            creator->_bindless.remove_material(m->data.bindlessIndex);
+        }
+    }
 
     for(auto& [k, v] : meshes){
+        //shared buffers go when the last file using them does
+        if(v->cacheKey != 0 && !cache.release_mesh(v->cacheKey)){
+            continue;
+        }
         creator->destroy_buffer(v->meshBuffers.indexBuffer);
         creator->destroy_buffer(v->meshBuffers.vertexBuffer);
+        if(v->meshBuffers.meshletBuffer.buffer != VK_NULL_HANDLE){
+            creator->destroy_buffer(v->meshBuffers.meshletBuffer);
+        }
     }
 
-    for(auto& [k, v] : images){
-        if(v.image == creator->_errorCheckerboardImage.image){
+    for(size_t i = 0; i < textures.size(); ++i){
+        AllocatedImage& v = textures[i];
+        if(v.image == creator->_errorCheckerboardImage.image || v.image == creator->_greyImage.image){
             //done destroy default
             continue;
         }
+        if(i < textureHashes.size() && textureHashes[i] != 0 && !cache.release_texture(textureHashes[i])){
+            continue;
+        }
+        if(i < textureStreams.size() && textureStreams[i] != UINT32_MAX){
+            //destroyed by the streamer, which may have replaced the image since
+            creator->_textureStreamer.remove(textureStreams[i]);
+            continue;
+        }
         creator->destroy_image(v);
     }
-    for(auto& sampler : samplers){
-        vkDestroySampler(device, sampler, nullptr);
-
+    for(PendingMaterial& pending : pendingMaterials){
+        creator->_samplers.release(pending.sampler);
     }
-}
\ No newline at end of file
+}
@@ -4,11 +4,28 @@
 #include <vk_descriptors.h>
 #include <unordered_map>
 #include <filesystem>
+#include <atomic>
+#include <array>
 
 class VulkanEngine;
 
+//stable index of a mesh or material into the DrawContext slot tables, taken when it is created and given
+//back when it is destroyed, from any thread. copies get an id of their own
+class DrawId{
+    u32 _value;
+public:
+    DrawId();
+    DrawId(const DrawId&) : DrawId() {}
+    DrawId& operator=(const DrawId&){ return *this; }
+    ~DrawId();
+    u32 value() const { return _value; }
+};
+
 struct GLTFMaterial{
     MaterialInstance data;
+    //texture streamer handle of the color texture, the draws report how large it is on screen
+    u32 textureStream{UINT32_MAX};
+    DrawId drawId;
 };
 
 struct Bounds{
@@ -18,11 +35,27 @@ struct Bounds{
 };
 
 
+//simplified version of a surface, its indices live in the same index buffer behind the full detail ones
+struct SurfaceLod{
+    u32 startIndex;
+    u32 count;
+    //largest distance the surface moved from full detail, in model units
+    float error;
+};
+
+constexpr u32 MAX_SURFACE_LODS = 5;
+
 struct GeoSurface{
     u32 startIndex;
     u32 count;
     Bounds bounds;
     std::shared_ptr<GLTFMaterial> material;
+    //coarser and coarser levels, level 0 is the surface itself
+    std::array<SurfaceLod, MAX_SURFACE_LODS> lods{};
+    u32 lodCount{0};
+    //range of the mesh meshlet buffer covering this surface, empty when it is drawn whole
+    u32 firstMeshlet{0};
+    u32 meshletCount{0};
 };
 
 struct MeshAsset{
@@ -30,6 +63,9 @@ struct MeshAsset{
 
     std::vector<GeoSurface> surfaces;
     GPUMeshBuffers meshBuffers;
+    //asset cache key of the buffers, 0 when they are owned by the mesh alone
+    u64 cacheKey{0};
+    DrawId drawId;
 };
 
 
@@ -37,6 +73,40 @@ struct MeshAsset{
 
 std::optional<std::vector<std::shared_ptr<MeshAsset>>> loadGltfMeshes(VulkanEngine* engine, std::filesystem::path filePath);
 
+//parser used for glTF files without an up to date cooked file
+enum class GltfBackend : u8{
+    TinyGltf,
+    FastGltf
+};
+
+enum class LoadState : u8{
+    Loading,
+    Ready,
+    Failed
+};
+
+//material drawn with placeholder textures until the ones it references are resident. stays tracked
+//for as long as the file is loaded, streamed textures change size and the sampler settings can change
+struct PendingMaterial{
+    std::shared_ptr<GLTFMaterial> material;
+    MaterialPass passType;
+    u32 dataIndex;
+    i32 colorImage;
+    i32 colorSampler;
+    //copied into the bindless material table, the descriptor set path reads them from materialDataBuffer
+    vec4 colorFactor;
+    vec4 metalRoughnessFactor;
+    //MaterialInstance::uvTransform, into the atlas the color texture was packed into
+    vec4 uvTransform;
+    //mip level and image the current descriptor set was written for, UINT32_MAX for the placeholder
+    u32 residentLevel;
+    VkImage image;
+    //sampler cache reference held by the current descriptor set
+    VkSampler sampler{VK_NULL_HANDLE};
+    //LoadedGLTF::materialSets entry it draws with, descriptor set path only
+    u64 setKey{0};
+};
+
 
 
 
@@ -48,22 +118,55 @@ struct LoadedGLTF : public IRenderable{
     std::unordered_map<std::string, std::shared_ptr<MeshAsset>> meshes;
     std::unordered_map<std::string, std::shared_ptr<Node>> nodes;
     std::unordered_map<std::string, AllocatedImage> images;
+    //every image by glTF index, _greyImage until created and _errorCheckerboardImage if it failed
+    std::vector<AllocatedImage> textures;
+    //texture streamer handle of every image, UINT32_MAX when it isn't streamed
+    std::vector<u32> textureStreams;
+    //asset cache key of every image, 0 for the ones that aren't in the cache
+    std::vector<u64> textureHashes;
     std::unordered_map<std::string, std::shared_ptr<GLTFMaterial>> materials;
+    //every material by glTF index, names may repeat
+    std::vector<std::shared_ptr<GLTFMaterial>> materialList;
 
     //nodes that don't have a parent, for iterating through the file in tree order
     std::vector<std::shared_ptr<Node>> topNodes;
 
-    std::vector<VkSampler> samplers;
+    //create info of every sampler, the materials get theirs from the sampler cache clamped to the resident mip
+    std::vector<VkSamplerCreateInfo> samplerInfos;
+    //SamplerCache::generation the materials were written with
+    u32 samplerGeneration{0};
 
-    DescriptorAllocatorGrowable descriptorPool;
+    //material sets are written on the thread pool at load, each thread allocates from its own pools
+    DescriptorAllocatorPerThread descriptorPool;
 
     AllocatedBuffer materialDataBuffer;
 
     VulkanEngine* creator;
 
+    //covers every upload of a synchronous load, meshes and textures are gated individually
+    UploadTicket uploadTicket;
+
+    //set by the loader, nothing is drawn before the nodes exist
+    std::atomic<LoadState> state{LoadState::Loading};
+    //every material, written again as its texture streams in or the sampler settings change
+    std::vector<PendingMaterial> pendingMaterials;
+    //material set of every distinct combination of textures, sampler and constants, with the number of
+    //materials drawing with it. materials whose textures were packed into the same atlas share one
+    struct SharedSet{
+        MaterialInstance instance;
+        u32 refs;
+    };
+    std::unordered_map<u64, SharedSet> materialSets;
+    //material sets no material uses since a frame, written over again once that frame is out of flight
+    std::deque<std::pair<VkDescriptorSet, u64>> retiredSets;
+
     ~LoadedGLTF(){ clearAll(); }
 
     virtual void Draw(const mat4& topMatrix, DrawContext& ctx);
 };
 
-std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanEngine*engine, std::string_view filePath);
\ No newline at end of file
+std::optional<std::shared_ptr<LoadedGLTF>> loadGltf(VulkanEngine*engine, std::string_view filePath);
+
+//returns right away, the file is parsed on a worker thread and its gpu objects are created
+//on the main thread over the next frames. the handle draws whatever is resident so far
+std::shared_ptr<LoadedGLTF> loadGltfAsync(VulkanEngine*engine, std::string_view filePath);
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "vk_meshlets.h"
+#include "vk_engine.h"
+#include "vk_loader.h"
+#include <vk_initializers.h>
+#include <glm/matrix.hpp>
+#include <cstring>
+
+void MeshletCuller::init(VulkanEngine* engine){
+    _engine = engine;
+    VkDevice device = engine->_device;
+
+    VkPushConstantRange range{};
+    range.offset = 0;
+    range.size = sizeof(PushConstants);
+    range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    //everything is reached through buffer addresses, no descriptor sets
+    VkPipelineLayoutCreateInfo layoutInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &range;
+    VK_CHECK(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &_layout));
+
+    VkShaderModule shader = engine->get_shader("../shaders/meshlet_cull.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+    if(shader == VK_NULL_HANDLE){
+        fmt::println("Meshlet culling shader failed to build, surfaces are drawn whole");
+        return;
+    }
+    VkPipelineShaderStageCreateInfo stageInfo{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+    stageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    stageInfo.module = shader;
+    stageInfo.pName = "main";
+
+    VkComputePipelineCreateInfo pipelineInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    pipelineInfo.layout = _layout;
+    pipelineInfo.stage = stageInfo;
+    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_pipeline));
+    vkDestroyShaderModule(device, shader, nullptr);
+}
+
+void MeshletCuller::cleanup(){
+    VkDevice device = _engine->_device;
+    _draws.clear();
+    vkDestroyPipeline(device, _pipeline, nullptr);
+    vkDestroyPipelineLayout(device, _layout, nullptr);
+}
+
+void MeshletCuller::begin(const mat4& viewproj, vec3 cameraPosition, bool coneCulling){
+    _draws.clear();
+    _commandCount = 0;
+    _viewproj = viewproj;
+    _cameraPosition = cameraPosition;
+    _coneCulling = coneCulling;
+    _commands = {};
+    _counts = {};
+}
+
+u32 MeshletCuller::add(const mat4& worldMatrix, const GPUMeshBuffers& mesh, const GeoSurface& surface){
+    if(!available() || surface.meshletCount == 0 || mesh.meshletBufferAddress == 0 || _draws.size() >= MAX_DRAWS){
+        return UINT32_MAX;
+    }
+    Draw draw{};
+    draw.worldMatrix = worldMatrix;
+    draw.cameraPosition = glm::inverse(worldMatrix) * vec4(_cameraPosition, 1.f);
+    draw.meshlets = mesh.meshletBufferAddress;
+    draw.firstMeshlet = surface.firstMeshlet;
+    draw.meshletCount = surface.meshletCount;
+    draw.firstCommand = _commandCount;
+    _commandCount += surface.meshletCount;
+    _draws.push_back(draw);
+    return (u32)_draws.size() - 1;
+}
+
+void MeshletCuller::record(VkCommandBuffer cmd){
+    drawCount = (u32)_draws.size();
+    meshletCount = _commandCount;
+    if(_draws.empty()){
+        return;
+    }
+    VkDevice device = _engine->_device;
+    FrameData& frame = _engine->get_current_frame();
+
+    //rebuilt every frame like the scene uniform buffer, and freed with the frame
+    auto address = [&](const AllocatedBuffer& buffer){
+        VkBufferDeviceAddressInfo addrInfo{VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+        addrInfo.buffer = buffer.buffer;
+        return vkGetBufferDeviceAddress(device, &addrInfo);
+    };
+    AllocatedBuffer draws = _engine->create_buffer(_draws.size() * sizeof(Draw), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_CPU_TO_GPU);
+    memcpy(draws.allocationInfo.pMappedData, _draws.data(), _draws.size() * sizeof(Draw));
+    _commands = _engine->create_buffer(_commandCount * sizeof(VkDrawIndexedIndirectCommand),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+    _counts = _engine->create_buffer(_draws.size() * sizeof(u32),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY);
+    AllocatedBuffer commands = _commands;
+    AllocatedBuffer counts = _counts;
+    frame._deletionQueue.push_function([=, this](){
+        _engine->destroy_buffer(draws);
+        _engine->destroy_buffer(commands);
+        _engine->destroy_buffer(counts);
+    });
+
+    vkCmdFillBuffer(cmd, _counts.buffer, 0, VK_WHOLE_SIZE, 0);
+    VkMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    VkDependencyInfo depInfo{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    depInfo.memoryBarrierCount = 1;
+    depInfo.pMemoryBarriers = &barrier;
+    vkCmdPipelineBarrier2(cmd, &depInfo);
+
+    PushConstants pc{};
+    //gribb-hartmann, the side planes of the clip volume are w +- x and w +- y
+    for(u32 p = 0; p < 4; ++p){
+        u32 axis = p / 2;
+        float sign = (p % 2) ? -1.f : 1.f;
+        vec4 plane;
+        for(u32 c = 0; c < 4; ++c){
+            plane[c] = _viewproj[c][3] + sign * _viewproj[c][axis];
+        }
+        pc.planes[p] = plane / glm::length(vec3(plane));
+    }
+    pc.draws = address(draws);
+    pc.commands = address(_commands);
+    pc.counts = address(_counts);
+    pc.coneCulling = _coneCulling ? 1 : 0;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+    vkCmdPushConstants(cmd, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pc);
+    vkCmdDispatch(cmd, (u32)_draws.size(), 1, 1);
+
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier2(cmd, &depInfo);
+}
+
+void MeshletCuller::draw(VkCommandBuffer cmd, u32 drawIndex) const{
+    const Draw& draw = _draws[drawIndex];
+    vkCmdDrawIndexedIndirectCount(cmd, _commands.buffer, draw.firstCommand * sizeof(VkDrawIndexedIndirectCommand),
+        _counts.buffer, drawIndex * sizeof(u32), draw.meshletCount, sizeof(VkDrawIndexedIndirectCommand));
+}
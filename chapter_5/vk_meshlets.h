@@ -0,0 +1,72 @@
+#pragma once
+#include <vk_types.h>
+#include <vector>
+
+class VulkanEngine;
+struct GeoSurface;
+
+//culls the meshlets of the opaque surfaces on the gpu (shaders/meshlet_cull.comp) by frustum and normal cone,
+//and compacts the survivors into per surface indirect draws consumed by vkCmdDrawIndexedIndirectCount.
+//plain compute and index buffers, no mesh shader support needed
+class MeshletCuller{
+public:
+    //one surface to cull, the layout matches the shader
+    struct Draw{
+        mat4 worldMatrix;
+        //camera in the object space of the surface, the cone test runs there
+        vec4 cameraPosition;
+        VkDeviceAddress meshlets;
+        u32 firstMeshlet;
+        u32 meshletCount;
+        //first of the meshletCount commands reserved for the surface
+        u32 firstCommand;
+        u32 pad[3];
+    };
+
+private:
+    struct PushConstants{
+        //left, right, bottom and top planes in world space, normalized
+        vec4 planes[4];
+        VkDeviceAddress draws;
+        VkDeviceAddress commands;
+        VkDeviceAddress counts;
+        u32 coneCulling;
+        u32 pad;
+    };
+
+    VulkanEngine* _engine{nullptr};
+    VkPipelineLayout _layout{VK_NULL_HANDLE};
+    VkPipeline _pipeline{VK_NULL_HANDLE};
+
+    std::vector<Draw> _draws;
+    u32 _commandCount{0};
+    mat4 _viewproj;
+    vec3 _cameraPosition;
+    bool _coneCulling{false};
+    //this frame's output, valid between record() and the end of the frame
+    AllocatedBuffer _commands;
+    AllocatedBuffer _counts;
+
+public:
+    //one workgroup per draw
+    static constexpr u32 MAX_DRAWS = 65535;
+
+    //last frame's numbers, for the stats window
+    u32 drawCount{0};
+    u32 meshletCount{0};
+
+    void init(VulkanEngine* engine);
+    void cleanup();
+
+    //false when the shader failed to build, everything is drawn whole then
+    bool available() const { return _pipeline != VK_NULL_HANDLE; }
+
+    //start collecting the surfaces of a frame
+    void begin(const mat4& viewproj, vec3 cameraPosition, bool coneCulling);
+    //queue a surface with meshlets, returns its draw index or UINT32_MAX when it has to be drawn whole
+    u32 add(const mat4& worldMatrix, const GPUMeshBuffers& mesh, const GeoSurface& surface);
+    //cull every queued surface, outside of rendering and before any draw()
+    void record(VkCommandBuffer cmd);
+    //draw the meshlets of the surface that survived, the mesh index buffer has to be bound
+    void draw(VkCommandBuffer cmd, u32 drawIndex) const;
+};
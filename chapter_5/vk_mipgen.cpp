@@ -0,0 +1,220 @@
+#include "vk_mipgen.h"
+#include "vk_engine.h"
+#include <vk_initializers.h>
+#include <vk_images.h>
+#include <cmath>
+
+void MipGenerator::init(VulkanEngine* engine){
+    _engine = engine;
+    VkDevice device = engine->_device;
+
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(engine->_physical, VK_FORMAT_R8G8B8A8_UNORM, &props);
+    //the shader indexes its array of level views
+    _storageSupported = (props.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) != 0 && engine->_storageImageIndexingSupported;
+
+    DescriptorLayoutBuilder builder;
+    builder.add_binding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_LEVELS);
+    builder.add_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    _setLayout = builder.build(device, VK_SHADER_STAGE_COMPUTE_BIT);
+
+    VkPushConstantRange range{};
+    range.offset = 0;
+    range.size = sizeof(PushConstants);
+    range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkPipelineLayoutCreateInfo layoutInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &_setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &range;
+    VK_CHECK(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &_layout));
+
+    VkShaderModule shader = VK_NULL_HANDLE;
+    if(_storageSupported){
+        shader = engine->get_shader("../shaders/mipgen.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+    }
+    if(shader == VK_NULL_HANDLE){
+        //blits only
+        _storageSupported = false;
+    }else{
+        VkPipelineShaderStageCreateInfo stageInfo{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+        stageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        stageInfo.module = shader;
+        stageInfo.pName = "main";
+
+        VkComputePipelineCreateInfo pipelineInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+        pipelineInfo.layout = _layout;
+        pipelineInfo.stage = stageInfo;
+        VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_pipeline));
+        vkDestroyShaderModule(device, shader, nullptr);
+    }
+
+    _counters = engine->create_buffer(COUNTER_SLOTS * sizeof(u32), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY);
+    engine->immediate_submit([&](VkCommandBuffer cmd){
+        vkCmdFillBuffer(cmd, _counters.buffer, 0, VK_WHOLE_SIZE, 0);
+    });
+}
+
+void MipGenerator::cleanup(){
+    VkDevice device = _engine->_device;
+    _requests.clear();
+    _engine->destroy_buffer(_counters);
+    vkDestroyPipeline(device, _pipeline, nullptr);
+    vkDestroyPipelineLayout(device, _layout, nullptr);
+    vkDestroyDescriptorSetLayout(device, _setLayout, nullptr);
+}
+
+bool MipGenerator::supports(VkFormat format, VkExtent3D extent) const{
+    //the shader declares rgba8 and its last workgroup reduces at most a 64x64 mip 6
+    return _storageSupported && format == VK_FORMAT_R8G8B8A8_UNORM && std::max(extent.width, extent.height) <= 4096;
+}
+
+void MipGenerator::queue(const AllocatedImage& image, UploadTicket ticket){
+    Request request;
+    request.image = image;
+    request.mipLevels = static_cast<u32>(std::floor(std::log2(std::max(image.imageExtent.width, image.imageExtent.height))))+1;
+    request.ticket = ticket;
+    if(request.mipLevels > 1){
+        _requests.push_back(request);
+    }
+}
+
+void MipGenerator::record(VkCommandBuffer cmd){
+    computeCount = 0;
+    blitCount = 0;
+    if(_requests.empty()){
+        return;
+    }
+    VkDevice device = _engine->_device;
+    FrameData& frame = _engine->get_current_frame();
+
+    std::vector<Request> computeRequests;
+    std::erase_if(_requests, [&](const Request& r){
+        if(!_engine->_uploader.is_ready(r.ticket)){
+            return false;
+        }
+        if(supports(r.image.imageFormat, r.image.imageExtent)){
+            computeRequests.push_back(r);
+        }else{
+            //fallback, one blit and one barrier per level
+            vkutil::transition_image(cmd, r.image.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            vkutil::generate_mipmaps(cmd, r.image.image, VkExtent2D{r.image.imageExtent.width, r.image.imageExtent.height});
+            blitCount++;
+        }
+        return true;
+    });
+    if(computeRequests.empty()){
+        return;
+    }
+
+    //every image of this frame goes to general in one barrier and back in another
+    std::vector<VkImageMemoryBarrier2> barriers;
+    barriers.reserve(computeRequests.size());
+    for(auto& r : computeRequests){
+        VkImageMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_NONE;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.image = r.image.image;
+        barrier.subresourceRange = vkinit::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT);
+        barriers.push_back(barrier);
+    }
+    VkDependencyInfo depInfo{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    depInfo.imageMemoryBarrierCount = (u32)barriers.size();
+    depInfo.pImageMemoryBarriers = barriers.data();
+    vkCmdPipelineBarrier2(cmd, &depInfo);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+
+    for(u32 i = 0; i < (u32)computeRequests.size(); ++i){
+        const Request& r = computeRequests[i];
+        u32 slot = i % COUNTER_SLOTS;
+        if(i > 0 && slot == 0){
+            //counters wrapped, the previous users of each slot have to finish their reset first
+            VkMemoryBarrier2 counterBarrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+            counterBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            counterBarrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+            counterBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            counterBarrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+            VkDependencyInfo counterDep{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+            counterDep.memoryBarrierCount = 1;
+            counterDep.pMemoryBarriers = &counterBarrier;
+            vkCmdPipelineBarrier2(cmd, &counterDep);
+        }
+
+        //one view per level, unused slots repeat the last level so every descriptor is valid
+        VkDescriptorImageInfo imageInfos[MAX_LEVELS];
+        VkImageView views[MAX_LEVELS];
+        for(u32 level = 0; level < r.mipLevels; ++level){
+            VkImageViewCreateInfo viewInfo = vkinit::imageview_create_info(r.image.imageFormat, r.image.image, VK_IMAGE_ASPECT_COLOR_BIT);
+            viewInfo.subresourceRange.baseMipLevel = level;
+            viewInfo.subresourceRange.levelCount = 1;
+            VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &views[level]));
+        }
+        for(u32 level = 0; level < MAX_LEVELS; ++level){
+            imageInfos[level] = {};
+            imageInfos[level].imageView = views[std::min(level, r.mipLevels-1)];
+            imageInfos[level].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        }
+        u32 viewCount = r.mipLevels;
+        frame._deletionQueue.push_function([=](){
+            for(u32 level = 0; level < viewCount; ++level){
+                vkDestroyImageView(device, views[level], nullptr);
+            }
+        });
+
+        VkDescriptorSet set = frame._frameDescriptors.allocate(device, _setLayout);
+
+        VkDescriptorBufferInfo bufferInfo{};
+        bufferInfo.buffer = _counters.buffer;
+        bufferInfo.offset = 0;
+        bufferInfo.range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet writes[2]{};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = set;
+        writes[0].dstBinding = 0;
+        writes[0].descriptorCount = MAX_LEVELS;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[0].pImageInfo = imageInfos;
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = set;
+        writes[1].dstBinding = 1;
+        writes[1].descriptorCount = 1;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[1].pBufferInfo = &bufferInfo;
+        vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _layout, 0, 1, &set, 0, nullptr);
+
+        //each workgroup reduces a 64x64 tile
+        u32 groupsX = (r.image.imageExtent.width + 63) / 64;
+        u32 groupsY = (r.image.imageExtent.height + 63) / 64;
+
+        PushConstants pc;
+        pc.size[0] = (i32)r.image.imageExtent.width;
+        pc.size[1] = (i32)r.image.imageExtent.height;
+        pc.mipCount = r.mipLevels - 1;
+        pc.workGroupCount = groupsX * groupsY;
+        pc.counterIndex = slot;
+        vkCmdPushConstants(cmd, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pc);
+
+        vkCmdDispatch(cmd, groupsX, groupsY, 1);
+        computeCount++;
+    }
+
+    for(auto& barrier : barriers){
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    vkCmdPipelineBarrier2(cmd, &depInfo);
+}
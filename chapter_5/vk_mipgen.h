@@ -0,0 +1,54 @@
+#pragma once
+#include <vk_types.h>
+#include <vector>
+
+class VulkanEngine;
+
+//builds the mip chain of uploaded textures on the graphics queue. rgba8 images up to 4096 go through
+//a single compute dispatch (shaders/mipgen.comp), anything else, or everything on devices without
+//shaderStorageImageArrayDynamicIndexing, falls back to a chain of blits
+class MipGenerator{
+    struct Request{
+        AllocatedImage image;
+        u32 mipLevels;
+        UploadTicket ticket;
+    };
+
+    struct PushConstants{
+        i32 size[2];
+        u32 mipCount;
+        u32 workGroupCount;
+        u32 counterIndex;
+    };
+
+    VulkanEngine* _engine{nullptr};
+    VkDescriptorSetLayout _setLayout{VK_NULL_HANDLE};
+    VkPipelineLayout _layout{VK_NULL_HANDLE};
+    VkPipeline _pipeline{VK_NULL_HANDLE};
+    //one workgroup counter per dispatch in flight, the shader resets its own
+    AllocatedBuffer _counters;
+    bool _storageSupported{false};
+
+    std::vector<Request> _requests;
+
+public:
+    static constexpr u32 MAX_LEVELS = 13;
+    static constexpr u32 COUNTER_SLOTS = 64;
+
+    //last frame's numbers, for the stats window
+    u32 computeCount{0};
+    u32 blitCount{0};
+
+    void init(VulkanEngine* engine);
+    void cleanup();
+
+    //true when the compute path can build every level of the image
+    bool supports(VkFormat format, VkExtent3D extent) const;
+
+    //generate the levels once the upload of mip 0 has been acquired
+    void queue(const AllocatedImage& image, UploadTicket ticket);
+
+    //record every request whose upload was acquired, call right after UploadService::record_acquires
+    //so a ready ticket always means the whole chain is built
+    void record(VkCommandBuffer cmd);
+};
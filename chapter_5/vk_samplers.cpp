@@ -0,0 +1,99 @@
+#include "vk_samplers.h"
+#include "vk_engine.h"
+#include <hash.h>
+#include <bit>
+#include <algorithm>
+
+void SamplerCache::init(VulkanEngine* engine, bool anisotropySupported){
+    _engine = engine;
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(engine->_physical, &properties);
+    _anisotropySupported = anisotropySupported;
+    _maxAnisotropy = anisotropySupported ? properties.limits.maxSamplerAnisotropy : 1.f;
+    _maxLodBias = properties.limits.maxSamplerLodBias;
+    //settings made before init are clamped now that the limits are known
+    set_filtering(_anisotropy, _lodBias);
+    generation = 0;
+}
+
+void SamplerCache::cleanup(){
+    //the device is idle by now
+    for(auto& [key, entry] : _samplers){
+        vkDestroySampler(_engine->_device, entry.sampler, nullptr);
+    }
+    for(auto& [sampler, frame] : _retired){
+        vkDestroySampler(_engine->_device, sampler, nullptr);
+    }
+    _samplers.clear();
+    _keys.clear();
+    _retired.clear();
+}
+
+VkSampler SamplerCache::acquire(const VkSamplerCreateInfo& info){
+    VkSamplerCreateInfo filtered = info;
+    if(_anisotropy > 1.f && info.minFilter == VK_FILTER_LINEAR){
+        filtered.anisotropyEnable = VK_TRUE;
+        filtered.maxAnisotropy = _anisotropy;
+    }
+    filtered.mipLodBias = std::clamp(info.mipLodBias + _lodBias, -_maxLodBias, _maxLodBias);
+
+    u64 key = sampler_key(filtered);
+    auto it = _samplers.find(key);
+    if(it != _samplers.end()){
+        it->second.refs++;
+        return it->second.sampler;
+    }
+    VkSampler sampler;
+    VK_CHECK(vkCreateSampler(_engine->_device, &filtered, nullptr, &sampler));
+    _samplers[key] = {sampler, 1};
+    _keys[sampler] = key;
+    return sampler;
+}
+
+void SamplerCache::release(VkSampler sampler){
+    auto key = _keys.find(sampler);
+    if(key == _keys.end()){
+        return;
+    }
+    auto it = _samplers.find(key->second);
+    if(--it->second.refs > 0){
+        return;
+    }
+    _samplers.erase(it);
+    _keys.erase(key);
+    _retired.push_back({sampler, (u64)_engine->_frameNumber});
+}
+
+void SamplerCache::update(){
+    u64 frame = (u64)_engine->_frameNumber;
+    while(!_retired.empty() && _retired.front().second + FRAME_OVERLAP <= frame){
+        vkDestroySampler(_engine->_device, _retired.front().first, nullptr);
+        _retired.pop_front();
+    }
+}
+
+void SamplerCache::set_filtering(float anisotropy, float lodBias){
+    //the limits are only known after init
+    if(_engine){
+        anisotropy = std::clamp(anisotropy, 1.f, _maxAnisotropy);
+        lodBias = std::clamp(lodBias, -_maxLodBias, _maxLodBias);
+    }
+    if(anisotropy == _anisotropy && lodBias == _lodBias){
+        return;
+    }
+    _anisotropy = anisotropy;
+    _lodBias = lodBias;
+    generation++;
+}
+
+u64 sampler_key(const VkSamplerCreateInfo& info){
+    //field by field, the struct has padding and a pNext pointer that would defeat hashing its bytes
+    u32 fields[] = {
+        (u32)info.flags, (u32)info.magFilter, (u32)info.minFilter, (u32)info.mipmapMode,
+        (u32)info.addressModeU, (u32)info.addressModeV, (u32)info.addressModeW,
+        std::bit_cast<u32>(info.mipLodBias), info.anisotropyEnable, std::bit_cast<u32>(info.maxAnisotropy),
+        info.compareEnable, (u32)info.compareOp, std::bit_cast<u32>(info.minLod), std::bit_cast<u32>(info.maxLod),
+        (u32)info.borderColor, info.unnormalizedCoordinates
+    };
+    return xxhash64(fields, sizeof(fields));
+}
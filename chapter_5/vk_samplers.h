@@ -0,0 +1,57 @@
+#pragma once
+#include <vk_types.h>
+#include <unordered_map>
+#include <deque>
+
+class VulkanEngine;
+
+//every sampler of the engine and the loaded scenes, created once per distinct create info and
+//reference counted. the global anisotropy and lod bias are applied on top of the create info, changing
+//them bumps generation and the owners of samplers acquire them again with the new settings.
+//main thread only
+class SamplerCache{
+    struct Entry{
+        VkSampler sampler;
+        u32 refs;
+    };
+
+    VulkanEngine* _engine{nullptr};
+    std::unordered_map<u64, Entry> _samplers;
+    //key of every live sampler, for release
+    std::unordered_map<VkSampler, u64> _keys;
+    //last reference dropped in a frame, destroyed once that frame is out of flight
+    std::deque<std::pair<VkSampler, u64>> _retired;
+
+    float _anisotropy{1.f};
+    float _lodBias{0.f};
+    //device limits, anisotropy stays off without samplerAnisotropy
+    bool _anisotropySupported{false};
+    float _maxAnisotropy{1.f};
+    float _maxLodBias{0.f};
+
+public:
+    //bumped by set_filtering
+    u32 generation{0};
+
+    //anisotropySupported is whether samplerAnisotropy was enabled on the device
+    void init(VulkanEngine* engine, bool anisotropySupported);
+    void cleanup();
+
+    //a reference to the sampler for info with the global filtering applied
+    VkSampler acquire(const VkSamplerCreateInfo& info);
+    //drop a reference, the last one destroys the sampler FRAME_OVERLAP frames later
+    void release(VkSampler sampler);
+    //destroy the samplers released long enough ago, once per frame
+    void update();
+
+    //anisotropy is applied to linear minification only, 1 turns it off. both are clamped to the device limits
+    void set_filtering(float anisotropy, float lodBias);
+    float anisotropy() const { return _anisotropy; }
+    float lod_bias() const { return _lodBias; }
+    float max_anisotropy() const { return _maxAnisotropy; }
+    float max_lod_bias() const { return _maxLodBias; }
+    size_t size() const { return _samplers.size(); }
+};
+
+//hash of the fields of a sampler create info, pNext chains are not supported
+u64 sampler_key(const VkSamplerCreateInfo& info);
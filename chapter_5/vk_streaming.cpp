@@ -0,0 +1,309 @@
+#include "vk_streaming.h"
+#include "vk_engine.h"
+#include <cmath>
+#include <algorithm>
+
+MipChain build_mip_chain(std::vector<u8>&& pixels, u32 width, u32 height){
+    MipChain chain;
+    chain.width = width;
+    chain.height = height;
+    u32 levelCount = static_cast<u32>(std::floor(std::log2(std::max(width, height))))+1;
+    chain.levels.resize(levelCount);
+    chain.levels[0] = std::move(pixels);
+
+    u32 w = width;
+    u32 h = height;
+    for(u32 level = 1; level < levelCount; ++level){
+        const std::vector<u8>& src = chain.levels[level-1];
+        u32 dw = std::max(1u, w / 2);
+        u32 dh = std::max(1u, h / 2);
+        std::vector<u8>& dst = chain.levels[level];
+        dst.resize((size_t)dw * dh * 4);
+        for(u32 y = 0; y < dh; ++y){
+            //odd sizes clamp the second row/column to the edge
+            u32 y0 = std::min(y*2, h-1);
+            u32 y1 = std::min(y*2+1, h-1);
+            for(u32 x = 0; x < dw; ++x){
+                u32 x0 = std::min(x*2, w-1);
+                u32 x1 = std::min(x*2+1, w-1);
+                for(u32 c = 0; c < 4; ++c){
+                    u32 sum = src[((size_t)y0*w + x0)*4 + c] + src[((size_t)y0*w + x1)*4 + c] +
+                        src[((size_t)y1*w + x0)*4 + c] + src[((size_t)y1*w + x1)*4 + c];
+                    dst[((size_t)y*dw + x)*4 + c] = (u8)((sum + 2) / 4);
+                }
+            }
+        }
+        w = dw;
+        h = dh;
+    }
+    return chain;
+}
+
+void TextureStreamer::init(VulkanEngine* engine){
+    _engine = engine;
+}
+
+void TextureStreamer::cleanup(){
+    //the device is idle by now
+    for(auto& tex : _textures){
+        if(tex.alive){
+            retire(tex.current.image);
+            retire(tex.next.image);
+        }
+    }
+    for(auto& retired : _retired){
+        _engine->destroy_image(retired.image);
+    }
+    _retired.clear();
+    _textures.clear();
+    _freeSlots.clear();
+}
+
+u32 TextureStreamer::tail_level(const MipChain& mips) const{
+    u32 last = (u32)mips.levels.size() - 1;
+    u32 level = 0;
+    while(level < last && (std::max(1u, mips.width >> level) > tailSize || std::max(1u, mips.height >> level) > tailSize)){
+        level++;
+    }
+    return level;
+}
+
+size_t TextureStreamer::image_bytes(const MipChain& mips, u32 baseLevel) const{
+    size_t bytes = 0;
+    for(u32 level = baseLevel; level < mips.levels.size(); ++level){
+        bytes += vkutil::image_level_size(mips.format, mips.width, mips.height, level);
+    }
+    return bytes;
+}
+
+void TextureStreamer::upload_level(StreamedTexture& tex, Residency& residency, u32 level){
+    std::vector<u8>& data = tex.mips.levels[level];
+    //the first upload into an image moves all of its levels out of UNDEFINED
+    bool first = residency.pendingLevel == UINT32_MAX;
+    residency.pendingTicket = _engine->_uploader.upload_image(data.data(), data.size(), residency.image, level - residency.baseLevel, first);
+    residency.pendingLevel = level;
+    bytesLastFrame += data.size();
+    //with a budget the chain is kept to build smaller and larger images from
+    if(memoryBudget == 0){
+        data = {};
+    }
+}
+
+//allocate the image for levels [baseLevel, ...) and upload its smallest level and the rest of the tail,
+//or every level without a frame budget
+void TextureStreamer::begin_residency(StreamedTexture& tex, Residency& residency, u32 baseLevel){
+    residency = Residency{};
+    residency.baseLevel = baseLevel;
+    VkExtent3D size{std::max(1u, tex.mips.width >> baseLevel), std::max(1u, tex.mips.height >> baseLevel), 1};
+    residency.image = _engine->allocate_image(size, tex.mips.format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        (u32)tex.mips.levels.size() - baseLevel);
+    u32 first = frameBudget > 0 ? std::max(tail_level(tex.mips), baseLevel) : baseLevel;
+    for(u32 level = (u32)tex.mips.levels.size(); level-- > first;){
+        upload_level(tex, residency, level);
+    }
+}
+
+void TextureStreamer::retire(AllocatedImage& image){
+    if(image.image != VK_NULL_HANDLE){
+        _retired.push_back({image, (u64)_engine->_frameNumber});
+        image = {};
+    }
+}
+
+u32 TextureStreamer::add(MipChain&& mips){
+    u32 handle;
+    if(!_freeSlots.empty()){
+        handle = _freeSlots.back();
+        _freeSlots.pop_back();
+    }else{
+        handle = (u32)_textures.size();
+        _textures.emplace_back();
+    }
+    StreamedTexture& tex = _textures[handle];
+    tex = StreamedTexture{};
+    tex.mips = std::move(mips);
+    tex.alive = true;
+
+    //without a budget the image holds the whole chain from the start, with one just the tail
+    //until the texture is drawn
+    begin_residency(tex, tex.current, memoryBudget > 0 ? tail_level(tex.mips) : 0);
+    _engine->_uploader.submit();
+    return handle;
+}
+
+void TextureStreamer::remove(u32 handle){
+    StreamedTexture& tex = _textures[handle];
+    retire(tex.current.image);
+    retire(tex.next.image);
+    tex = StreamedTexture{};
+    _freeSlots.push_back(handle);
+}
+
+u32 TextureStreamer::resident_level(u32 handle) const{
+    const Residency& current = _textures[handle].current;
+    return current.residentLevel == UINT32_MAX ? UINT32_MAX : current.residentLevel - current.baseLevel;
+}
+
+void TextureStreamer::request(u32 handle, float screenSize){
+    StreamedTexture& tex = _textures[handle];
+    u32 size = std::max(tex.mips.width, tex.mips.height);
+    //coarsest level still at least as large as the footprint
+    u32 level = 0;
+    while(level + 1 < tex.mips.levels.size() && (float)(size >> (level + 1)) >= screenSize){
+        level++;
+    }
+    tex.requestedLevel = std::min(tex.requestedLevel, level);
+}
+
+void TextureStreamer::plan_residency(u64 frame){
+    //memory once the replacements in flight are swapped in
+    size_t projected = 0;
+    //what the textures drawn last frame still need to get to the level they were drawn at
+    size_t growth = 0;
+    residentBytes = 0;
+    starvedCount = 0;
+    std::vector<u32> candidates;
+    for(u32 i = 0; i < _textures.size(); ++i){
+        StreamedTexture& tex = _textures[i];
+        if(!tex.alive){
+            continue;
+        }
+        bool resizing = tex.next.image.image != VK_NULL_HANDLE;
+        size_t current = image_bytes(tex.mips, tex.current.baseLevel);
+        size_t next = resizing ? image_bytes(tex.mips, tex.next.baseLevel) : 0;
+        residentBytes += current + next;
+        projected += resizing ? next : current;
+        u32 base = resizing ? tex.next.baseLevel : tex.current.baseLevel;
+        if(tex.lastUsed == frame && tex.wantedLevel < base){
+            starvedCount++;
+            growth += resizing ? 0 : image_bytes(tex.mips, tex.wantedLevel) - current;
+        }
+        //only whole chains can be rebuilt, and one size change at a time
+        if(!resizing && !tex.mips.levels.back().empty()){
+            candidates.push_back(i);
+        }
+    }
+
+    //make room when over budget or when drawn textures wait for levels. least recently drawn first,
+    //the tail always stays and textures drawn last frame keep the level they were drawn at
+    if(projected + growth > memoryBudget){
+        std::sort(candidates.begin(), candidates.end(), [&](u32 a, u32 b){ return _textures[a].lastUsed < _textures[b].lastUsed; });
+        for(u32 i : candidates){
+            if(projected + growth <= memoryBudget){
+                break;
+            }
+            StreamedTexture& tex = _textures[i];
+            u32 base = tex.current.baseLevel;
+            u32 limit = tail_level(tex.mips);
+            if(tex.lastUsed == frame){
+                limit = std::min(limit, tex.wantedLevel);
+            }
+            u32 target = base;
+            while(target < limit && projected + growth > memoryBudget){
+                projected -= image_bytes(tex.mips, target) - image_bytes(tex.mips, target + 1);
+                target++;
+            }
+            if(target != base){
+                begin_residency(tex, tex.next, target);
+            }
+        }
+    }
+
+    //grow what was drawn last frame, most recently drawn first, as far as the budget goes
+    std::sort(candidates.begin(), candidates.end(), [&](u32 a, u32 b){ return _textures[a].lastUsed > _textures[b].lastUsed; });
+    for(u32 i : candidates){
+        StreamedTexture& tex = _textures[i];
+        if(tex.lastUsed != frame){
+            break;
+        }
+        u32 base = tex.current.baseLevel;
+        if(tex.next.image.image != VK_NULL_HANDLE || tex.wantedLevel >= base){
+            continue;
+        }
+        size_t current = image_bytes(tex.mips, base);
+        u32 target = tex.wantedLevel;
+        while(target < base && projected + image_bytes(tex.mips, target) - current > memoryBudget){
+            target++;
+        }
+        if(target != base){
+            projected += image_bytes(tex.mips, target) - current;
+            begin_residency(tex, tex.next, target);
+        }
+    }
+}
+
+void TextureStreamer::update(){
+    UploadService& uploader = _engine->_uploader;
+    u64 frame = (u64)_engine->_frameNumber;
+    bytesLastFrame = 0;
+
+    //images retired FRAME_OVERLAP frames ago were last sampled by a frame whose fence has been waited on since
+    std::erase_if(_retired, [&](const RetiredImage& retired){
+        if(retired.frame + FRAME_OVERLAP > frame){
+            return false;
+        }
+        _engine->destroy_image(retired.image);
+        return true;
+    });
+
+    //levels whose copies finished become sampleable, finished replacements are swapped in
+    streamingCount = 0;
+    auto promote = [&](Residency& residency){
+        if(residency.pendingLevel != residency.residentLevel && uploader.is_ready(residency.pendingTicket)){
+            residency.residentLevel = residency.pendingLevel;
+        }
+    };
+    for(auto& tex : _textures){
+        if(!tex.alive){
+            continue;
+        }
+        //what the draws recorded since the last update asked for
+        if(tex.requestedLevel != UINT32_MAX){
+            tex.lastUsed = frame;
+            tex.wantedLevel = tex.requestedLevel;
+            tex.requestedLevel = UINT32_MAX;
+        }
+        promote(tex.current);
+        if(tex.next.image.image != VK_NULL_HANDLE){
+            promote(tex.next);
+            if(tex.next.residentLevel == tex.next.baseLevel){
+                retire(tex.current.image);
+                tex.current = tex.next;
+                tex.next = Residency{};
+            }
+        }
+        if(tex.current.residentLevel != tex.current.baseLevel || tex.next.image.image != VK_NULL_HANDLE){
+            streamingCount++;
+        }
+    }
+
+    if(memoryBudget > 0){
+        plan_residency(frame);
+    }
+
+    //one level per texture and frame, walking up from the small ones. a texture changing size
+    //fills its replacement, the current image is complete already
+    u32 count = (u32)_textures.size();
+    for(u32 n = 0; n < count; ++n){
+        u32 index = (_cursor + n) % count;
+        StreamedTexture& tex = _textures[index];
+        if(!tex.alive){
+            continue;
+        }
+        Residency& residency = tex.next.image.image != VK_NULL_HANDLE ? tex.next : tex.current;
+        //nothing left to send, or the last level is still in flight
+        if(residency.pendingLevel == residency.baseLevel || residency.pendingLevel != residency.residentLevel){
+            continue;
+        }
+        u32 level = residency.pendingLevel - 1;
+        if(bytesLastFrame > 0 && bytesLastFrame + tex.mips.levels[level].size() > frameBudget){
+            //resume here next frame
+            _cursor = index;
+            break;
+        }
+        upload_level(tex, residency, level);
+    }
+    if(bytesLastFrame > 0){
+        uploader.submit();
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <vk_types.h>
+#include <vector>
+
+class VulkanEngine;
+
+//cpu mip chain of an image, level 0 is the full resolution. block compressed chains come
+//straight out of KTX2 files and may stop before 1x1
+struct MipChain{
+    u32 width{0};
+    u32 height{0};
+    VkFormat format{VK_FORMAT_R8G8B8A8_UNORM};
+    std::vector<std::vector<u8>> levels;
+};
+
+//box filter down to 1x1, the level count matches create_image(..., mipmapped=true)
+MipChain build_mip_chain(std::vector<u8>&& pixels, u32 width, u32 height);
+
+//uploads the small tail of a mip chain first so the texture can be sampled almost right away,
+//the larger levels follow over the next frames within a per frame byte budget.
+//materials clamp their samplers with minLod so nothing reads a level that isn't resident yet.
+//with a memory budget the cpu chains are kept and every texture lives in an image holding only the
+//levels it was last drawn at: textures start as their tail, grow when request() asks for finer levels
+//and lose their top levels again, least recently drawn first, when the budget runs out. a texture
+//changes size by filling a replacement image and swapping it in, the old image is destroyed once no
+//frame in flight can sample it
+class TextureStreamer{
+    //image holding levels [baseLevel, levels.size()) of the chain
+    struct Residency{
+        AllocatedImage image;
+        u32 baseLevel{0};
+        //lowest chain level the graphics queue can sample, UINT32_MAX while none is
+        u32 residentLevel{UINT32_MAX};
+        //lowest chain level submitted so far, resident once its ticket is ready
+        u32 pendingLevel{UINT32_MAX};
+        UploadTicket pendingTicket;
+    };
+
+    struct StreamedTexture{
+        MipChain mips;
+        //the image materials sample
+        Residency current;
+        //replacement for a new base level, swapped in once all of its levels are resident
+        Residency next;
+        //frame the texture was last drawn in and the finest level it was drawn at, UINT32_MAX until drawn
+        u64 lastUsed{0};
+        u32 wantedLevel{UINT32_MAX};
+        //finest level the draws of the frame being recorded asked for
+        u32 requestedLevel{UINT32_MAX};
+        bool alive{false};
+    };
+
+    //replaced images, destroyed FRAME_OVERLAP frames after the one that retired them
+    struct RetiredImage{
+        AllocatedImage image;
+        u64 frame;
+    };
+
+    VulkanEngine* _engine{nullptr};
+    std::vector<StreamedTexture> _textures;
+    std::vector<u32> _freeSlots;
+    std::vector<RetiredImage> _retired;
+    //round robin start so one big scene doesn't starve the others
+    u32 _cursor{0};
+
+    //first level of the chain no larger than tailSize on both sides
+    u32 tail_level(const MipChain& mips) const;
+    //gpu memory of an image holding the chain from baseLevel down
+    size_t image_bytes(const MipChain& mips, u32 baseLevel) const;
+    void begin_residency(StreamedTexture& tex, Residency& residency, u32 baseLevel);
+    void upload_level(StreamedTexture& tex, Residency& residency, u32 level);
+    void retire(AllocatedImage& image);
+    //drop and grow textures towards what the last frame drew, within memoryBudget
+    void plan_residency(u64 frame);
+
+public:
+    //bytes update() uploads per frame, at least one level always goes out. 0 uploads whole chains in add()
+    size_t frameBudget{8 * 1024 * 1024};
+    //levels with both sides at or below this go up with the first upload
+    u32 tailSize{64};
+    //gpu memory of every streamed image together, 0 keeps every texture at full resolution and
+    //frees the cpu chains once they are uploaded
+    size_t memoryBudget{0};
+
+    //last frame's numbers, for the stats window
+    size_t bytesLastFrame{0};
+    u32 streamingCount{0};
+    size_t residentBytes{0};
+    //textures held at a coarser level than they were last drawn at, for lack of budget
+    u32 starvedCount{0};
+
+    void init(VulkanEngine* engine);
+    void cleanup();
+
+    //take over the mip chain and create its image, returns the stream handle
+    u32 add(MipChain&& mips);
+    //forget the texture, its images are destroyed once no frame in flight uses them
+    void remove(u32 handle);
+
+    //image to sample, it changes when the texture is dropped or grown
+    const AllocatedImage& image(u32 handle) const { return _textures[handle].current.image; }
+    //lowest level of image() that can be sampled, UINT32_MAX while none is
+    u32 resident_level(u32 handle) const;
+
+    //the texture is drawn this frame covering about screenSize pixels along its larger side
+    void request(u32 handle, float screenSize);
+
+    //promote finished levels and submit the next ones, once per frame
+    void update();
+};
@@ -0,0 +1,346 @@
+#include "vk_upload.h"
+#include "vk_engine.h"
+#include <vk_initializers.h>
+#include <algorithm>
+
+//staging memory is allocated in blocks of this size and suballocated
+constexpr size_t STAGING_BLOCK_SIZE = 64 * 1024 * 1024;
+//a batch that stages more than this is submitted early to bound the staging memory
+constexpr size_t MAX_BATCH_STAGING = 256 * 1024 * 1024;
+
+void UploadService::init(VulkanEngine* engine, VkQueue queue, u32 queueFamily, u32 graphicsQueueFamily){
+    _engine = engine;
+    _device = engine->_device;
+    _queue = queue;
+    _queueFamily = queueFamily;
+    _graphicsQueueFamily = graphicsQueueFamily;
+
+    VkCommandPoolCreateInfo poolInfo = vkinit::command_pool_create_info(_queueFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    VK_CHECK(vkCreateCommandPool(_device, &poolInfo, nullptr, &_commandPool));
+
+    //timeline semaphore, every submit signals the next value
+    VkSemaphoreTypeCreateInfo typeInfo{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semInfo = vkinit::semaphore_create_info();
+    semInfo.pNext = &typeInfo;
+    VK_CHECK(vkCreateSemaphore(_device, &semInfo, nullptr, &_timeline));
+
+    fmt::println("Upload service using {} queue family {}", needs_ownership_transfer() ? "dedicated transfer" : "graphics", _queueFamily);
+}
+
+void UploadService::cleanup(){
+    _batchDepth = 0;
+    flush();
+    if(!_inFlight.empty()){
+        wait(UploadTicket{_nextValue-1});
+    }
+    for(auto& p : _inFlight){
+        for(auto& b : p.stagingBuffers){
+            _engine->destroy_buffer(b);
+        }
+    }
+    _inFlight.clear();
+    _acquires.clear();
+    _freeCommandBuffers.clear();
+
+    vkDestroySemaphore(_device, _timeline, nullptr);
+    vkDestroyCommandPool(_device, _commandPool, nullptr);
+    _timeline = VK_NULL_HANDLE;
+    _commandPool = VK_NULL_HANDLE;
+}
+
+VkCommandBuffer UploadService::get_cmd(){
+    VkCommandBuffer cmd;
+    //reuse a command buffer from a finished submit if we have one
+    if(!_freeCommandBuffers.empty()){
+        cmd = _freeCommandBuffers.back();
+        _freeCommandBuffers.pop_back();
+        VK_CHECK(vkResetCommandBuffer(cmd, 0));
+    }else{
+        VkCommandBufferAllocateInfo allocInfo = vkinit::command_buffer_allocate_info(_commandPool, 1);
+        VK_CHECK(vkAllocateCommandBuffers(_device, &allocInfo, &cmd));
+    }
+    VkCommandBufferBeginInfo beginInfo = vkinit::command_buffer_begin_info(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+    return cmd;
+}
+
+VkBuffer UploadService::stage(const void* data, size_t size, VkDeviceSize* offset){
+    //16 byte alignment covers the texel size of every format we upload
+    size_t aligned = (_stagingOffset + 15) & ~size_t(15);
+    if(_staging.empty() || aligned + size > _stagingCapacity){
+        size_t blockSize = std::max(size, STAGING_BLOCK_SIZE);
+        _staging.push_back(_engine->create_buffer(blockSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY));
+        _stagingCapacity = blockSize;
+        aligned = 0;
+    }
+    AllocatedBuffer& block = _staging.back();
+    memcpy((char*)block.allocationInfo.pMappedData + aligned, data, size);
+    _stagingOffset = aligned + size;
+    _stagingBytes += size;
+    *offset = aligned;
+    return block.buffer;
+}
+
+UploadTicket UploadService::upload_buffer(const void* data, size_t size, VkBuffer dst, VkDeviceSize dstOffset,
+    VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess){
+    BufferCopy copy;
+    copy.src = stage(data, size, &copy.region.srcOffset);
+    copy.dst = dst;
+    copy.region.dstOffset = dstOffset;
+    copy.region.size = size;
+    copy.dstStage = dstStage;
+    copy.dstAccess = dstAccess;
+    _bufferCopies.push_back(copy);
+
+    UploadTicket ticket = pending_ticket();
+    if(_stagingBytes > MAX_BATCH_STAGING){
+        flush();
+    }
+    return ticket;
+}
+
+UploadTicket UploadService::upload_image(const void* data, size_t size, const AllocatedImage& image, u32 mipLevel, bool firstUpload){
+    ImageCopy copy;
+    copy.region = {};
+    copy.src = stage(data, size, &copy.region.bufferOffset);
+    copy.dst = image.image;
+    copy.region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy.region.imageSubresource.mipLevel = mipLevel;
+    copy.region.imageSubresource.layerCount = 1;
+    copy.region.imageExtent.width = std::max(1u, image.imageExtent.width >> mipLevel);
+    copy.region.imageExtent.height = std::max(1u, image.imageExtent.height >> mipLevel);
+    copy.region.imageExtent.depth = 1;
+    _imageCopies.push_back(copy);
+
+    ImageTransition transition;
+    transition.image = image.image;
+    transition.range = vkinit::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT);
+    if(!firstUpload){
+        transition.range.baseMipLevel = mipLevel;
+        transition.range.levelCount = 1;
+    }
+    //several levels of the same image can share a submit, only transition them once
+    bool covered = std::any_of(_imageTransitions.begin(), _imageTransitions.end(), [&](const ImageTransition& t){
+        return t.image == transition.image && (t.range.levelCount == VK_REMAINING_MIP_LEVELS ||
+            t.range.baseMipLevel == transition.range.baseMipLevel);
+    });
+    if(!covered){
+        _imageTransitions.push_back(transition);
+    }
+
+    UploadTicket ticket = pending_ticket();
+    if(_stagingBytes > MAX_BATCH_STAGING){
+        flush();
+    }
+    return ticket;
+}
+
+UploadTicket UploadService::submit(){
+    if(_batchDepth > 0){
+        //the batch submits when it closes
+        return pending_ticket();
+    }
+    return flush();
+}
+
+void UploadService::begin_batch(){
+    _batchDepth++;
+}
+
+UploadTicket UploadService::end_batch(){
+    assert(_batchDepth > 0);
+    _batchDepth--;
+    return submit();
+}
+
+UploadTicket UploadService::flush(){
+    if(_bufferCopies.empty() && _imageCopies.empty()){
+        //nothing recorded, the last submit already covers everything
+        return UploadTicket{_nextValue-1};
+    }
+    VkCommandBuffer cmd = get_cmd();
+
+    //one barrier moves every image of the batch into transfer dst
+    std::vector<VkImageMemoryBarrier2> imageBarriers;
+    imageBarriers.reserve(_imageTransitions.size());
+    for(auto& t : _imageTransitions){
+        VkImageMemoryBarrier2 toTransfer{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+        toTransfer.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        toTransfer.srcAccessMask = VK_ACCESS_2_NONE;
+        toTransfer.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        toTransfer.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        toTransfer.image = t.image;
+        toTransfer.subresourceRange = t.range;
+        imageBarriers.push_back(toTransfer);
+    }
+    if(!imageBarriers.empty()){
+        VkDependencyInfo depInfo{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+        depInfo.imageMemoryBarrierCount = (u32)imageBarriers.size();
+        depInfo.pImageMemoryBarriers = imageBarriers.data();
+        vkCmdPipelineBarrier2(cmd, &depInfo);
+    }
+
+    for(auto& c : _bufferCopies){
+        vkCmdCopyBuffer(cmd, c.src, c.dst, 1, &c.region);
+    }
+    for(auto& c : _imageCopies){
+        vkCmdCopyBufferToImage(cmd, c.src, c.dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &c.region);
+    }
+
+    //and one barrier releases everything, moving the images to shader read on the way
+    u32 srcFamily = needs_ownership_transfer() ? _queueFamily : VK_QUEUE_FAMILY_IGNORED;
+    u32 dstFamily = needs_ownership_transfer() ? _graphicsQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+
+    std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+    if(needs_ownership_transfer()){
+        //same queue family: the timeline wait in the graphics submit is the memory dependency
+        bufferBarriers.reserve(_bufferCopies.size());
+        for(auto& c : _bufferCopies){
+            VkBufferMemoryBarrier2 release{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2};
+            release.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+            release.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            release.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+            release.dstAccessMask = VK_ACCESS_2_NONE;
+            release.srcQueueFamilyIndex = srcFamily;
+            release.dstQueueFamilyIndex = dstFamily;
+            release.buffer = c.dst;
+            release.offset = c.region.dstOffset;
+            release.size = c.region.size;
+            bufferBarriers.push_back(release);
+
+            //the renderer records the acquire half
+            PendingAcquire acquire{};
+            acquire.value = _nextValue;
+            acquire.isImage = false;
+            acquire.bufferBarrier = release;
+            acquire.bufferBarrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+            acquire.bufferBarrier.srcAccessMask = VK_ACCESS_2_NONE;
+            acquire.bufferBarrier.dstStageMask = c.dstStage;
+            acquire.bufferBarrier.dstAccessMask = c.dstAccess;
+            _acquires.push_back(acquire);
+        }
+    }
+
+    for(auto& release : imageBarriers){
+        release.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        release.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        release.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+        release.dstAccessMask = VK_ACCESS_2_NONE;
+        release.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        release.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        release.srcQueueFamilyIndex = srcFamily;
+        release.dstQueueFamilyIndex = dstFamily;
+
+        if(needs_ownership_transfer()){
+            PendingAcquire acquire{};
+            acquire.value = _nextValue;
+            acquire.isImage = true;
+            acquire.imageBarrier = release;
+            acquire.imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+            acquire.imageBarrier.srcAccessMask = VK_ACCESS_2_NONE;
+            acquire.imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            acquire.imageBarrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+            _acquires.push_back(acquire);
+        }
+    }
+
+    if(!bufferBarriers.empty() || !imageBarriers.empty()){
+        VkDependencyInfo depInfo{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+        depInfo.bufferMemoryBarrierCount = (u32)bufferBarriers.size();
+        depInfo.pBufferMemoryBarriers = bufferBarriers.data();
+        depInfo.imageMemoryBarrierCount = (u32)imageBarriers.size();
+        depInfo.pImageMemoryBarriers = imageBarriers.data();
+        vkCmdPipelineBarrier2(cmd, &depInfo);
+    }
+
+    VK_CHECK(vkEndCommandBuffer(cmd));
+
+    VkCommandBufferSubmitInfo cmdInfo = vkinit::command_buffer_submit_info(cmd);
+    VkSemaphoreSubmitInfo signalInfo = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, _timeline);
+    signalInfo.value = _nextValue;
+
+    VkSubmitInfo2 submitInfo = vkinit::submit_info(&cmdInfo, &signalInfo, nullptr);
+    VK_CHECK(vkQueueSubmit2(_queue, 1, &submitInfo, VK_NULL_HANDLE));
+    submitCount++;
+
+    PendingSubmit pending;
+    pending.value = _nextValue;
+    pending.cmd = cmd;
+    pending.stagingBuffers = std::move(_staging);
+    _inFlight.push_back(std::move(pending));
+
+    _bufferCopies.clear();
+    _imageCopies.clear();
+    _imageTransitions.clear();
+    _staging.clear();
+    _stagingOffset = 0;
+    _stagingCapacity = 0;
+    _stagingBytes = 0;
+    return UploadTicket{_nextValue++};
+}
+
+bool UploadService::is_complete(UploadTicket ticket) const{
+    u64 value = 0;
+    VK_CHECK(vkGetSemaphoreCounterValue(_device, _timeline, &value));
+    return ticket.value <= value;
+}
+
+void UploadService::wait(UploadTicket ticket){
+    VkSemaphoreWaitInfo waitInfo{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &_timeline;
+    waitInfo.pValues = &ticket.value;
+    VK_CHECK(vkWaitSemaphores(_device, &waitInfo, UINT64_MAX));
+}
+
+u64 UploadService::record_acquires(VkCommandBuffer cmd){
+    u64 completed = 0;
+    VK_CHECK(vkGetSemaphoreCounterValue(_device, _timeline, &completed));
+    if(completed <= _acquiredValue){
+        return _acquiredValue;
+    }
+
+    //all acquires of finished submits go into a single barrier
+    std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+    std::vector<VkImageMemoryBarrier2> imageBarriers;
+    std::erase_if(_acquires, [&](const PendingAcquire& a){
+        if(a.value > completed){
+            return false;
+        }
+        if(a.isImage){
+            imageBarriers.push_back(a.imageBarrier);
+        }else{
+            bufferBarriers.push_back(a.bufferBarrier);
+        }
+        return true;
+    });
+
+    if(!bufferBarriers.empty() || !imageBarriers.empty()){
+        VkDependencyInfo depInfo{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+        depInfo.bufferMemoryBarrierCount = (u32)bufferBarriers.size();
+        depInfo.pBufferMemoryBarriers = bufferBarriers.data();
+        depInfo.imageMemoryBarrierCount = (u32)imageBarriers.size();
+        depInfo.pImageMemoryBarriers = imageBarriers.data();
+        vkCmdPipelineBarrier2(cmd, &depInfo);
+    }
+
+    //the copies are done, staging memory and command buffers can be recycled
+    std::erase_if(_inFlight, [&](PendingSubmit& p){
+        if(p.value > completed){
+            return false;
+        }
+        for(auto& b : p.stagingBuffers){
+            _engine->destroy_buffer(b);
+        }
+        _freeCommandBuffers.push_back(p.cmd);
+        return true;
+    });
+
+    _acquiredValue = completed;
+    return _acquiredValue;
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <vk_types.h>
+#include <vector>
+
+class VulkanEngine;
+
+//records staging copies on a dedicated transfer queue (when the device has one)
+//and signals a timeline semaphore, nothing in here blocks the cpu.
+//copies are collected and only recorded on submit, so a batch of uploads shares
+//one command buffer, one staging arena and one barrier per direction
+class UploadService{
+    struct PendingSubmit{
+        u64 value;
+        VkCommandBuffer cmd;
+        std::vector<AllocatedBuffer> stagingBuffers;
+    };
+
+    struct BufferCopy{
+        VkBuffer src;
+        VkBuffer dst;
+        VkBufferCopy region;
+        VkPipelineStageFlags2 dstStage;
+        VkAccessFlags2 dstAccess;
+    };
+
+    struct ImageCopy{
+        VkBuffer src;
+        VkImage dst;
+        VkBufferImageCopy region;
+    };
+
+    //layout change around the copies of a submit, UNDEFINED -> TRANSFER_DST -> SHADER_READ_ONLY
+    struct ImageTransition{
+        VkImage image;
+        VkImageSubresourceRange range;
+    };
+
+    //acquire half of a queue family ownership transfer, recorded on the graphics queue
+    struct PendingAcquire{
+        u64 value;
+        bool isImage;
+        VkBufferMemoryBarrier2 bufferBarrier;
+        VkImageMemoryBarrier2 imageBarrier;
+    };
+
+    VulkanEngine* _engine{nullptr};
+    VkDevice _device{VK_NULL_HANDLE};
+
+    VkQueue _queue{VK_NULL_HANDLE};
+    u32 _queueFamily{UINT32_MAX};
+    u32 _graphicsQueueFamily{UINT32_MAX};
+
+    VkCommandPool _commandPool{VK_NULL_HANDLE};
+    VkSemaphore _timeline{VK_NULL_HANDLE};
+
+    //value the next submit will signal
+    u64 _nextValue{1};
+    //highest value whose acquire barriers were recorded on the graphics queue
+    u64 _acquiredValue{0};
+
+    //copies waiting for the next submit
+    std::vector<BufferCopy> _bufferCopies;
+    std::vector<ImageCopy> _imageCopies;
+    std::vector<ImageTransition> _imageTransitions;
+
+    //staging memory of the next submit, suballocated linearly
+    std::vector<AllocatedBuffer> _staging;
+    size_t _stagingOffset{0};
+    size_t _stagingCapacity{0};
+    size_t _stagingBytes{0};
+
+    //nesting depth of open batches, submits are deferred while > 0
+    u32 _batchDepth{0};
+
+    std::vector<PendingSubmit> _inFlight;
+    std::vector<PendingAcquire> _acquires;
+    std::vector<VkCommandBuffer> _freeCommandBuffers;
+
+    VkCommandBuffer get_cmd();
+    bool needs_ownership_transfer() const { return _queueFamily != _graphicsQueueFamily; }
+    //copy data into the staging arena, returns the buffer and offset it landed in
+    VkBuffer stage(const void* data, size_t size, VkDeviceSize* offset);
+    UploadTicket flush();
+
+public:
+    void init(VulkanEngine* engine, VkQueue queue, u32 queueFamily, u32 graphicsQueueFamily);
+    void cleanup();
+
+    bool has_dedicated_queue() const { return needs_ownership_transfer(); }
+
+    //copy data into dst, it will be visible to dstStage/dstAccess on the graphics queue once the ticket is ready
+    UploadTicket upload_buffer(const void* data, size_t size, VkBuffer dst, VkDeviceSize dstOffset,
+        VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess);
+
+    //copy tightly packed texels into one mip level of the image and leave it in SHADER_READ_ONLY_OPTIMAL.
+    //the first upload of an image transitions every level, later ones only their own level,
+    //whose previous contents are discarded
+    UploadTicket upload_image(const void* data, size_t size, const AllocatedImage& image, u32 mipLevel = 0, bool firstUpload = true);
+
+    //submit everything recorded so far, returns the ticket covering all of it.
+    //inside a batch this only hands out the ticket of the pending submit
+    UploadTicket submit();
+
+    void begin_batch();
+    UploadTicket end_batch();
+
+    //number of queue submits so far, for load statistics
+    u32 submitCount{0};
+
+    //the ticket the current recording will complete with
+    UploadTicket pending_ticket() const { return UploadTicket{_nextValue}; }
+
+    //true once the gpu finished the copies and the graphics queue acquired them
+    bool is_ready(UploadTicket ticket) const { return ticket.value <= _acquiredValue; }
+    bool is_complete(UploadTicket ticket) const;
+    void wait(UploadTicket ticket);
+
+    //record the acquire barriers of every finished upload and release its staging memory,
+    //returns the timeline value the graphics submit has to wait on
+    u64 record_acquires(VkCommandBuffer cmd);
+
+    VkSemaphore timeline() const { return _timeline; }
+};
+
+//collects every upload made while it is alive into as few submits as possible. the ticket of the
+//batch is stored in ticket, when given, as the scope ends
+struct UploadBatchScope{
+    UploadService& service;
+    UploadTicket* ticket;
+    explicit UploadBatchScope(UploadService& uploader, UploadTicket* batchTicket = nullptr)
+        : service(uploader), ticket(batchTicket) { service.begin_batch(); }
+    ~UploadBatchScope(){
+        UploadTicket done = service.end_batch();
+        if(ticket){
+            *ticket = done;
+        }
+    }
+
+    UploadBatchScope(const UploadBatchScope&) = delete;
+    UploadBatchScope& operator=(const UploadBatchScope&) = delete;
+};
@@ -0,0 +1,11 @@
+//sampling textures the loader packed into an atlas, see chapter_5/texture_atlas.h. fragment shaders only
+
+//uv and gradients for textureGrad. tile is the scale (xy) and offset (zw) of the texture in its atlas,
+//identity for a texture with its own image. the uv wraps inside the tile like a repeating sampler, the
+//gradients stay those of the unwrapped uv so the wrap seam doesn't drop to the smallest mip
+void atlas_uv(vec2 uv, vec4 tile, out vec2 tileUV, out vec2 dx, out vec2 dy)
+{
+	dx = dFdx(uv) * tile.xy;
+	dy = dFdy(uv) * tile.xy;
+	tileUV = tile.xy == vec2(1.0) ? uv : tile.zw + fract(uv) * tile.xy;
+}
@@ -10,11 +10,22 @@ layout(set = 0, binding = 0) uniform  SceneData{
 } sceneData;
 
 #ifdef USE_BINDLESS
-layout(set = 0, binding = 1) uniform sampler2D allTextures[];
+//every material and texture in one set, see BindlessTable. a draw picks its material with
+//PushConstants.materialIndex and the material picks its textures by slot
+struct MaterialData{
+	vec4 colorFactors;
+	vec4 metal_rough_factors;
+	uint colorTexID;
+	uint metalRoughTexID;
+};
+
+layout(set = 1, binding = 0, std430) readonly buffer MaterialTable{
+	MaterialData materials[];
+} materialTable;
+layout(set = 1, binding = 1) uniform sampler2D allTextures[];
 #else
 layout(set = 1, binding = 1) uniform sampler2D colorTex;
 layout(set = 1, binding = 2) uniform sampler2D metalRoughTex;
-#endif
 
 layout(set = 1, binding = 0) uniform GLTFMaterialData{   
 
@@ -23,4 +34,5 @@ layout(set = 1, binding = 0) uniform GLTFMaterialData{
 	int colorTexID;
 	int metalRoughTexID;
 } materialData;
+#endif
 
@@ -2,10 +2,12 @@
 
 #extension GL_GOOGLE_include_directive : require
 #include "input_structures.glsl"
+#include "atlas.glsl"
 
 layout (location = 0) in vec3 inNormal;
 layout (location = 1) in vec3 inColor;
 layout (location = 2) in vec2 inUV;
+layout (location = 4) flat in vec4 inUVTransform;
 
 layout (location = 0) out vec4 outFragColor;
 
@@ -53,7 +55,9 @@ void main()
 	vec3 irradiance = calcIrradiance(inNormal); 
 
 
-	vec3 color = inColor * texture(colorTex,inUV).xyz;
+	vec2 uv, dx, dy;
+	atlas_uv(inUV, inUVTransform, uv, dx, dy);
+	vec3 color = inColor * textureGrad(colorTex, uv, dx, dy).xyz;
 
 	outFragColor = vec4(color * lightValue + color * irradiance.x * vec3(0.2f) ,1.0f);
 }
@@ -4,34 +4,16 @@
 #extension GL_EXT_buffer_reference : require
 
 #include "input_structures.glsl"
+#include "vertex_fetch.glsl"
 
 layout (location = 0) out vec3 outNormal;
 layout (location = 1) out vec3 outColor;
 layout (location = 2) out vec2 outUV;
-
-struct Vertex {
-
-	vec3 position;
-	float uv_x;
-	vec3 normal;
-	float uv_y;
-	vec4 color;
-}; 
-
-layout(buffer_reference, std430) readonly buffer VertexBuffer{ 
-	Vertex vertices[];
-};
-
-//push constants block
-layout( push_constant ) uniform constants
-{
-	mat4 render_matrix;
-	VertexBuffer vertexBuffer;
-} PushConstants;
+layout (location = 4) flat out vec4 outUVTransform;
 
 void main() 
 {
-	Vertex v = PushConstants.vertexBuffer.vertices[gl_VertexIndex];
+	Vertex v = load_vertex(gl_VertexIndex);
 	
 	vec4 position = vec4(v.position, 1.0f);
 
@@ -41,5 +23,6 @@ void main()
 	outColor = v.color.xyz * materialData.colorFactors.xyz;	
 	outUV.x = v.uv_x;
 	outUV.y = v.uv_y;
+	outUVTransform = PushConstants.uvTransform;
 }
 
@@ -0,0 +1,30 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_buffer_reference : require
+
+#define USE_BINDLESS
+#include "input_structures.glsl"
+#include "vertex_fetch.glsl"
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+layout (location = 2) out vec2 outUV;
+layout (location = 3) flat out uint outMaterialIndex;
+layout (location = 4) flat out vec4 outUVTransform;
+
+void main() 
+{
+	Vertex v = load_vertex(gl_VertexIndex);
+	
+	vec4 position = vec4(v.position, 1.0f);
+
+	gl_Position =  sceneData.viewproj * PushConstants.render_matrix *position;	
+
+	outNormal = (PushConstants.render_matrix * vec4(v.normal, 0.f)).xyz;
+	outColor = v.color.xyz * materialTable.materials[PushConstants.materialIndex].colorFactors.xyz;	
+	outUV.x = v.uv_x;
+	outUV.y = v.uv_y;
+	outMaterialIndex = PushConstants.materialIndex;
+	outUVTransform = PushConstants.uvTransform;
+}
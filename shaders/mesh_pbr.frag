@@ -5,11 +5,14 @@
 
 #define USE_BINDLESS
 #include "input_structures.glsl"
+#include "atlas.glsl"
 
 
 layout (location = 0) in vec3 inNormal;
 layout (location = 1) in vec3 inColor;
 layout (location = 2) in vec2 inUV;
+layout (location = 3) flat in uint inMaterialIndex;
+layout (location = 4) flat in vec4 inUVTransform;
 
 layout (location = 0) out vec4 outFragColor;
 
@@ -58,8 +61,10 @@ void main()
 
 
 	//vec3 color = inColor * texture(colorTex,inUV).xyz;
-    int colorID = materialData.colorTexID;
-    vec3 color = inColor * texture(allTextures[colorID],inUV).xyz;
+    uint colorID = materialTable.materials[inMaterialIndex].colorTexID;
+    vec2 uv, dx, dy;
+    atlas_uv(inUV, inUVTransform, uv, dx, dy);
+    vec3 color = inColor * textureGrad(allTextures[nonuniformEXT(colorID)], uv, dx, dy).xyz;
 
 	outFragColor = vec4(color * lightValue + color * irradiance.x * vec3(0.2f) ,1.0f);
 }
@@ -0,0 +1,65 @@
+//vertex pulling shared by the mesh vertex shaders, the vertices are read through the buffer address
+//in the push constants in either the full or the packed layout
+
+struct Vertex {
+
+	vec3 position;
+	float uv_x;
+	vec3 normal;
+	float uv_y;
+	vec4 color;
+}; 
+
+layout(buffer_reference, std430) readonly buffer VertexBuffer{ 
+	Vertex vertices[];
+};
+
+//PackedVertex, 16 bytes: position unorm16 x3, normal octahedral snorm8 x2, uv half x2, color unorm8 x4
+layout(buffer_reference, std430) readonly buffer PackedVertexBuffer{ 
+	uvec4 vertices[];
+};
+
+//VertexFormat
+#define VERTEX_FORMAT_FULL 0
+#define VERTEX_FORMAT_PACKED 1
+
+//push constants block
+layout( push_constant ) uniform constants
+{
+	mat4 render_matrix;
+	VertexBuffer vertexBuffer;
+	uint vertexFormat;
+	//index into the bindless material table, unused with material descriptor sets
+	uint materialIndex;
+	vec4 positionOffset;
+	vec4 positionScale;
+	//scale and offset of the color texture in its atlas, passed on to the fragment shader
+	vec4 uvTransform;
+} PushConstants;
+
+vec3 oct_decode(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if(n.z < 0.0){
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+	float len = length(n);
+	return len > 0.0 ? n / len : vec3(0.0);
+}
+
+Vertex load_vertex(uint index)
+{
+	if(PushConstants.vertexFormat == VERTEX_FORMAT_FULL){
+		return PushConstants.vertexBuffer.vertices[index];
+	}
+	uvec4 d = PackedVertexBuffer(PushConstants.vertexBuffer).vertices[index];
+	Vertex v;
+	vec3 q = vec3(d.x & 0xffffu, d.x >> 16, d.y & 0xffffu) / 65535.0;
+	v.position = PushConstants.positionOffset.xyz + q * PushConstants.positionScale.xyz;
+	v.normal = oct_decode(unpackSnorm4x8(d.y).zw);
+	vec2 uv = unpackHalf2x16(d.z);
+	v.uv_x = uv.x;
+	v.uv_y = uv.y;
+	v.color = unpackUnorm4x8(d.w);
+	return v;
+}
@@ -1,5 +1,14 @@
 #include "FileUtils.h"
 #include <sys/stat.h>
+#if defined (_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 bool fileExists(ccharp path){
 #if defined (_WIN32)
@@ -21,4 +30,72 @@ time_t fileTime(ccharp path){
     _stat(path, &fstat);
     return fstat.st_ctime;
 #endif        
-}
\ No newline at end of file
+}
+
+bool MappedFile::open(ccharp path){
+    close();
+#if defined (_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file == INVALID_HANDLE_VALUE){
+        return false;
+    }
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || size.QuadPart == 0){
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(mapping == nullptr){
+        CloseHandle(file);
+        return false;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(data == nullptr){
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    _file = file;
+    _mapping = mapping;
+    _data = (const u8*)data;
+    _size = (size_t)size.QuadPart;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    struct stat fstat;
+    if(::fstat(fd, &fstat) != 0 || fstat.st_size == 0){
+        ::close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, (size_t)fstat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    //the mapping keeps its own reference to the file
+    ::close(fd);
+    if(data == MAP_FAILED){
+        return false;
+    }
+    //everything gets read once front to back, start reading ahead now
+    madvise(data, (size_t)fstat.st_size, MADV_WILLNEED);
+    _data = (const u8*)data;
+    _size = (size_t)fstat.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close(){
+    if(_data == nullptr){
+        return;
+    }
+#if defined (_WIN32)
+    UnmapViewOfFile(_data);
+    CloseHandle(_mapping);
+    CloseHandle(_file);
+    _file = nullptr;
+    _mapping = nullptr;
+#else
+    munmap((void*)_data, _size);
+#endif
+    _data = nullptr;
+    _size = 0;
+}
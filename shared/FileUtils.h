@@ -2,4 +2,25 @@
 #include <vk_types.h>
 #include <ctime>
 bool fileExists(ccharp path);
-time_t fileTime(ccharp path);
\ No newline at end of file
+time_t fileTime(ccharp path);
+
+//read only mapping of a whole file, pages are read in by the os as they are touched
+class MappedFile{
+    const u8* _data{nullptr};
+    size_t _size{0};
+#if defined (_WIN32)
+    void* _file{nullptr};
+    void* _mapping{nullptr};
+#endif
+public:
+    MappedFile() = default;
+    ~MappedFile(){ close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(ccharp path);
+    void close();
+
+    const u8* data() const { return _data; }
+    size_t size() const { return _size; }
+};
@@ -0,0 +1,400 @@
+#include "accessors.h"
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ACCESSOR_SSE2 1
+#include <emmintrin.h>
+#else
+#define ACCESSOR_SSE2 0
+#endif
+
+namespace accessor{
+
+u32 component_size(ComponentType type){
+    switch(type){
+        case ComponentType::Byte:
+        case ComponentType::UnsignedByte:
+            return 1;
+        case ComponentType::Short:
+        case ComponentType::UnsignedShort:
+            return 2;
+        case ComponentType::UnsignedInt:
+        case ComponentType::Float:
+        default:
+            return 4;
+    }
+}
+
+View View::subrange(u32 first, u32 count) const{
+    View view = *this;
+    if(view.data != nullptr){
+        view.data += first * component_size(componentType);
+    }
+    view.components = count;
+    return view;
+}
+
+template<typename T>
+static T load(const u8* ptr){
+    T v;
+    memcpy(&v, ptr, sizeof(T));
+    return v;
+}
+
+static float* dst_at(float* dst, size_t dstStride, size_t i){
+    return (float*)((u8*)dst + i * dstStride);
+}
+
+//component c of the element at ptr as a float. normalized values multiply by the reciprocal like the
+//kernels do, so both paths give the same bits
+static float read_float(const u8* ptr, ComponentType type, bool normalized, u32 c){
+    switch(type){
+        case ComponentType::Float:
+            return load<float>(ptr + c * sizeof(float));
+        case ComponentType::UnsignedByte:{
+            u8 v = ptr[c];
+            return normalized ? v * (1.f / 255.f) : (float)v;
+        }
+        case ComponentType::Byte:{
+            i8 v = (i8)ptr[c];
+            return normalized ? std::max(v * (1.f / 127.f), -1.f) : (float)v;
+        }
+        case ComponentType::UnsignedShort:{
+            u16 v = load<u16>(ptr + c * sizeof(u16));
+            return normalized ? v * (1.f / 65535.f) : (float)v;
+        }
+        case ComponentType::Short:{
+            i16 v = load<i16>(ptr + c * sizeof(i16));
+            return normalized ? std::max(v * (1.f / 32767.f), -1.f) : (float)v;
+        }
+        case ComponentType::UnsignedInt:
+            return (float)load<u32>(ptr + c * sizeof(u32));
+        default:
+            return 0.f;
+    }
+}
+
+static u32 read_index(const u8* ptr, ComponentType type){
+    switch(type){
+        case ComponentType::UnsignedByte:
+            return ptr[0];
+        case ComponentType::UnsignedShort:
+            return load<u16>(ptr);
+        case ComponentType::UnsignedInt:
+            return load<u32>(ptr);
+        default:
+            return 0;
+    }
+}
+
+namespace scalar{
+
+void decode_floats(const View& view, float* dst, size_t dstStride){
+    for(size_t i = 0; i < view.count; ++i){
+        float* d = dst_at(dst, dstStride, i);
+        if(view.data == nullptr){
+            std::fill(d, d + view.components, 0.f);
+            continue;
+        }
+        const u8* ptr = view.data + i * view.stride;
+        for(u32 c = 0; c < view.components; ++c){
+            d[c] = read_float(ptr, view.componentType, view.normalized, c);
+        }
+    }
+}
+
+void decode_indices(const View& view, u32 base, u32* dst){
+    for(size_t i = 0; i < view.count; ++i){
+        dst[i] = (view.data == nullptr ? 0 : read_index(view.data + i * view.stride, view.componentType)) + base;
+    }
+}
+
+}
+
+//elements the sse2 loops may handle when every load is loadSize bytes. a load may run past the element
+//as long as it stays inside the next one, so the last element is always left to the scalar tail
+static size_t simd_count(size_t count, size_t srcStride, size_t elementSize, size_t loadSize){
+    if(count == 0 || srcStride + elementSize < loadSize){
+        return 0;
+    }
+    return count - 1;
+}
+
+#if ACCESSOR_SSE2
+//store the first C lanes of v
+template<u32 C>
+static void store_partial(float* d, __m128 v){
+    if constexpr(C == 1){
+        _mm_store_ss(d, v);
+    }else if constexpr(C == 2){
+        _mm_storel_pi((__m64*)d, v);
+    }else if constexpr(C == 3){
+        _mm_storel_pi((__m64*)d, v);
+        _mm_store_ss(d + 2, _mm_movehl_ps(v, v));
+    }else{
+        _mm_storeu_ps(d, v);
+    }
+}
+
+//convert the first n elements with convert(ptr) -> __m128, the component count is a template
+//parameter so the stores are picked outside of the loop
+template<typename F>
+static void simd_loop(size_t n, u32 components, const u8* src, size_t srcStride, float* dst, size_t dstStride, F&& convert){
+    auto run = [&]<u32 C>(){
+        for(size_t i = 0; i < n; ++i){
+            store_partial<C>(dst_at(dst, dstStride, i), convert(src + i * srcStride));
+        }
+    };
+    switch(components){
+        case 1: run.template operator()<1>(); break;
+        case 2: run.template operator()<2>(); break;
+        case 3: run.template operator()<3>(); break;
+        default: run.template operator()<4>(); break;
+    }
+}
+
+static __m128i load32(const u8* ptr){
+    return _mm_cvtsi32_si128(load<i32>(ptr));
+}
+#endif
+
+void gather_float3(const u8* src, size_t srcStride, size_t count, float* dst, size_t dstStride){
+    size_t i = 0;
+#if ACCESSOR_SSE2
+    i = simd_count(count, srcStride, 12, 16);
+    simd_loop(i, 3, src, srcStride, dst, dstStride, [](const u8* ptr){
+        return _mm_loadu_ps((const float*)ptr);
+    });
+#endif
+    for(; i < count; ++i){
+        memcpy(dst_at(dst, dstStride, i), src + i * srcStride, 12);
+    }
+}
+
+void unorm8_to_float(const u8* src, size_t srcStride, size_t count, u32 components, float* dst, size_t dstStride){
+    size_t i = 0;
+#if ACCESSOR_SSE2
+    const __m128 scale = _mm_set1_ps(1.f / 255.f);
+    const __m128i zero = _mm_setzero_si128();
+    i = simd_count(count, srcStride, components, 4);
+    simd_loop(i, components, src, srcStride, dst, dstStride, [&](const u8* ptr){
+        __m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(load32(ptr), zero), zero);
+        return _mm_mul_ps(_mm_cvtepi32_ps(v), scale);
+    });
+#endif
+    for(; i < count; ++i){
+        float* d = dst_at(dst, dstStride, i);
+        for(u32 c = 0; c < components; ++c){
+            d[c] = src[i * srcStride + c] * (1.f / 255.f);
+        }
+    }
+}
+
+void unorm16_to_float(const u8* src, size_t srcStride, size_t count, u32 components, float* dst, size_t dstStride){
+    size_t i = 0;
+#if ACCESSOR_SSE2
+    const __m128 scale = _mm_set1_ps(1.f / 65535.f);
+    const __m128i zero = _mm_setzero_si128();
+    bool wide = components > 2;
+    i = simd_count(count, srcStride, components * 2, wide ? 8 : 4);
+    simd_loop(i, components, src, srcStride, dst, dstStride, [&](const u8* ptr){
+        __m128i v = _mm_unpacklo_epi16(wide ? _mm_loadl_epi64((const __m128i*)ptr) : load32(ptr), zero);
+        return _mm_mul_ps(_mm_cvtepi32_ps(v), scale);
+    });
+#endif
+    for(; i < count; ++i){
+        float* d = dst_at(dst, dstStride, i);
+        for(u32 c = 0; c < components; ++c){
+            d[c] = load<u16>(src + i * srcStride + c * 2) * (1.f / 65535.f);
+        }
+    }
+}
+
+void snorm8_to_float(const u8* src, size_t srcStride, size_t count, u32 components, float* dst, size_t dstStride){
+    size_t i = 0;
+#if ACCESSOR_SSE2
+    const __m128 scale = _mm_set1_ps(1.f / 127.f);
+    const __m128 minusOne = _mm_set1_ps(-1.f);
+    i = simd_count(count, srcStride, components, 4);
+    simd_loop(i, components, src, srcStride, dst, dstStride, [&](const u8* ptr){
+        //sign extend by moving each byte to the top of its lane and shifting back down
+        __m128i v = load32(ptr);
+        v = _mm_unpacklo_epi8(v, v);
+        v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 24);
+        return _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(v), scale), minusOne);
+    });
+#endif
+    for(; i < count; ++i){
+        float* d = dst_at(dst, dstStride, i);
+        for(u32 c = 0; c < components; ++c){
+            d[c] = std::max((i8)src[i * srcStride + c] * (1.f / 127.f), -1.f);
+        }
+    }
+}
+
+void snorm16_to_float(const u8* src, size_t srcStride, size_t count, u32 components, float* dst, size_t dstStride){
+    size_t i = 0;
+#if ACCESSOR_SSE2
+    const __m128 scale = _mm_set1_ps(1.f / 32767.f);
+    const __m128 minusOne = _mm_set1_ps(-1.f);
+    bool wide = components > 2;
+    i = simd_count(count, srcStride, components * 2, wide ? 8 : 4);
+    simd_loop(i, components, src, srcStride, dst, dstStride, [&](const u8* ptr){
+        __m128i v = wide ? _mm_loadl_epi64((const __m128i*)ptr) : load32(ptr);
+        v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        return _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(v), scale), minusOne);
+    });
+#endif
+    for(; i < count; ++i){
+        float* d = dst_at(dst, dstStride, i);
+        for(u32 c = 0; c < components; ++c){
+            d[c] = std::max(load<i16>(src + i * srcStride + c * 2) * (1.f / 32767.f), -1.f);
+        }
+    }
+}
+
+void rgba8_to_float4(const u8* src, size_t srcStride, size_t count, float* dst, size_t dstStride){
+    size_t i = 0;
+#if ACCESSOR_SSE2
+    if(srcStride == 4){
+        //tightly packed, four colors per 16 byte load
+        const __m128 scale = _mm_set1_ps(1.f / 255.f);
+        const __m128i zero = _mm_setzero_si128();
+        for(; i + 4 <= count; i += 4){
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i * 4));
+            __m128i lo = _mm_unpacklo_epi8(v, zero);
+            __m128i hi = _mm_unpackhi_epi8(v, zero);
+            _mm_storeu_ps(dst_at(dst, dstStride, i), _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+            _mm_storeu_ps(dst_at(dst, dstStride, i + 1), _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+            _mm_storeu_ps(dst_at(dst, dstStride, i + 2), _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+            _mm_storeu_ps(dst_at(dst, dstStride, i + 3), _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+        }
+    }
+#endif
+    unorm8_to_float(src + i * srcStride, srcStride, count - i, 4, dst_at(dst, dstStride, i), dstStride);
+}
+
+void widen_u8(const u8* src, size_t count, u32 base, u32* dst){
+    size_t i = 0;
+#if ACCESSOR_SSE2
+    const __m128i b = _mm_set1_epi32((int)base);
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 16 <= count; i += 16){
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi32(_mm_unpacklo_epi16(lo, zero), b));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_add_epi32(_mm_unpackhi_epi16(lo, zero), b));
+        _mm_storeu_si128((__m128i*)(dst + i + 8), _mm_add_epi32(_mm_unpacklo_epi16(hi, zero), b));
+        _mm_storeu_si128((__m128i*)(dst + i + 12), _mm_add_epi32(_mm_unpackhi_epi16(hi, zero), b));
+    }
+#endif
+    for(; i < count; ++i){
+        dst[i] = src[i] + base;
+    }
+}
+
+void widen_u16(const u16* src, size_t count, u32 base, u32* dst){
+    size_t i = 0;
+#if ACCESSOR_SSE2
+    const __m128i b = _mm_set1_epi32((int)base);
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 8 <= count; i += 8){
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi32(_mm_unpacklo_epi16(v, zero), b));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_add_epi32(_mm_unpackhi_epi16(v, zero), b));
+    }
+#endif
+    for(; i < count; ++i){
+        dst[i] = src[i] + base;
+    }
+}
+
+void add_base(const u32* src, size_t count, u32 base, u32* dst){
+    size_t i = 0;
+#if ACCESSOR_SSE2
+    const __m128i b = _mm_set1_epi32((int)base);
+    for(; i + 4 <= count; i += 4){
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi32(v, b));
+    }
+#endif
+    for(; i < count; ++i){
+        dst[i] = src[i] + base;
+    }
+}
+
+void decode_floats(const View& view, float* dst, size_t dstStride){
+    if(view.data == nullptr || view.components == 0 || view.components > 4){
+        scalar::decode_floats(view, dst, dstStride);
+        return;
+    }
+    switch(view.componentType){
+        case ComponentType::Float:
+            if(view.components == 3){
+                gather_float3(view.data, view.stride, view.count, dst, dstStride);
+            }else{
+                for(size_t i = 0; i < view.count; ++i){
+                    memcpy(dst_at(dst, dstStride, i), view.data + i * view.stride, view.components * sizeof(float));
+                }
+            }
+            return;
+        case ComponentType::UnsignedByte:
+            if(!view.normalized){
+                break;
+            }
+            if(view.components == 4){
+                rgba8_to_float4(view.data, view.stride, view.count, dst, dstStride);
+            }else{
+                unorm8_to_float(view.data, view.stride, view.count, view.components, dst, dstStride);
+            }
+            return;
+        case ComponentType::UnsignedShort:
+            if(!view.normalized){
+                break;
+            }
+            unorm16_to_float(view.data, view.stride, view.count, view.components, dst, dstStride);
+            return;
+        case ComponentType::Byte:
+            if(!view.normalized){
+                break;
+            }
+            snorm8_to_float(view.data, view.stride, view.count, view.components, dst, dstStride);
+            return;
+        case ComponentType::Short:
+            if(!view.normalized){
+                break;
+            }
+            snorm16_to_float(view.data, view.stride, view.count, view.components, dst, dstStride);
+            return;
+        default:
+            break;
+    }
+    //plain integers, not worth a kernel
+    scalar::decode_floats(view, dst, dstStride);
+}
+
+void decode_indices(const View& view, u32 base, u32* dst){
+    //index buffer views are tightly packed, anything else goes the slow way
+    if(view.data == nullptr || view.stride != component_size(view.componentType)){
+        scalar::decode_indices(view, base, dst);
+        return;
+    }
+    switch(view.componentType){
+        case ComponentType::UnsignedByte:
+            widen_u8(view.data, view.count, base, dst);
+            return;
+        case ComponentType::UnsignedShort:
+            widen_u16((const u16*)view.data, view.count, base, dst);
+            return;
+        case ComponentType::UnsignedInt:
+            add_base((const u32*)view.data, view.count, base, dst);
+            return;
+        default:
+            scalar::decode_indices(view, base, dst);
+            return;
+    }
+}
+
+}
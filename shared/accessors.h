@@ -0,0 +1,59 @@
+#pragma once
+#include <vk_types.h>
+
+//decoding of glTF accessor data into engine arrays: strided reads, normalized integer types and index
+//widening, with sse2 kernels for the common conversions and scalar code for everything else.
+//destinations are strided too so attributes can be written straight into interleaved vertices
+namespace accessor{
+
+//component types, values as in the glTF spec
+enum class ComponentType : u32{
+    Byte = 5120,
+    UnsignedByte = 5121,
+    Short = 5122,
+    UnsignedShort = 5123,
+    UnsignedInt = 5125,
+    Float = 5126
+};
+
+u32 component_size(ComponentType type);
+
+//where the elements of an accessor live
+struct View{
+    //first component of the first element, null reads as zeros like an accessor without a buffer view
+    const u8* data{nullptr};
+    //bytes between elements
+    size_t stride{0};
+    size_t count{0};
+    ComponentType componentType{ComponentType::Float};
+    u32 components{1};
+    bool normalized{false};
+
+    //components [first, first + count) of every element, for attributes split across the destination
+    View subrange(u32 first, u32 count) const;
+};
+
+//write the view.components floats of every element to dst, dst + dstStride bytes, ...
+//normalized integers map to 0..1 or -1..1, other integers convert as they are
+void decode_floats(const View& view, float* dst, size_t dstStride);
+//decode an index accessor to u32 and add base to every index
+void decode_indices(const View& view, u32 base, u32* dst);
+
+//the kernels behind decode_floats/decode_indices, public for the microbenchmarks. strides in bytes
+void gather_float3(const u8* src, size_t srcStride, size_t count, float* dst, size_t dstStride);
+void unorm8_to_float(const u8* src, size_t srcStride, size_t count, u32 components, float* dst, size_t dstStride);
+void unorm16_to_float(const u8* src, size_t srcStride, size_t count, u32 components, float* dst, size_t dstStride);
+void snorm8_to_float(const u8* src, size_t srcStride, size_t count, u32 components, float* dst, size_t dstStride);
+void snorm16_to_float(const u8* src, size_t srcStride, size_t count, u32 components, float* dst, size_t dstStride);
+void rgba8_to_float4(const u8* src, size_t srcStride, size_t count, float* dst, size_t dstStride);
+void widen_u8(const u8* src, size_t count, u32 base, u32* dst);
+void widen_u16(const u16* src, size_t count, u32 base, u32* dst);
+void add_base(const u32* src, size_t count, u32 base, u32* dst);
+
+//one element at a time reference implementations, used for the odd formats and to check the kernels
+namespace scalar{
+void decode_floats(const View& view, float* dst, size_t dstStride);
+void decode_indices(const View& view, u32 base, u32* dst);
+}
+
+}
@@ -0,0 +1,91 @@
+#include "hash.h"
+#include <cstring>
+
+static constexpr u64 PRIME1 = 0x9E3779B185EBCA87ull;
+static constexpr u64 PRIME2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr u64 PRIME3 = 0x165667B19E3779F9ull;
+static constexpr u64 PRIME4 = 0x85EBCA77C2B2AE63ull;
+static constexpr u64 PRIME5 = 0x27D4EB2F165667C5ull;
+
+static u64 rotl(u64 x, int r){
+    return (x << r) | (x >> (64 - r));
+}
+
+//unaligned little endian reads, the input is any byte buffer
+static u64 read64(const u8* p){
+    u64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static u32 read32(const u8* p){
+    u32 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static u64 round(u64 acc, u64 input){
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+static u64 merge_round(u64 acc, u64 val){
+    acc ^= round(0, val);
+    return acc * PRIME1 + PRIME4;
+}
+
+u64 xxhash64(const void* data, size_t size, u64 seed){
+    const u8* p = (const u8*)data;
+    const u8* end = p + size;
+    u64 h;
+
+    if(size >= 32){
+        //four independent lanes over 32 byte stripes
+        u64 v1 = seed + PRIME1 + PRIME2;
+        u64 v2 = seed + PRIME2;
+        u64 v3 = seed;
+        u64 v4 = seed - PRIME1;
+        const u8* limit = end - 32;
+        do{
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        }while(p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge_round(h, v1);
+        h = merge_round(h, v2);
+        h = merge_round(h, v3);
+        h = merge_round(h, v4);
+    }else{
+        h = seed + PRIME5;
+    }
+    h += (u64)size;
+
+    //tail
+    while(p + 8 <= end){
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+        p += 8;
+    }
+    if(p + 4 <= end){
+        h ^= (u64)read32(p) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    while(p < end){
+        h ^= (*p) * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+        p++;
+    }
+
+    //avalanche
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <vk_types.h>
+
+//xxHash64 (Yann Collet), fast non cryptographic hash for content addressing. chain several buffers
+//by passing the previous result as the seed
+u64 xxhash64(const void* data, size_t size, u64 seed = 0);
+
+template<typename T>
+u64 xxhash64(std::span<const T> data, u64 seed = 0){
+    return xxhash64(data.data(), data.size_bytes(), seed);
+}
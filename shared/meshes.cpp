@@ -0,0 +1,655 @@
+#include "meshes.h"
+#include <glm/geometric.hpp>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+//smallest index and the number of vertices up to the largest one
+static void index_range(std::span<const u32> indices, u32& base, u32& range){
+    auto [lo, hi] = std::minmax_element(indices.begin(), indices.end());
+    base = *lo;
+    range = *hi - *lo + 1;
+}
+
+VertexCacheStats analyze_vertex_cache(std::span<const u32> indices, u32 cacheSize){
+    VertexCacheStats stats;
+    stats.triangles = (u32)(indices.size() / 3);
+    if(indices.empty()){
+        return stats;
+    }
+    u32 base, range;
+    index_range(indices, base, range);
+
+    //a vertex is cached while fewer than cacheSize others were transformed after it
+    std::vector<u32> cacheTime(range, 0);
+    u32 time = cacheSize + 1;
+    for(u32 index : indices){
+        u32 v = index - base;
+        if(cacheTime[v] == 0){
+            stats.vertices++;
+        }
+        if(time - cacheTime[v] > cacheSize){
+            cacheTime[v] = time++;
+            stats.transformed++;
+        }
+    }
+    return stats;
+}
+
+struct VertexHash{
+    size_t operator()(const Vertex& v) const{
+        //fnv-1a over the bytes, bit identical vertices only
+        const u8* bytes = (const u8*)&v;
+        u64 hash = 14695981039346656037ull;
+        for(size_t i = 0; i < sizeof(Vertex); ++i){
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return (size_t)hash;
+    }
+};
+
+struct VertexEqual{
+    bool operator()(const Vertex& a, const Vertex& b) const{
+        return memcmp(&a, &b, sizeof(Vertex)) == 0;
+    }
+};
+
+u32 deduplicate_vertices(std::vector<Vertex>& vertices, std::span<u32> indices){
+    std::unordered_map<Vertex, u32, VertexHash, VertexEqual> unique;
+    unique.reserve(vertices.size());
+    std::vector<u32> remap(vertices.size());
+    std::vector<Vertex> merged;
+    merged.reserve(vertices.size());
+    for(size_t i = 0; i < vertices.size(); ++i){
+        auto [it, inserted] = unique.try_emplace(vertices[i], (u32)merged.size());
+        if(inserted){
+            merged.push_back(vertices[i]);
+        }
+        remap[i] = it->second;
+    }
+    for(u32& index : indices){
+        index = remap[index];
+    }
+    u32 removed = (u32)(vertices.size() - merged.size());
+    vertices.swap(merged);
+    return removed;
+}
+
+void optimize_vertex_cache(std::span<u32> indices, u32 cacheSize){
+    size_t triangleCount = indices.size() / 3;
+    if(triangleCount < 2){
+        return;
+    }
+    u32 base, range;
+    index_range(indices, base, range);
+
+    //triangles around every vertex
+    std::vector<u32> offsets(range + 1, 0);
+    for(u32 index : indices){
+        offsets[index - base + 1]++;
+    }
+    for(u32 v = 0; v < range; ++v){
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<u32> adjacency(indices.size());
+    std::vector<u32> fill(offsets.begin(), offsets.end() - 1);
+    for(size_t i = 0; i < indices.size(); ++i){
+        adjacency[fill[indices[i] - base]++] = (u32)(i / 3);
+    }
+    //triangles of every vertex that are still to be emitted
+    std::vector<u32> live(range);
+    for(u32 v = 0; v < range; ++v){
+        live[v] = offsets[v + 1] - offsets[v];
+    }
+
+    std::vector<u32> cacheTime(range, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<u32> deadEnd;
+    std::vector<u32> candidates;
+    std::vector<u32> output;
+    output.reserve(indices.size());
+    u32 time = cacheSize + 1;
+    u32 cursor = 0;
+
+    //fan out every triangle around one vertex, then pick the next vertex to fan around
+    i64 fan = 0;
+    while(fan >= 0){
+        candidates.clear();
+        for(u32 a = offsets[fan]; a < offsets[fan + 1]; ++a){
+            u32 t = adjacency[a];
+            if(emitted[t]){
+                continue;
+            }
+            emitted[t] = true;
+            for(u32 k = 0; k < 3; ++k){
+                u32 v = indices[t * 3 + k] - base;
+                output.push_back(v + base);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if(time - cacheTime[v] > cacheSize){
+                    cacheTime[v] = time++;
+                }
+            }
+        }
+
+        //the candidate that will still be cached after its remaining triangles went out, oldest first
+        i64 next = -1;
+        i64 best = -1;
+        for(u32 v : candidates){
+            if(live[v] == 0){
+                continue;
+            }
+            i64 priority = 0;
+            if(time - cacheTime[v] + 2 * live[v] <= cacheSize){
+                priority = time - cacheTime[v];
+            }
+            if(priority > best){
+                best = priority;
+                next = v;
+            }
+        }
+        //dead end, go back to a recently used vertex, then to the next one in input order
+        while(next < 0 && !deadEnd.empty()){
+            u32 d = deadEnd.back();
+            deadEnd.pop_back();
+            if(live[d] > 0){
+                next = d;
+            }
+        }
+        while(next < 0 && cursor < range){
+            if(live[cursor] > 0){
+                next = cursor;
+            }
+            cursor++;
+        }
+        fan = next;
+    }
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void optimize_overdraw(std::span<u32> indices, std::span<const Vertex> vertices, vec3 center, u32 cacheSize, float threshold){
+    size_t triangleCount = indices.size() / 3;
+    if(triangleCount < 2){
+        return;
+    }
+    u32 base, range;
+    index_range(indices, base, range);
+    float limit = analyze_vertex_cache(indices, cacheSize).acmr() * threshold;
+
+    //a cluster ends as soon as its own acmr is back within the limit, so splitting costs little cache reuse
+    std::vector<u32> clusterStarts{0};
+    std::vector<u32> cacheTime(range, 0);
+    u32 time = cacheSize + 1;
+    u32 clusterMisses = 0;
+    for(u32 t = 0; t < (u32)triangleCount; ++t){
+        for(u32 k = 0; k < 3; ++k){
+            u32 v = indices[t * 3 + k] - base;
+            if(time - cacheTime[v] > cacheSize){
+                cacheTime[v] = time++;
+                clusterMisses++;
+            }
+        }
+        u32 clusterTriangles = t + 1 - clusterStarts.back();
+        if(t + 1 < triangleCount && (float)clusterMisses <= limit * clusterTriangles){
+            clusterStarts.push_back(t + 1);
+            clusterMisses = 0;
+            //every cluster is measured from an empty cache, it may be drawn after any other
+            time += cacheSize + 1;
+        }
+    }
+    if(clusterStarts.size() < 2){
+        return;
+    }
+    clusterStarts.push_back((u32)triangleCount);
+
+    //clusters facing away from the center are likely in front of the others
+    struct Cluster{
+        u32 first;
+        u32 count;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters;
+    clusters.reserve(clusterStarts.size() - 1);
+    for(size_t c = 0; c + 1 < clusterStarts.size(); ++c){
+        Cluster cluster{clusterStarts[c], clusterStarts[c + 1] - clusterStarts[c], 0.f};
+        vec3 centroid = vec3(0.f);
+        vec3 normal = vec3(0.f);
+        float area = 0.f;
+        for(u32 t = cluster.first; t < cluster.first + cluster.count; ++t){
+            vec3 p0 = vertices[indices[t * 3 + 0]].position;
+            vec3 p1 = vertices[indices[t * 3 + 1]].position;
+            vec3 p2 = vertices[indices[t * 3 + 2]].position;
+            //twice the area, pointing along the face normal
+            vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float a = glm::length(n);
+            centroid += (p0 + p1 + p2) * (a / 3.f);
+            normal += n;
+            area += a;
+        }
+        float normalLength = glm::length(normal);
+        if(area > 0.f && normalLength > 0.f){
+            cluster.sortKey = glm::dot(centroid / area - center, normal / normalLength);
+        }
+        clusters.push_back(cluster);
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b){
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<u32> sorted;
+    sorted.reserve(indices.size());
+    for(const Cluster& cluster : clusters){
+        sorted.insert(sorted.end(), indices.begin() + cluster.first * 3, indices.begin() + (cluster.first + cluster.count) * 3);
+    }
+    std::copy(sorted.begin(), sorted.end(), indices.begin());
+}
+
+void optimize_vertex_fetch(std::vector<Vertex>& vertices, std::span<u32> indices){
+    std::vector<u32> remap(vertices.size(), UINT32_MAX);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for(u32& index : indices){
+        if(remap[index] == UINT32_MAX){
+            remap[index] = (u32)ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+}
+
+//squared distance to a weighted set of planes, error(p) = p'Ap + 2b'p + c
+struct Quadric{
+    double a00{0}, a01{0}, a02{0}, a11{0}, a12{0}, a22{0};
+    double b0{0}, b1{0}, b2{0};
+    double c{0};
+    //sum of the plane weights, the error is divided by it
+    double w{0};
+
+    void add_plane(vec3 n, float d, double weight){
+        a00 += weight * n.x * n.x; a01 += weight * n.x * n.y; a02 += weight * n.x * n.z;
+        a11 += weight * n.y * n.y; a12 += weight * n.y * n.z; a22 += weight * n.z * n.z;
+        b0 += weight * n.x * d; b1 += weight * n.y * d; b2 += weight * n.z * d;
+        c += weight * d * d;
+        w += weight;
+    }
+
+    Quadric& operator+=(const Quadric& o){
+        a00 += o.a00; a01 += o.a01; a02 += o.a02; a11 += o.a11; a12 += o.a12; a22 += o.a22;
+        b0 += o.b0; b1 += o.b1; b2 += o.b2;
+        c += o.c;
+        w += o.w;
+        return *this;
+    }
+
+    //mean squared distance of p to the planes
+    double error(vec3 p) const{
+        double x = p.x, y = p.y, z = p.z;
+        double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+            2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return w > 0.0 ? std::max(e, 0.0) / w : 0.0;
+    }
+};
+
+std::vector<u32> simplify(std::span<const u32> indices, std::span<const Vertex> vertices, size_t targetIndexCount, float targetError,
+    const SimplifyWeights& weights, float* resultError){
+    if(resultError){
+        *resultError = 0.f;
+    }
+    size_t indexCount = indices.size() - indices.size() % 3;
+    if(indexCount <= targetIndexCount){
+        return std::vector<u32>(indices.begin(), indices.begin() + indexCount);
+    }
+
+    //work on a compact copy of the referenced vertices
+    std::vector<u32> globalIds;
+    std::unordered_map<u32, u32> localIds;
+    std::vector<u32> result(indexCount);
+    for(size_t i = 0; i < indexCount; ++i){
+        auto [it, inserted] = localIds.try_emplace(indices[i], (u32)globalIds.size());
+        if(inserted){
+            globalIds.push_back(indices[i]);
+        }
+        result[i] = it->second;
+    }
+    const u32 vertexCount = (u32)globalIds.size();
+    auto vertex = [&](u32 local) -> const Vertex& { return vertices[globalIds[local]]; };
+
+    //vertices on the same position belong to one class, seams are classes of several vertices
+    std::vector<u32> positionClass(vertexCount);
+    std::vector<u32> classSize;
+    {
+        std::unordered_map<u64, std::vector<u32>> collisions;
+        for(u32 v = 0; v < vertexCount; ++v){
+            vec3 p = vertex(v).position;
+            u32 bits[3];
+            memcpy(bits, &p, sizeof(bits));
+            u64 hash = ((u64)bits[0] * 73856093ull) ^ ((u64)bits[1] * 19349663ull << 16) ^ ((u64)bits[2] * 83492791ull << 32);
+            //the hash only narrows the search, compare the actual positions
+            std::vector<u32>& bucket = collisions[hash];
+            u32 found = UINT32_MAX;
+            for(u32 other : bucket){
+                if(memcmp(&vertex(other).position, &p, sizeof(vec3)) == 0){
+                    found = positionClass[other];
+                    break;
+                }
+            }
+            if(found == UINT32_MAX){
+                found = (u32)classSize.size();
+                classSize.push_back(0);
+                bucket.push_back(v);
+            }
+            positionClass[v] = found;
+            classSize[found]++;
+        }
+    }
+
+    //edges used by one triangle are borders, edges used by more than two are non manifold
+    std::vector<u8> locked(vertexCount, 0);
+    {
+        std::unordered_map<u64, u32> edgeUse;
+        for(size_t t = 0; t < indexCount; t += 3){
+            for(u32 k = 0; k < 3; ++k){
+                u32 a = positionClass[result[t + k]];
+                u32 b = positionClass[result[t + (k + 1) % 3]];
+                edgeUse[((u64)std::min(a, b) << 32) | std::max(a, b)]++;
+            }
+        }
+        std::vector<u8> classLocked(classSize.size(), 0);
+        for(auto& [edge, count] : edgeUse){
+            if(count != 2){
+                classLocked[edge >> 32] = 1;
+                classLocked[edge & 0xffffffffu] = 1;
+            }
+        }
+        for(u32 v = 0; v < vertexCount; ++v){
+            locked[v] = classLocked[positionClass[v]] || classSize[positionClass[v]] > 1;
+        }
+    }
+
+    //plane quadrics of the triangles around every vertex, weighted by area
+    std::vector<Quadric> quadrics(vertexCount);
+    for(size_t t = 0; t < indexCount; t += 3){
+        vec3 p0 = vertex(result[t]).position;
+        vec3 n = glm::cross(vertex(result[t + 1]).position - p0, vertex(result[t + 2]).position - p0);
+        float length = glm::length(n);
+        if(length <= 0.f){
+            continue;
+        }
+        n = n / length;
+        float d = -glm::dot(n, p0);
+        for(u32 k = 0; k < 3; ++k){
+            quadrics[result[t + k]].add_plane(n, d, length * 0.5f);
+        }
+    }
+    //attribute differences are unitless, the collapsed edge brings them to squared model units
+    auto cost = [&](u32 from, u32 to){
+        const Vertex& a = vertex(from);
+        const Vertex& b = vertex(to);
+        vec3 dn = a.normal - b.normal;
+        float du = a.uv_x - b.uv_x;
+        float dv = a.uv_y - b.uv_y;
+        vec3 edge = a.position - b.position;
+        double attributes = (weights.normal * glm::dot(dn, dn) + weights.uv * (du * du + dv * dv)) * glm::dot(edge, edge);
+        return quadrics[from].error(b.position) + attributes;
+    };
+
+    //moving from onto to must not turn any remaining triangle around from over
+    std::vector<u32> adjacencyOffsets;
+    std::vector<u32> adjacency;
+    auto flips = [&](u32 from, u32 to){
+        vec3 target = vertex(to).position;
+        for(u32 a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; ++a){
+            const u32* tri = &result[adjacency[a] * 3];
+            if(tri[0] == to || tri[1] == to || tri[2] == to){
+                continue;
+            }
+            vec3 p[3];
+            vec3 moved[3];
+            for(u32 k = 0; k < 3; ++k){
+                p[k] = vertex(tri[k]).position;
+                moved[k] = tri[k] == from ? target : p[k];
+            }
+            vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+            if(glm::dot(before, after) < 0.25f * glm::length(before) * glm::length(after)){
+                return true;
+            }
+        }
+        return false;
+    };
+
+    struct Collapse{
+        u32 from;
+        u32 to;
+        double cost;
+    };
+    std::vector<Collapse> collapses;
+    std::vector<u32> remap(vertexCount);
+    std::vector<u8> touched(vertexCount);
+    double errorLimit = (double)targetError * targetError;
+    double maxError = 0.0;
+
+    //each pass collapses the cheapest independent edges, then rebuilds the index list
+    while(result.size() > targetIndexCount){
+        size_t triangleCount = result.size() / 3;
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for(u32 v : result){
+            adjacencyOffsets[v + 1]++;
+        }
+        for(u32 v = 0; v < vertexCount; ++v){
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+        adjacency.resize(result.size());
+        std::vector<u32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for(size_t i = 0; i < result.size(); ++i){
+            adjacency[fill[result[i]]++] = (u32)(i / 3);
+        }
+
+        collapses.clear();
+        for(size_t i = 0; i < result.size(); ++i){
+            u32 a = result[i];
+            u32 b = result[i - i % 3 + (i % 3 + 1) % 3];
+            if(!locked[a]){
+                collapses.push_back({a, b, cost(a, b)});
+            }
+            if(!locked[b]){
+                collapses.push_back({b, a, cost(b, a)});
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y){ return x.cost < y.cost; });
+
+        for(u32 v = 0; v < vertexCount; ++v){
+            remap[v] = v;
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t remaining = triangleCount;
+        u32 collapsed = 0;
+        for(const Collapse& c : collapses){
+            if(c.cost > errorLimit || remaining * 3 <= targetIndexCount){
+                break;
+            }
+            if(touched[c.from] || touched[c.to] || flips(c.from, c.to)){
+                continue;
+            }
+            remap[c.from] = c.to;
+            quadrics[c.to] += quadrics[c.from];
+            maxError = std::max(maxError, c.cost);
+            collapsed++;
+            //every triangle around from changes, keep its vertices out of this pass
+            for(u32 a = adjacencyOffsets[c.from]; a < adjacencyOffsets[c.from + 1]; ++a){
+                const u32* tri = &result[adjacency[a] * 3];
+                for(u32 k = 0; k < 3; ++k){
+                    touched[tri[k]] = 1;
+                }
+                if(tri[0] == c.to || tri[1] == c.to || tri[2] == c.to){
+                    remaining--;
+                }
+            }
+        }
+        if(collapsed == 0){
+            break;
+        }
+
+        size_t write = 0;
+        for(size_t t = 0; t < result.size(); t += 3){
+            u32 a = remap[result[t]];
+            u32 b = remap[result[t + 1]];
+            u32 c = remap[result[t + 2]];
+            if(a != b && b != c && a != c){
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+        }
+        result.resize(write);
+    }
+
+    for(u32& v : result){
+        v = globalIds[v];
+    }
+    if(resultError){
+        *resultError = (float)std::sqrt(maxError);
+    }
+    return result;
+}
+
+//octahedral projection of a unit vector, the lower half folded over the diagonals
+static void encode_octahedral(vec3 n, i8 out[2]){
+    float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    vec2 p = sum > 0.f ? vec2(n.x, n.y) / sum : vec2(0.f);
+    if(sum > 0.f && n.z < 0.f){
+        vec2 folded = vec2(1.f - std::abs(p.y), 1.f - std::abs(p.x));
+        p = vec2(p.x >= 0.f ? folded.x : -folded.x, p.y >= 0.f ? folded.y : -folded.y);
+    }
+    out[0] = (i8)std::round(glm::clamp(p.x, -1.f, 1.f) * 127.f);
+    out[1] = (i8)std::round(glm::clamp(p.y, -1.f, 1.f) * 127.f);
+}
+
+std::vector<PackedVertex> pack_vertices(std::span<const Vertex> vertices, vec3 offset, vec3 scale){
+    //flat axes have a zero scale, everything lands on 0 there
+    vec3 invScale = vec3(scale.x > 0.f ? 1.f / scale.x : 0.f, scale.y > 0.f ? 1.f / scale.y : 0.f, scale.z > 0.f ? 1.f / scale.z : 0.f);
+    std::vector<PackedVertex> packed(vertices.size());
+    for(size_t i = 0; i < vertices.size(); ++i){
+        const Vertex& v = vertices[i];
+        PackedVertex& p = packed[i];
+        vec3 q = glm::clamp((v.position - offset) * invScale, vec3(0.f), vec3(1.f));
+        for(u32 c = 0; c < 3; ++c){
+            p.position[c] = (u16)std::round(q[c] * 65535.f);
+        }
+        encode_octahedral(v.normal, p.normal);
+        p.uv[0] = glm::packHalf1x16(v.uv_x);
+        p.uv[1] = glm::packHalf1x16(v.uv_y);
+        for(u32 c = 0; c < 4; ++c){
+            p.color[c] = (u8)std::round(glm::clamp(v.color[c], 0.f, 1.f) * 255.f);
+        }
+    }
+    return packed;
+}
+
+//bounding sphere and normal cone of one meshlet, the cone as in meshoptimizer's meshopt_computeMeshletBounds
+static Meshlet meshlet_bounds(std::span<const u32> indices, std::span<const u32> used, std::span<const Vertex> vertices, u32 firstIndex){
+    Meshlet meshlet{};
+    meshlet.firstIndex = firstIndex;
+    meshlet.indexCount = (u32)indices.size();
+
+    //sphere around the box center, loose but cheap
+    vec3 minpos = vertices[used[0]].position;
+    vec3 maxpos = minpos;
+    for(u32 v : used){
+        minpos = glm::min(minpos, vertices[v].position);
+        maxpos = glm::max(maxpos, vertices[v].position);
+    }
+    meshlet.center = (minpos + maxpos) * 0.5f;
+    float radius2 = 0.f;
+    for(u32 v : used){
+        vec3 d = vertices[v].position - meshlet.center;
+        radius2 = std::max(radius2, glm::dot(d, d));
+    }
+    meshlet.radius = std::sqrt(radius2);
+
+    //no cone unless every triangle normal is within ~84 degrees of the average
+    meshlet.coneApex = meshlet.center;
+    meshlet.coneAxis = vec3(0.f, 0.f, 1.f);
+    meshlet.coneCutoff = 1.f;
+
+    //unit normal of every triangle, zero for degenerate ones
+    std::vector<vec3> normals(indices.size() / 3, vec3(0.f));
+    vec3 sum(0.f);
+    for(size_t t = 0; t < normals.size(); ++t){
+        vec3 p0 = vertices[indices[t * 3]].position;
+        vec3 n = glm::cross(vertices[indices[t * 3 + 1]].position - p0, vertices[indices[t * 3 + 2]].position - p0);
+        float length = glm::length(n);
+        if(length > 0.f){
+            normals[t] = n / length;
+            sum += normals[t];
+        }
+    }
+    float sumLength = glm::length(sum);
+    if(sumLength <= 0.f){
+        return meshlet;
+    }
+    vec3 axis = sum / sumLength;
+    float mindp = 1.f;
+    for(const vec3& n : normals){
+        if(n != vec3(0.f)){
+            mindp = std::min(mindp, glm::dot(n, axis));
+        }
+    }
+    if(mindp <= 0.1f){
+        return meshlet;
+    }
+    //move the apex back until it is behind every triangle plane
+    float maxt = 0.f;
+    for(size_t t = 0; t < normals.size(); ++t){
+        if(normals[t] != vec3(0.f)){
+            vec3 p0 = vertices[indices[t * 3]].position;
+            maxt = std::max(maxt, glm::dot(meshlet.center - p0, normals[t]) / glm::dot(axis, normals[t]));
+        }
+    }
+    meshlet.coneApex = meshlet.center - axis * maxt;
+    meshlet.coneAxis = axis;
+    meshlet.coneCutoff = std::sqrt(1.f - mindp * mindp);
+    return meshlet;
+}
+
+std::vector<Meshlet> build_meshlets(std::span<const u32> indices, u32 firstIndex, std::span<const Vertex> vertices, u32 maxVertices, u32 maxTriangles){
+    std::vector<Meshlet> meshlets;
+    size_t indexCount = indices.size() - indices.size() % 3;
+    if(indexCount == 0){
+        return meshlets;
+    }
+    //meshlet that last used each vertex, tells whether the current one already counts it
+    std::vector<u32> owner(vertices.size(), UINT32_MAX);
+    std::vector<u32> used;
+    used.reserve(maxVertices);
+    size_t start = 0;
+    auto finish = [&](size_t end){
+        meshlets.push_back(meshlet_bounds(indices.subspan(start, end - start), used, vertices, firstIndex + (u32)start));
+        used.clear();
+        start = end;
+    };
+    for(size_t t = 0; t < indexCount; t += 3){
+        u32 current = (u32)meshlets.size();
+        u32 added = 0;
+        for(u32 k = 0; k < 3; ++k){
+            added += owner[indices[t + k]] != current;
+        }
+        if(used.size() + added > maxVertices || (t - start) / 3 >= maxTriangles){
+            finish(t);
+            current = (u32)meshlets.size();
+        }
+        for(u32 k = 0; k < 3; ++k){
+            u32 v = indices[t + k];
+            if(owner[v] != current){
+                owner[v] = current;
+                used.push_back(v);
+            }
+        }
+    }
+    finish(indexCount);
+    return meshlets;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vk_types.h>
+
+//import time optimization of indexed triangle lists. the index lists may be a slice of a bigger
+//mesh, index values don't need to start at 0
+
+//result of running an index buffer through a simulated fifo post-transform cache
+struct VertexCacheStats{
+    u32 transformed{0};
+    u32 triangles{0};
+    //distinct vertices referenced
+    u32 vertices{0};
+
+    //average cache miss ratio, transformed vertices per triangle: 0.5 is ideal, 3 is no reuse at all
+    float acmr() const { return triangles ? (float)transformed / triangles : 0.f; }
+    //average transform to vertex ratio: 1 is ideal
+    float atvr() const { return vertices ? (float)transformed / vertices : 0.f; }
+
+    VertexCacheStats& operator+=(const VertexCacheStats& other){
+        transformed += other.transformed;
+        triangles += other.triangles;
+        vertices += other.vertices;
+        return *this;
+    }
+};
+
+VertexCacheStats analyze_vertex_cache(std::span<const u32> indices, u32 cacheSize = 16);
+
+//merge bit identical vertices and point the indices at the survivors, returns the removed count
+u32 deduplicate_vertices(std::vector<Vertex>& vertices, std::span<u32> indices);
+
+//reorder triangles for post-transform cache hits, tipsify (Sander et al. 2007)
+void optimize_vertex_cache(std::span<u32> indices, u32 cacheSize = 16);
+
+//split the cache ordered triangles into clusters whose acmr stays within threshold of the whole list
+//and draw the clusters facing away from center first, so they occlude the rest (Sander et al. 2007)
+void optimize_overdraw(std::span<u32> indices, std::span<const Vertex> vertices, vec3 center, u32 cacheSize = 16, float threshold = 1.05f);
+
+//renumber vertices in first use order so vertex fetches walk memory forward, drops unreferenced vertices
+void optimize_vertex_fetch(std::vector<Vertex>& vertices, std::span<u32> indices);
+
+//how much attribute changes count against a collapse, next to the geometric error. scaled by the
+//squared length of the collapsed edge so the weights do not depend on the model units
+struct SimplifyWeights{
+    float normal{0.5f};
+    float uv{1.f};
+};
+
+//quadric error edge collapse (Garland and Heckbert 1997) down to targetIndexCount indices or until the next
+//collapse would cost more than targetError. vertices only move onto a neighbour, so the result indexes the
+//same vertex array. seam vertices (a position shared by several vertices) and open borders stay in place.
+//resultError gets the largest error taken, a distance in model units
+std::vector<u32> simplify(std::span<const u32> indices, std::span<const Vertex> vertices, size_t targetIndexCount, float targetError,
+    const SimplifyWeights& weights = {}, float* resultError = nullptr);
+
+//quantize positions to unorm16 inside offset..offset+scale, which should cover every vertex
+std::vector<PackedVertex> pack_vertices(std::span<const Vertex> vertices, vec3 offset, vec3 scale);
+
+//cluster of consecutive triangles of a surface, culled on the gpu as a unit. the layout matches
+//shaders/meshlet_cull.comp
+struct Meshlet{
+    vec3 center;        //bounding sphere
+    float radius;
+    //every triangle faces away from cameras inside the cone that opens from the apex along the axis
+    vec3 coneApex;
+    float coneCutoff;   //cos of the cone half angle, 1 when the normals spread too far to cull
+    vec3 coneAxis;
+    u32 firstIndex;     //into the mesh index buffer
+    u32 indexCount;
+    u32 pad[3];
+};
+
+static_assert(sizeof(Meshlet) == 64);
+
+//split an index list into meshlets of at most maxVertices distinct vertices and maxTriangles triangles.
+//triangles keep their order, so every meshlet is a range of the list starting at firstIndex
+std::vector<Meshlet> build_meshlets(std::span<const u32> indices, u32 firstIndex, std::span<const Vertex> vertices, u32 maxVertices = 64, u32 maxTriangles = 124);
@@ -0,0 +1,106 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+void ThreadPool::init(u32 threadCount){
+    if(threadCount == 0){
+        u32 hw = std::thread::hardware_concurrency();
+        threadCount = hw > 1 ? hw - 1 : 1;
+    }
+    stopping = false;
+    for(u32 i = 0; i < threadCount; ++i){
+        workers.emplace_back([this](){ worker_loop(); });
+    }
+}
+
+void ThreadPool::shutdown(){
+    if(workers.empty()){
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for(auto& t : workers){
+        t.join();
+    }
+    workers.clear();
+}
+
+void ThreadPool::worker_loop(){
+    while(true){
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this](){ return stopping || !jobs.empty(); });
+            //drain the queue before stopping so nothing that was pushed gets lost
+            if(jobs.empty()){
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            busy++;
+        }
+        job();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy--;
+            if(busy == 0 && jobs.empty()){
+                idle.notify_all();
+            }
+        }
+    }
+}
+
+void ThreadPool::push(std::function<void()>&& job){
+    if(workers.empty()){
+        //no workers, run inline
+        job();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wakeup.notify_one();
+}
+
+void ThreadPool::parallel_for(u32 count, const std::function<void(u32)>& fn){
+    if(count == 0){
+        return;
+    }
+    //shared with the helper jobs, which may start after this call already returned
+    struct State{
+        std::atomic<u32> next{0};
+        std::atomic<u32> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto state = std::make_shared<State>();
+    const std::function<void(u32)>* body = &fn;
+
+    auto run = [state, body, count](){
+        u32 i;
+        while((i = state->next.fetch_add(1)) < count){
+            (*body)(i);
+            if(state->done.fetch_add(1) + 1 == count){
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    u32 helpers = std::min(count, size()) > 0 ? std::min(count, size()) - 1 : 0;
+    for(u32 i = 0; i < helpers; ++i){
+        push(run);
+    }
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&](){ return state->done.load() == count; });
+}
+
+void ThreadPool::wait_idle(){
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this](){ return busy == 0 && jobs.empty(); });
+}
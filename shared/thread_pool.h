@@ -0,0 +1,48 @@
+#pragma once
+#include <vk_types.h>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+//fixed set of worker threads pulling jobs from one queue
+class ThreadPool{
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable idle;
+    u32 busy{0};
+    bool stopping{false};
+
+    void worker_loop();
+
+public:
+    //0 picks one thread per hardware thread, leaving one for the main thread
+    void init(u32 threadCount = 0);
+    //waits for queued jobs to finish and joins the workers
+    void shutdown();
+    ~ThreadPool(){ shutdown(); }
+
+    u32 size() const { return (u32)workers.size(); }
+
+    void push(std::function<void()>&& job);
+
+    template<typename F>
+    auto enqueue(F&& f) -> std::future<std::invoke_result_t<F>>{
+        using R = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> result = task->get_future();
+        push([task](){ (*task)(); });
+        return result;
+    }
+
+    //runs fn(i) for every i in [0, count). the calling thread takes part, so it is safe
+    //to call from inside a job even when every worker is busy
+    void parallel_for(u32 count, const std::function<void(u32)>& fn);
+
+    //blocks until the queue is empty and no job is running
+    void wait_idle();
+};
@@ -1,10 +1,10 @@
 #include <vk_descriptors.h>
 
-void DescriptorLayoutBuilder::add_binding(u32 binding, VkDescriptorType type){
+void DescriptorLayoutBuilder::add_binding(u32 binding, VkDescriptorType type, u32 count){
     VkDescriptorSetLayoutBinding newbind{};
     newbind.binding = binding;
     newbind.descriptorType = type;
-    newbind.descriptorCount = 1;
+    newbind.descriptorCount = count;
     bindings.push_back(newbind);
 }
 
@@ -160,6 +160,37 @@ VkDescriptorSet DescriptorAllocatorGrowable::allocate(VkDevice device, VkDescrip
     return ds;
 }
 
+void DescriptorAllocatorPerThread::init(VkDevice device, u32 sets, std::span<DescriptorAllocatorGrowable::PoolSizeRatio> poolRatios){
+    ratios.assign(poolRatios.begin(), poolRatios.end());
+    initialSets = sets;
+    local(device);
+}
+
+void DescriptorAllocatorPerThread::clear_pools(VkDevice device){
+    std::lock_guard lock(mutex);
+    for(auto& [thread, allocator] : allocators){
+        allocator->clear_pools(device);
+    }
+}
+
+void DescriptorAllocatorPerThread::destroy_pools(VkDevice device){
+    std::lock_guard lock(mutex);
+    for(auto& [thread, allocator] : allocators){
+        allocator->destroy_pools(device);
+    }
+    allocators.clear();
+}
+
+DescriptorAllocatorGrowable& DescriptorAllocatorPerThread::local(VkDevice device){
+    std::lock_guard lock(mutex);
+    std::unique_ptr<DescriptorAllocatorGrowable>& allocator = allocators[std::this_thread::get_id()];
+    if(!allocator){
+        allocator = std::make_unique<DescriptorAllocatorGrowable>();
+        allocator->init(device, initialSets, ratios);
+    }
+    return *allocator;
+}
+
 void DescriptorWriter::write_buffer(i32 binding, VkBuffer buffer, size_t size, size_t offset, VkDescriptorType type){
     VkDescriptorBufferInfo& info = bufferInfos.emplace_back(VkDescriptorBufferInfo{
         buffer,
@@ -1,11 +1,14 @@
 #pragma once
 #include <vk_types.h>
 #include <vulkan/vulkan.h>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 struct DescriptorLayoutBuilder{
     std::vector<VkDescriptorSetLayoutBinding> bindings;
 
-    void add_binding(u32 binding, VkDescriptorType type);
+    void add_binding(u32 binding, VkDescriptorType type, u32 count = 1);
     void clear();
     VkDescriptorSetLayout build(VkDevice device, VkShaderStageFlags shaderStages, void*pNext = nullptr, VkDescriptorSetLayoutCreateFlagBits flags=(VkDescriptorSetLayoutCreateFlagBits)0);
 };
@@ -49,6 +52,29 @@ public:
     VkDescriptorSet allocate(VkDevice device, VkDescriptorSetLayout layout, void*pNext=nullptr);
 };
 
+//a DescriptorAllocatorGrowable for every thread that allocates, created on its first allocation, so
+//workers never share a pool. the owner (a scene, a frame) clears or destroys all of them at once, while
+//no thread is allocating
+class DescriptorAllocatorPerThread{
+    std::vector<DescriptorAllocatorGrowable::PoolSizeRatio> ratios;
+    u32 initialSets{0};
+    //only guards the lookup, each allocator is used by its own thread alone
+    std::mutex mutex;
+    std::unordered_map<std::thread::id, std::unique_ptr<DescriptorAllocatorGrowable>> allocators;
+
+public:
+    //initialSets is per thread, the calling thread gets its pool right away
+    void init(VkDevice device, u32 initialSets, std::span<DescriptorAllocatorGrowable::PoolSizeRatio> poolRatios);
+    void clear_pools(VkDevice device);
+    void destroy_pools(VkDevice device);
+
+    //the allocator of the calling thread
+    DescriptorAllocatorGrowable& local(VkDevice device);
+    VkDescriptorSet allocate(VkDevice device, VkDescriptorSetLayout layout, void*pNext=nullptr){
+        return local(device).allocate(device, layout, pNext);
+    }
+};
+
 struct DescriptorWriter{
     std::deque<VkDescriptorImageInfo> imageInfos;
     std::deque<VkDescriptorBufferInfo> bufferInfos;
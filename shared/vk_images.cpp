@@ -1,11 +1,123 @@
 #include <vk_images.h>
 #include <vk_initializers.h>
+#include <cassert>
 
 //#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 namespace vkutil{
 
+    static ImageState state_for(ImageUse use){
+        switch(use){
+            case ImageUse::ComputeWrite:
+                return {VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT};
+            case ImageUse::ColorAttachment:
+                return {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT};
+            case ImageUse::DepthAttachment:
+                return {VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT};
+            case ImageUse::TransferSrc:
+                return {VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT};
+            case ImageUse::TransferDst:
+                return {VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT};
+            case ImageUse::ShaderRead:
+                return {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_2_SHADER_SAMPLED_READ_BIT};
+            case ImageUse::Present:
+            default:
+                //the semaphore signalled after the submit orders presentation
+                return {VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE};
+        }
+    }
+
+    //access bits that write, only those need to be made available
+    constexpr VkAccessFlags2 WRITE_ACCESS = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_WRITE_BIT |
+        VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT;
+
+    BarrierBuilder::Tracked& BarrierBuilder::find(VkImage image){
+        for(auto& t : images){
+            if(t.image == image){
+                return t;
+            }
+        }
+        assert(!"image is not tracked");
+        return images.front();
+    }
+
+    void BarrierBuilder::track(VkImage image, VkImageAspectFlags aspect, ImageState state){
+        for(auto& t : images){
+            if(t.image == image){
+                t.aspect = aspect;
+                t.state = state;
+                return;
+            }
+        }
+        images.push_back({image, aspect, state});
+    }
+
+    void BarrierBuilder::forget(VkImage image){
+        std::erase_if(images, [&](const Tracked& t){ return t.image == image; });
+    }
+
+    void BarrierBuilder::use(VkImage image, ImageUse use, bool discard){
+        Tracked& tracked = find(image);
+        ImageState next = state_for(use);
+        VkImageLayout oldLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : tracked.state.layout;
+
+        //an earlier transition of this image is still queued, retarget it instead of adding a second one
+        for(auto& b : pending){
+            if(b.image == image){
+                b.newLayout = next.layout;
+                b.dstStageMask = next.stage;
+                b.dstAccessMask = next.access;
+                if(discard){
+                    b.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                }
+                tracked.state = next;
+                return;
+            }
+        }
+
+        bool layoutChange = oldLayout != next.layout || discard;
+        bool hazard = (tracked.state.access & WRITE_ACCESS) || (next.access & WRITE_ACCESS);
+        if(!layoutChange && !hazard){
+            //read after read, nothing to wait for
+            tracked.state.stage |= next.stage;
+            tracked.state.access |= next.access;
+            return;
+        }
+
+        VkImageMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+        barrier.srcStageMask = tracked.state.stage;
+        //reads only need the execution dependency
+        barrier.srcAccessMask = tracked.state.access & WRITE_ACCESS;
+        barrier.dstStageMask = next.stage;
+        barrier.dstAccessMask = next.access;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = next.layout;
+        barrier.image = image;
+        barrier.subresourceRange = vkinit::image_subresource_range(tracked.aspect);
+        pending.push_back(barrier);
+
+        tracked.state = next;
+    }
+
+    void BarrierBuilder::flush(VkCommandBuffer cmd){
+        if(pending.empty()){
+            return;
+        }
+        VkDependencyInfo depInfo{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+        depInfo.imageMemoryBarrierCount = (u32)pending.size();
+        depInfo.pImageMemoryBarriers = pending.data();
+        vkCmdPipelineBarrier2(cmd, &depInfo);
+
+        barrierCount += (u32)pending.size();
+        flushCount++;
+        pending.clear();
+    }
+
 
     void transition_image(VkCommandBuffer cmd, VkImage image, VkImageLayout currentLayout, VkImageLayout newLayout){
         VkImageMemoryBarrier2 imageBarrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
@@ -60,14 +172,15 @@ namespace vkutil{
         i32 mipLevels = i32(std::floor(std::log2(std::max(imageSize.width,imageSize.height))))+1;
         for(i32 mip = 0; mip < mipLevels; ++mip){
             VkExtent2D halfSize = imageSize;
-            halfSize.width /= 2;
-            halfSize.height /= 2;
+            halfSize.width = std::max(1u, halfSize.width / 2);
+            halfSize.height = std::max(1u, halfSize.height / 2);
 
+            //only the level that was just written has to be waited on, and only by the next blit
             VkImageMemoryBarrier2 imageBarrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
-            imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
-            imageBarrier.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
-            imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
-            imageBarrier.dstAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT;
+            imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+            imageBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+            imageBarrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
 
             imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
             imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
@@ -114,6 +227,61 @@ namespace vkutil{
                 imageSize = halfSize;
             }
         }
-        transition_image(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        VkImageMemoryBarrier2 imageBarrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+        imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+        imageBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+        imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        imageBarrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageBarrier.subresourceRange = vkinit::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT);
+        imageBarrier.image = image;
+
+        VkDependencyInfo depInfo{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+        depInfo.imageMemoryBarrierCount = 1;
+        depInfo.pImageMemoryBarriers = &imageBarrier;
+
+        vkCmdPipelineBarrier2(cmd, &depInfo);
+    }
+
+    FormatBlock format_block(VkFormat format){
+        switch(format){
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+                return {1, 1, 4};
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+            case VK_FORMAT_BC4_SNORM_BLOCK:
+                return {4, 4, 8};
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            case VK_FORMAT_BC5_SNORM_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return {4, 4, 16};
+            default:
+                return {};
+        }
+    }
+
+    bool is_block_compressed(VkFormat format){
+        return format_block(format).width > 1;
+    }
+
+    u32 mip_level_count(u32 width, u32 height){
+        return static_cast<u32>(std::floor(std::log2(std::max(width, height))))+1;
+    }
+
+    size_t image_level_size(VkFormat format, u32 width, u32 height, u32 level){
+        FormatBlock block = format_block(format);
+        u32 w = std::max(1u, width >> level);
+        u32 h = std::max(1u, height >> level);
+        return (size_t)((w + block.width - 1) / block.width) * ((h + block.height - 1) / block.height) * block.bytes;
     }
 }
\ No newline at end of file
@@ -1,10 +1,72 @@
 #pragma once
-#include <vulkan/vulkan.h>
+#include <vk_types.h>
 
 namespace vkutil{
+    //what an image is about to be used for, each maps to one layout, stage and access mask
+    enum class ImageUse : u8{
+        ComputeWrite,
+        ColorAttachment,
+        DepthAttachment,
+        TransferSrc,
+        TransferDst,
+        ShaderRead,
+        Present
+    };
+
+    //where an image was last used
+    struct ImageState{
+        VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+        VkPipelineStageFlags2 stage{VK_PIPELINE_STAGE_2_NONE};
+        VkAccessFlags2 access{VK_ACCESS_2_NONE};
+    };
+
+    //tracks the state of every image handed to it and turns "use it like this next" into
+    //the narrowest barrier that does the job. transitions are collected and recorded
+    //together by flush(), reads after reads in the same layout need no barrier at all
+    class BarrierBuilder{
+        struct Tracked{
+            VkImage image;
+            VkImageAspectFlags aspect;
+            ImageState state;
+        };
+        std::vector<Tracked> images;
+        std::vector<VkImageMemoryBarrier2> pending;
+
+        Tracked& find(VkImage image);
+
+    public:
+        //start (or restart) tracking an image in a known state
+        void track(VkImage image, VkImageAspectFlags aspect, ImageState state = {});
+        void forget(VkImage image);
+
+        //queue the transition for the next use. discard drops the contents on the way
+        void use(VkImage image, ImageUse use, bool discard = false);
+
+        //record every queued transition in one vkCmdPipelineBarrier2
+        void flush(VkCommandBuffer cmd);
+
+        //number of barriers recorded by flush since the last call, for the stats
+        u32 barrierCount{0};
+        u32 flushCount{0};
+    };
+
     void transition_image(VkCommandBuffer cmd, VkImage image, VkImageLayout currentLayout, VkImageLayout newLayout);
 
     void copy_image_to_image(VkCommandBuffer cmd, VkImage src, VkImage dst, VkExtent2D srcSize, VkExtent2D dstSize);
 
-    void generate_mipmap(VkCommandBuffer cmd, VkImage image, VkExtent2D imageSize);
+    //blit chain, expects every level in TRANSFER_DST_OPTIMAL and leaves them in SHADER_READ_ONLY_OPTIMAL
+    void generate_mipmaps(VkCommandBuffer cmd, VkImage image, VkExtent2D imageSize);
+
+    //texel block of a format, 1x1 for uncompressed ones. bytes is 0 for formats the loaders don't handle
+    struct FormatBlock{
+        u32 width{1};
+        u32 height{1};
+        u32 bytes{0};
+    };
+    FormatBlock format_block(VkFormat format);
+    bool is_block_compressed(VkFormat format);
+    //levels of a full chain down to 1x1
+    u32 mip_level_count(u32 width, u32 height);
+    //bytes of one tightly packed level of a width x height image, partial blocks on the edges count as whole ones
+    size_t image_level_size(VkFormat format, u32 width, u32 height, u32 level);
 }
\ No newline at end of file
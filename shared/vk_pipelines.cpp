@@ -23,6 +23,42 @@
 #pragma comment(lib,"../ThirdParty/glslang/SPIRV/DEBUG/SPIRVd.lib")
 #endif
 
+//resolves #include "file" next to the file that includes it
+class ShaderIncluder : public glslang::TShader::Includer {
+public:
+	IncludeResult* includeLocal(const char* headerName, const char* includerName, size_t inclusionDepth) override {
+		std::string path = headerName;
+		std::string includer = includerName;
+		size_t slash = includer.find_last_of("/\\");
+		if (slash != std::string::npos)
+			path = includer.substr(0, slash + 1) + headerName;
+		FILE* fp;
+		fopen_s(&fp, path.c_str(), "rb");
+		if (!fp)
+			return nullptr;
+		fseek(fp, 0, SEEK_END);
+		size_t fileSize = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		char* content = new char[fileSize];
+		bool ok = fread(content, 1, fileSize, fp) == fileSize;
+		fclose(fp);
+		if (!ok) {
+			delete[] content;
+			return nullptr;
+		}
+		return new IncludeResult(path, content, fileSize, content);
+	}
+	IncludeResult* includeSystem(const char* headerName, const char* includerName, size_t inclusionDepth) override {
+		return includeLocal(headerName, includerName, inclusionDepth);
+	}
+	void releaseInclude(IncludeResult* result) override {
+		if (result) {
+			delete[] (char*)result->userData;
+			delete result;
+		}
+	}
+};
+
 //https://lxjk.github.io/2020/03/10/Translate-GLSL-to-SPIRV-for-Vulkan-at-Runtime.html
 struct SpirvHelper
 {
@@ -157,7 +193,7 @@ struct SpirvHelper
 		}
 	}
 
-	static bool GLSLtoSPV(const VkShaderStageFlagBits shader_type, const char* pshader, std::vector<u32>& spirv, bool isVulkan) {
+	static bool GLSLtoSPV(const VkShaderStageFlagBits shader_type, const char* pshader, std::vector<u32>& spirv, bool isVulkan, const char* sourceName) {
 
 		EShLanguage stage = FindLanguage(shader_type);
 		glslang::TShader shader(stage);
@@ -174,13 +210,16 @@ struct SpirvHelper
 			messages = (EShMessages)(EShMsgSpvRules );
 
 		shaderStrings[0] = pshader;
-		shader.setStrings(shaderStrings, 1);
+		//the name is where #include "file" is resolved from
+		const char* shaderNames[1] = { sourceName };
+		shader.setStringsWithLengthsAndNames(shaderStrings, nullptr, shaderNames, 1);
+		ShaderIncluder includer;
 		glslang::EShClient client = isVulkan ? glslang::EShClient::EShClientVulkan : glslang::EShClient::EShClientOpenGL;
 		glslang::EshTargetClientVersion version =  glslang::EshTargetClientVersion::EShTargetVulkan_1_2;
 		shader.setEnvInput(glslang::EShSource::EShSourceGlsl, stage, client, 100);
 		shader.setEnvClient(client, version);
 		shader.setEnvTarget(glslang::EShTargetLanguage::EShTargetSpv, glslang::EShTargetLanguageVersion::EShTargetSpv_1_0);
-		if (!shader.parse(&Resources, 100, false, messages)) {
+		if (!shader.parse(&Resources, 100, false, messages, includer)) {
 			std::string info = shader.getInfoLog();
 			if (info.substr(0, 6) == "ERROR:") {
 				std::string remainder = info.substr(7, info.length() - 7);
@@ -245,7 +284,7 @@ class ShaderCompiler {
 public:
 	ShaderCompiler();
 	~ShaderCompiler();
-	std::vector<uint32_t> compileShader(const char* shaderSrc, VkShaderStageFlagBits shaderStage, bool isVulkan=true);
+	std::vector<uint32_t> compileShader(const char* shaderSrc, VkShaderStageFlagBits shaderStage, bool isVulkan=true, const char* sourceName="");
 };
 
 
@@ -257,10 +296,10 @@ ShaderCompiler::~ShaderCompiler()
 {
 	SpirvHelper::Finalize();
 }
-std::vector<u32> ShaderCompiler::compileShader(const char* shaderSrc, VkShaderStageFlagBits shaderStage,bool isVulkan)
+std::vector<u32> ShaderCompiler::compileShader(const char* shaderSrc, VkShaderStageFlagBits shaderStage,bool isVulkan, const char* sourceName)
 {
 	std::vector<u32> spirv;
-	SpirvHelper::GLSLtoSPV(shaderStage, shaderSrc, spirv,isVulkan);
+	SpirvHelper::GLSLtoSPV(shaderStage, shaderSrc, spirv,isVulkan,sourceName);
 	return spirv;
 }
 
@@ -280,7 +319,7 @@ namespace vkutil{
 
             if(ok){
                 ShaderCompiler compiler;
-                auto spirv = compiler.compileShader((ccharp)buffer.data(),stage,true);
+                auto spirv = compiler.compileShader((ccharp)buffer.data(),stage,true,filePath);
 
                 if(spirv.size()==0){
                     return false;
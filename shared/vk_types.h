@@ -40,6 +40,11 @@ using ccharp = const char *;
 
 //we'll add our main reusable types here
 
+//handed back by asynchronous uploads, the data is usable once the upload timeline reaches value
+struct UploadTicket{
+    u64 value{0};
+};
+
 struct AllocatedImage{
     VkImage image{VK_NULL_HANDLE};
     VkImageView imageView{VK_NULL_HANDLE};
@@ -47,6 +52,7 @@ struct AllocatedImage{
     VmaAllocationInfo allocationInfo{};//might be useful?
     VkExtent3D imageExtent{};
     VkFormat imageFormat{VK_FORMAT_UNDEFINED};
+    UploadTicket uploadTicket;
 };
 
 struct AllocatedBuffer{
@@ -87,9 +93,14 @@ struct MaterialPipeline{
 
 struct MaterialInstance{
     MaterialPipeline* pipeline;
+    //VK_NULL_HANDLE for bindless materials
     VkDescriptorSet materialSet;
     MaterialPass passType;
-
+    //index into the bindless material table, UINT32_MAX for materials with their own set
+    u32 bindlessIndex{UINT32_MAX};
+    //scale (xy) and offset (zw) of the tile in the atlas its color texture was packed into, per draw
+    //so materials differing only by tile can share a set
+    vec4 uvTransform{1.f, 1.f, 0.f, 0.f};
 };
 
 //vbuf types
@@ -101,19 +112,54 @@ struct Vertex{
     vec4 color;
 };
 
+//quantized vertex, decoded in mesh.vert. position is unorm16 inside the mesh bounds, the normal
+//octahedral snorm8, uvs half floats and the color unorm8
+struct PackedVertex{
+    u16 position[3];
+    i8 normal[2];
+    u16 uv[2];
+    u8 color[4];
+};
+
+static_assert(sizeof(PackedVertex) == 16);
+
+enum class VertexFormat : u32{
+    Full,       //Vertex
+    Packed      //PackedVertex
+};
+
 //holds the resources needed for a mesh
 struct GPUMeshBuffers{
     AllocatedBuffer indexBuffer;
     AllocatedBuffer vertexBuffer;
     VkDeviceAddress vertexBufferAddress;
+    UploadTicket uploadTicket;
+    //16 bit for meshes with at most 65536 vertices
+    VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+    VertexFormat vertexFormat{VertexFormat::Full};
+    //packed positions are positionOffset + unorm16 * positionScale
+    vec3 positionOffset{0.f};
+    vec3 positionScale{1.f};
+    //Meshlet records of the surfaces, null when the mesh has none
+    AllocatedBuffer meshletBuffer{};
+    VkDeviceAddress meshletBufferAddress{0};
 };
 
 //push constants for our mesh object draws
 struct GPUDrawPushConstants{
     mat4 worldMatrix;
     VkDeviceAddress vertexBuffer;
+    VertexFormat vertexFormat;
+    //material of the draw in the bindless material table
+    u32 materialIndex;
+    vec4 positionOffset;
+    vec4 positionScale;
+    //MaterialInstance::uvTransform, the whole 128 bytes every device supports are used now
+    vec4 uvTransform;
 };
 
+static_assert(sizeof(GPUDrawPushConstants) == 128);
+
 //node types
 struct DrawContext;
 